@@ -0,0 +1,66 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include "aggregate-tree.h"
+
+using namespace std;
+
+double msSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// Sums random key windows with aggregate() and by iterating over them, and
+// measures what keeping the aggregates costs on insert.
+int main(int argc, char* argv[])
+{
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    size_t queries = argc > 2 ? strtoul(argv[2], NULL, 10) : 2000;
+    long long window = argc > 3 ? atoll(argv[3]) : (long long)n / 10;
+
+    mt19937_64 rng(34);
+    vector<long long> keys(n);
+    for (size_t i = 0; i < n; ++i) keys[i] = (long long)(rng() % (n * 4));
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    AVLTree<long long,long long> plain;
+    for (size_t i = 0; i < n; ++i) plain.insert(make_pair(keys[i], (long long)i));
+    double plainMs = msSince(start);
+
+    start = chrono::steady_clock::now();
+    AggregateAVLTree<long long,long long,SumOf<long long> > summed;
+    for (size_t i = 0; i < n; ++i) summed.insert(make_pair(keys[i], (long long)i));
+    double summedMs = msSince(start);
+
+    vector<long long> los(queries);
+    for (size_t q = 0; q < queries; ++q) los[q] = (long long)(rng() % (n * 4));
+
+    //the base tree has no lower bound, so the scan walks a std::map copy
+    map<long long,long long> ordered;
+    for (size_t i = 0; i < n; ++i) ordered[keys[i]] = (long long)i;
+    start = chrono::steady_clock::now();
+    long long scanTotal = 0;
+    for (size_t q = 0; q < queries; ++q) {
+        map<long long,long long>::const_iterator it = ordered.lower_bound(los[q]);
+        for (; it != ordered.end() && it->first <= los[q] + window; ++it) scanTotal += it->second;
+    }
+    double scanMs = msSince(start);
+
+    start = chrono::steady_clock::now();
+    long long aggTotal = 0;
+    for (size_t q = 0; q < queries; ++q) aggTotal += summed.aggregate(los[q], los[q] + window);
+    double aggMs = msSince(start);
+
+    cout << n << " entries, " << queries << " windows of " << window << " keys" << endl;
+    cout << fixed << setprecision(1);
+    cout << "insert, plain AVLTree:      " << plainMs << " ms" << endl;
+    cout << "insert, with sums:          " << summedMs << " ms" << endl;
+    cout << "window sums by scanning:    " << scanMs << " ms" << endl;
+    cout << "window sums by aggregate(): " << aggMs << " ms" << endl;
+    if (scanTotal != aggTotal) cout << "(totals differ: scan " << scanTotal << " vs " << aggTotal << ")" << endl;
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include <iostream>
+#include <string>
+#include <map>
+#include <vector>
+#include <cstdlib>
+#include "aggregate-tree.h"
+#include "test-util.h"
+
+using namespace std;
+
+// Concatenates values in key order; not commutative, so it catches any
+// aggregate that combines children in the wrong order.
+struct ConcatOf {
+    typedef string type;
+    static string identity() { return string(); }
+    static string combine(const string& a, const string& b) { return a + b; }
+    template<class Key>
+    static string of(const Key&, char value) { return string(1, value); }
+};
+
+template<class Monoid, class Ref>
+typename Monoid::type scan(const Ref& ref, int lo, int hi)
+{
+    typename Monoid::type acc = Monoid::identity();
+    for (typename Ref::const_iterator it = ref.lower_bound(lo); it != ref.end() && it->first <= hi; ++it) {
+        acc = Monoid::combine(acc, Monoid::of(it->first, it->second));
+    }
+    return acc;
+}
+
+int main()
+{
+    AggregateAVLTree<int,long,SumOf<long> > sums;
+    AggregateAVLTree<int,long,MinOf<long> > mins;
+    AggregateAVLTree<int,long,MaxOf<long> > maxes;
+    AggregateAVLTree<int,long,CountOf> counts;
+    map<int,long> ref;
+
+    srand(34);
+    bool agree = true;
+    for (int step = 0; step < 20000; ++step) {
+        int key = rand() % 2000;
+        if (rand() % 3 == 0) {
+            sums.remove(key);
+            mins.remove(key);
+            maxes.remove(key);
+            counts.remove(key);
+            ref.erase(key);
+        }
+        else {
+            long value = rand() % 10000 - 5000;
+            sums.insert(make_pair(key, value));
+            mins.insert(make_pair(key, value));
+            maxes.insert(make_pair(key, value));
+            counts.insert(make_pair(key, value));
+            ref[key] = value;
+        }
+        if (step % 50 == 0) {
+            int lo = rand() % 2100 - 50;
+            int hi = lo + rand() % 800;
+            agree = agree && sums.aggregate(lo, hi) == scan<SumOf<long> >(ref, lo, hi)
+                && mins.aggregate(lo, hi) == scan<MinOf<long> >(ref, lo, hi)
+                && maxes.aggregate(lo, hi) == scan<MaxOf<long> >(ref, lo, hi)
+                && counts.aggregate(lo, hi) == scan<CountOf>(ref, lo, hi);
+        }
+    }
+    check(agree, "sum, min, max and count match a scan under random updates");
+    check(sums.total() == scan<SumOf<long> >(ref, -1, 3000) && counts.total() == ref.size(), "total covers the whole tree");
+    check(sums.isBalanced(), "tree stays balanced");
+    check(sums.aggregate(10, 5) == 0 && counts.aggregate(5000, 6000) == 0, "empty ranges give the identity");
+
+    AggregateAVLTree<int,char,ConcatOf> letters;
+    map<int,char> letterRef;
+    for (int i = 0; i < 26; ++i) {
+        int key = (i * 11) % 26;
+        letters.insert(make_pair(key, (char)('a' + key)));
+        letterRef[key] = (char)('a' + key);
+    }
+    letters.remove(3);
+    letterRef.erase(3);
+    check(letters.total() == "abcefghijklmnopqrstuvwxyz", "non-commutative aggregates keep key order");
+    check(letters.aggregate(2, 7) == scan<ConcatOf>(letterRef, 2, 7), "partial ranges keep key order");
+
+    // bulkLoad fills in aggregates as it builds
+    vector<pair<int,long> > sorted;
+    for (int i = 0; i < 1000; ++i) sorted.push_back(make_pair(i, (long)i));
+    AggregateAVLTree<int,long,SumOf<long> > loaded;
+    loaded.bulkLoad(sorted.begin(), sorted.end());
+    check(loaded.total() == 499500 && loaded.aggregate(100, 199) == 14950, "bulkLoad computes aggregates");
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,271 @@
+#ifndef AGGREGATE_TREE_H
+#define AGGREGATE_TREE_H
+
+#include <cstddef>
+#include <limits>
+#include <algorithm>
+#include "avlbst.h"
+
+/**
+* Monoids for AggregateAVLTree. A monoid names its aggregate type as type and
+* provides three static functions:
+*
+*   identity()     the aggregate of no items
+*   combine(a, b)  the aggregate of a's items followed by b's; must be
+*                  associative, but need not be commutative
+*   of(key, value) the aggregate of a single item
+*/
+template <typename T>
+struct SumOf {
+    typedef T type;
+    static T identity() { return T(); }
+    static T combine(const T& a, const T& b) { return a + b; }
+    template<class Key, class Value>
+    static T of(const Key&, const Value& value) { return value; }
+};
+
+template <typename T>
+struct MinOf {
+    typedef T type;
+    static T identity() { return std::numeric_limits<T>::max(); }
+    static T combine(const T& a, const T& b) { return std::min(a, b); }
+    template<class Key, class Value>
+    static T of(const Key&, const Value& value) { return value; }
+};
+
+template <typename T>
+struct MaxOf {
+    typedef T type;
+    static T identity() { return std::numeric_limits<T>::lowest(); }
+    static T combine(const T& a, const T& b) { return std::max(a, b); }
+    template<class Key, class Value>
+    static T of(const Key&, const Value& value) { return value; }
+};
+
+struct CountOf {
+    typedef size_t type;
+    static size_t identity() { return 0; }
+    static size_t combine(size_t a, size_t b) { return a + b; }
+    template<class Key, class Value>
+    static size_t of(const Key&, const Value&) { return 1; }
+};
+
+/**
+* Reads an item count out of an aggregate where the monoid keeps one, so a
+* tree over CountOf can be split by rank.
+*/
+template <typename Monoid>
+struct ItemCount {
+    static bool of(const typename Monoid::type&, size_t&) { return false; }
+};
+
+template <>
+struct ItemCount<CountOf> {
+    static bool of(size_t aggregate, size_t& count) { count = aggregate; return true; }
+};
+
+/**
+* An AVL node that also stores the aggregate of its whole subtree.
+*/
+template <typename Key, typename Value, typename Monoid>
+class AggregateNode : public AVLNode<Key, Value>
+{
+public:
+    AggregateNode(const Key& key, const Value& value, AVLNode<Key, Value>* parent);
+    virtual ~AggregateNode();
+
+    const typename Monoid::type& getAggregate() const;
+    void setAggregate(const typename Monoid::type& aggregate);
+
+protected:
+    typename Monoid::type aggregate_;
+};
+
+/*
+  -------------------------------------------------
+  Begin implementations for the AggregateNode class.
+  -------------------------------------------------
+*/
+
+template<class Key, class Value, class Monoid>
+AggregateNode<Key, Value, Monoid>::AggregateNode(const Key& key, const Value& value, AVLNode<Key, Value>* parent) :
+    AVLNode<Key, Value>(key, value, parent), aggregate_(Monoid::of(key, value))
+{
+
+}
+
+template<class Key, class Value, class Monoid>
+AggregateNode<Key, Value, Monoid>::~AggregateNode()
+{
+
+}
+
+template<class Key, class Value, class Monoid>
+const typename Monoid::type& AggregateNode<Key, Value, Monoid>::getAggregate() const
+{
+    return aggregate_;
+}
+
+template<class Key, class Value, class Monoid>
+void AggregateNode<Key, Value, Monoid>::setAggregate(const typename Monoid::type& aggregate)
+{
+    aggregate_ = aggregate;
+}
+
+/*
+  -----------------------------------------------
+  End implementations for the AggregateNode class.
+  -----------------------------------------------
+*/
+
+/**
+* An AVLTree that keeps a Monoid aggregate in every node, so the aggregate of
+* any key range is answered by two root-to-leaf descents instead of a scan.
+* Aggregates are refreshed through the AVLTree augmentation hooks, which
+* insert, remove, nodeSwap and both rotations already drive.
+*
+* Values must only be changed through insert; writing through an iterator
+* would leave the stored aggregates stale. For the same reason only the
+* const operator[] is available.
+*/
+template <typename Key, typename Value, typename Monoid>
+class AggregateAVLTree : public AVLTree<Key, Value>
+{
+public:
+    typedef typename Monoid::type Aggregate;
+
+    virtual ~AggregateAVLTree();
+
+    // Aggregate of every item with lo <= key <= hi, in key order.
+    Aggregate aggregate(const Key& lo, const Key& hi) const;
+    // Aggregate of the whole tree.
+    Aggregate total() const;
+
+    Value const & operator[](const Key& key) const;
+
+protected:
+    typedef AggregateNode<Key, Value, Monoid> ANode;
+
+    virtual AVLNode<Key, Value>* createNode(const Key& key, const Value& value, AVLNode<Key, Value>* parent);
+    virtual void updateNode(AVLNode<Key, Value>* n);
+    virtual void updatePath(AVLNode<Key, Value>* n);
+    virtual bool subtreeSize(Node<Key, Value>* n, size_t& size) const;
+
+    static Aggregate of(const AVLNode<Key, Value>* n);
+    static Aggregate aggregateFrom(const AVLNode<Key, Value>* n, const Key& lo);
+    static Aggregate aggregateTo(const AVLNode<Key, Value>* n, const Key& hi);
+};
+
+/*
+  -------------------------------------------------
+  Begin implementations for the AggregateAVLTree class.
+  -------------------------------------------------
+*/
+
+template<class Key, class Value, class Monoid>
+AggregateAVLTree<Key, Value, Monoid>::~AggregateAVLTree()
+{
+
+}
+
+template<class Key, class Value, class Monoid>
+AVLNode<Key, Value>* AggregateAVLTree<Key, Value, Monoid>::createNode(const Key& key, const Value& value, AVLNode<Key, Value>* parent)
+{
+    return new ANode(key, value, parent);
+}
+
+/**
+* Aggregate of the subtree at n, or the identity for an empty subtree.
+*/
+template<class Key, class Value, class Monoid>
+typename AggregateAVLTree<Key, Value, Monoid>::Aggregate AggregateAVLTree<Key, Value, Monoid>::of(const AVLNode<Key, Value>* n)
+{
+    return n == NULL ? Monoid::identity() : static_cast<const ANode*>(n)->getAggregate();
+}
+
+template<class Key, class Value, class Monoid>
+bool AggregateAVLTree<Key, Value, Monoid>::subtreeSize(Node<Key, Value>* n, size_t& size) const
+{
+    return ItemCount<Monoid>::of(of(static_cast<AVLNode<Key, Value>*>(n)), size);
+}
+
+template<class Key, class Value, class Monoid>
+void AggregateAVLTree<Key, Value, Monoid>::updateNode(AVLNode<Key, Value>* n)
+{
+    Aggregate self = Monoid::of(n->getKey(), n->getValue());
+    static_cast<ANode*>(n)->setAggregate(
+        Monoid::combine(Monoid::combine(of(n->getLeft()), self), of(n->getRight())));
+}
+
+template<class Key, class Value, class Monoid>
+void AggregateAVLTree<Key, Value, Monoid>::updatePath(AVLNode<Key, Value>* n)
+{
+    for (; n != NULL; n = n->getParent()) updateNode(n);
+}
+
+/**
+* Aggregate of the items in the subtree at n with key >= lo. Only one child
+* is descended into at each level; the other is covered by its stored total.
+*/
+template<class Key, class Value, class Monoid>
+typename AggregateAVLTree<Key, Value, Monoid>::Aggregate
+AggregateAVLTree<Key, Value, Monoid>::aggregateFrom(const AVLNode<Key, Value>* n, const Key& lo)
+{
+    if (n == NULL) return Monoid::identity();
+    if (n->getKey() < lo) return aggregateFrom(n->getRight(), lo);
+    Aggregate self = Monoid::of(n->getKey(), n->getValue());
+    return Monoid::combine(Monoid::combine(aggregateFrom(n->getLeft(), lo), self), of(n->getRight()));
+}
+
+/**
+* Aggregate of the items in the subtree at n with key <= hi.
+*/
+template<class Key, class Value, class Monoid>
+typename AggregateAVLTree<Key, Value, Monoid>::Aggregate
+AggregateAVLTree<Key, Value, Monoid>::aggregateTo(const AVLNode<Key, Value>* n, const Key& hi)
+{
+    if (n == NULL) return Monoid::identity();
+    if (hi < n->getKey()) return aggregateTo(n->getLeft(), hi);
+    Aggregate self = Monoid::of(n->getKey(), n->getValue());
+    return Monoid::combine(Monoid::combine(of(n->getLeft()), self), aggregateTo(n->getRight(), hi));
+}
+
+/**
+* Descends to the first node inside [lo, hi]; everything in range lies in its
+* subtree, split between its left side (bounded by lo) and its right side
+* (bounded by hi).
+*/
+template<class Key, class Value, class Monoid>
+typename AggregateAVLTree<Key, Value, Monoid>::Aggregate
+AggregateAVLTree<Key, Value, Monoid>::aggregate(const Key& lo, const Key& hi) const
+{
+    const AVLNode<Key, Value>* n = static_cast<const AVLNode<Key, Value>*>(this->root_);
+    while (n != NULL) {
+        if (n->getKey() < lo) n = n->getRight();
+        else if (hi < n->getKey()) n = n->getLeft();
+        else break;
+    }
+    if (n == NULL) return Monoid::identity();
+    Aggregate self = Monoid::of(n->getKey(), n->getValue());
+    return Monoid::combine(Monoid::combine(aggregateFrom(n->getLeft(), lo), self), aggregateTo(n->getRight(), hi));
+}
+
+template<class Key, class Value, class Monoid>
+typename AggregateAVLTree<Key, Value, Monoid>::Aggregate AggregateAVLTree<Key, Value, Monoid>::total() const
+{
+    return of(static_cast<const AVLNode<Key, Value>*>(this->root_));
+}
+
+template<class Key, class Value, class Monoid>
+Value const & AggregateAVLTree<Key, Value, Monoid>::operator[](const Key& key) const
+{
+    return BinarySearchTree<Key, Value>::operator[](key);
+}
+
+/*
+  -----------------------------------------------
+  End implementations for the AggregateAVLTree class.
+  -----------------------------------------------
+*/
+
+#endif
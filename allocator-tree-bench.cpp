@@ -0,0 +1,74 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <memory_resource>
+#include "allocator-tree.h"
+
+using namespace std;
+
+double msSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// Request-scoped trees: each request builds a small tree, looks things up
+// and throws it away. Heap nodes are compared with nodes carved out of a
+// monotonic buffer that is rewound after every request.
+template<class Tree>
+long long serve(Tree& tree, const vector<int>& keys, size_t begin, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) tree.insert(make_pair(keys[begin + i], (int)i));
+    long long sum = 0;
+    for (size_t i = 0; i < count; ++i) {
+        typename Tree::iterator it = tree.find(keys[begin + (i * 7) % count]);
+        if (it != tree.end()) sum += it->second;
+    }
+    return sum;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t requests = argc > 1 ? strtoul(argv[1], NULL, 10) : 20000;
+    size_t perRequest = argc > 2 ? strtoul(argv[2], NULL, 10) : 200;
+
+    mt19937 rng(42);
+    vector<int> keys(requests * perRequest);
+    for (size_t i = 0; i < keys.size(); ++i) keys[i] = (int)rng();
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    long long heapSum = 0;
+    for (size_t r = 0; r < requests; ++r) {
+        AVLTree<int,int> tree;
+        heapSum += serve(tree, keys, r * perRequest, perRequest);
+    }
+    double heapMs = msSince(start);
+
+    start = chrono::steady_clock::now();
+    long long allocSum = 0;
+    for (size_t r = 0; r < requests; ++r) {
+        AllocatorAVLTree<int,int> tree;
+        allocSum += serve(tree, keys, r * perRequest, perRequest);
+    }
+    double allocMs = msSince(start);
+
+    vector<char> buffer(perRequest * 128 + 4096);
+    start = chrono::steady_clock::now();
+    long long pmrSum = 0;
+    for (size_t r = 0; r < requests; ++r) {
+        std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size());
+        PmrAVLTree<int,int> tree(&arena);
+        pmrSum += serve(tree, keys, r * perRequest, perRequest);
+    }
+    double pmrMs = msSince(start);
+
+    cout << requests << " requests of " << perRequest << " items" << endl;
+    cout << fixed << setprecision(1);
+    cout << "AVLTree (new/delete):        " << heapMs << " ms" << endl;
+    cout << "AllocatorAVLTree<std::alloc>: " << allocMs << " ms" << endl;
+    cout << "PmrAVLTree (monotonic):      " << pmrMs << " ms" << endl;
+    if (heapSum != allocSum || heapSum != pmrSum) cout << "(results differ)" << endl;
+    return 0;
+}
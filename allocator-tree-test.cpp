@@ -0,0 +1,115 @@
+#include <iostream>
+#include <map>
+#include <cstdlib>
+#include <cstddef>
+#include <new>
+#include "allocator-tree.h"
+#include "test-util.h"
+
+using namespace std;
+
+// A minimal stateful allocator that counts what it hands out.
+struct AllocCounts {
+    long allocated;
+    long live;
+    AllocCounts() : allocated(0), live(0) { }
+};
+
+template <typename T>
+struct CountingAllocator {
+    typedef T value_type;
+    AllocCounts* counts;
+
+    explicit CountingAllocator(AllocCounts* c) : counts(c) { }
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>& other) : counts(other.counts) { }
+
+    T* allocate(size_t n)
+    {
+        counts->allocated += n;
+        counts->live += n;
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+    void deallocate(T* p, size_t n)
+    {
+        counts->live -= n;
+        ::operator delete(p);
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const CountingAllocator<T>& a, const CountingAllocator<U>& b) { return a.counts == b.counts; }
+template <typename T, typename U>
+bool operator!=(const CountingAllocator<T>& a, const CountingAllocator<U>& b) { return a.counts != b.counts; }
+
+template<class Tree>
+bool matchesMap(Tree& tree, int steps)
+{
+    map<int,int> ref;
+    for (int step = 0; step < steps; ++step) {
+        int key = rand() % 1000;
+        if (rand() % 3 == 0) {
+            tree.remove(key);
+            ref.erase(key);
+        }
+        else {
+            tree.insert(make_pair(key, step));
+            ref[key] = step;
+        }
+    }
+    map<int,int>::iterator r = ref.begin();
+    for (typename Tree::iterator it = tree.begin(); it != tree.end(); ++it, ++r) {
+        if (r == ref.end() || it->first != r->first || it->second != r->second) return false;
+    }
+    return r == ref.end() && tree.isBalanced();
+}
+
+int main()
+{
+    srand(42);
+    AllocatorAVLTree<int,int> plain;
+    check(matchesMap(plain, 20000), "std::allocator tree matches std::map");
+
+    AllocCounts counts;
+    {
+        typedef CountingAllocator<pair<const int,int> > Alloc;
+        AllocatorAVLTree<int,int,Alloc> tree((Alloc(&counts)));
+        check(matchesMap(tree, 20000), "stateful allocator tree matches std::map");
+        long live = 0;
+        for (AllocatorAVLTree<int,int,Alloc>::iterator it = tree.begin(); it != tree.end(); ++it) ++live;
+        check(counts.live == live && counts.allocated > live, "every node comes from the allocator");
+        check(tree.get_allocator().counts == &counts, "get_allocator returns the tree's allocator");
+
+        // a stateful allocator only matches itself, so a move between trees copies
+        AllocatorAVLTree<int,int,Alloc> other((Alloc(&counts)));
+        long before = counts.allocated;
+        other.merge(tree);
+        check(tree.empty() && counts.allocated == before + live && counts.live == live, "merge between stateful trees copies");
+    }
+    check(counts.live == 0, "destruction returns every node");
+
+    // stateless allocators are interchangeable, so nodes move as they are
+    AllocatorAVLTree<int,int> a, b;
+    for (int i = 0; i < 100; ++i) a.insert(make_pair(i, i));
+    AVLTree<int,int>::iterator first = a.begin();
+    pair<const int,int>* item = &*first;
+    b.insert(a.extract(first));
+    check(&*b.begin() == item, "node handles move between std::allocator trees");
+
+#if __cplusplus >= 201703L
+    // a monotonic buffer with no upstream: overflowing it would throw
+    static char buffer[1 << 20];
+    std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+    bool fits = true;
+    try {
+        PmrAVLTree<int,int> scoped(&arena);
+        fits = matchesMap(scoped, 5000);
+    }
+    catch (const std::bad_alloc&) {
+        fits = false;
+    }
+    check(fits, "pmr tree lives in a monotonic buffer");
+#endif
+
+    return failures == 0 ? 0 : 1;
+}
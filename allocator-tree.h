@@ -0,0 +1,143 @@
+#ifndef ALLOCATOR_TREE_H
+#define ALLOCATOR_TREE_H
+
+#include <memory>
+#include <utility>
+#include <type_traits>
+#if __cplusplus >= 201703L
+#include <memory_resource>
+#endif
+#include "avlbst.h"
+
+/**
+* An AVLTree whose nodes come from a standard Allocator instead of the global
+* heap. The allocator is given for the tree's items, as for std::map, and is
+* rebound to the node type through std::allocator_traits, so any conforming
+* allocator works: a stateless one, an arena per tenant, or (from C++17) a
+* std::pmr::polymorphic_allocator over a monotonic buffer for trees that
+* live only as long as one request.
+*
+* Node handles move nodes without copying between two trees of the same
+* type when the allocator is stateless; a stateful allocator is only known
+* to match itself, so moves between such trees copy.
+*/
+template <typename Key, typename Value, typename Allocator = std::allocator<std::pair<const Key, Value> > >
+class AllocatorAVLTree : public AVLTree<Key, Value>
+{
+public:
+    typedef Allocator allocator_type;
+
+    explicit AllocatorAVLTree(const Allocator& alloc = Allocator());
+    virtual ~AllocatorAVLTree();
+
+    allocator_type get_allocator() const;
+    // Frees every node bottom-up in O(n), without the rebalancing that
+    // removing one key at a time does; with a monotonic resource underneath
+    // this is little more than running the destructors.
+    void clear();
+
+protected:
+    typedef AVLNode<Key, Value> ANode;
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<ANode> NodeAllocator;
+    typedef std::allocator_traits<NodeAllocator> NodeTraits;
+
+    virtual AVLNode<Key, Value>* createNode(const Key& key, const Value& value, AVLNode<Key, Value>* parent);
+    virtual void destroyNode(AVLNode<Key, Value>* node);
+    virtual const void* nodeSource() const;
+    void clearHelper(AVLNode<Key, Value>* n);
+
+    NodeAllocator alloc_;
+
+private:
+    AllocatorAVLTree(const AllocatorAVLTree&);
+    AllocatorAVLTree& operator=(const AllocatorAVLTree&);
+};
+
+#if __cplusplus >= 201703L
+template <typename Key, typename Value>
+using PmrAVLTree = AllocatorAVLTree<Key, Value, std::pmr::polymorphic_allocator<std::pair<const Key, Value> > >;
+#endif
+
+/*
+  ------------------------------------------------------
+  Begin implementations for the AllocatorAVLTree class.
+  ------------------------------------------------------
+*/
+
+template<class Key, class Value, class Allocator>
+AllocatorAVLTree<Key, Value, Allocator>::AllocatorAVLTree(const Allocator& alloc) :
+    alloc_(alloc)
+{
+
+}
+
+template<class Key, class Value, class Allocator>
+AllocatorAVLTree<Key, Value, Allocator>::~AllocatorAVLTree()
+{
+    //must run while alloc_ is still alive
+    clear();
+}
+
+template<class Key, class Value, class Allocator>
+void AllocatorAVLTree<Key, Value, Allocator>::clearHelper(AVLNode<Key, Value>* n)
+{
+    if (n == NULL) return;
+    clearHelper(n->getLeft());
+    clearHelper(n->getRight());
+    destroyNode(n);
+}
+
+template<class Key, class Value, class Allocator>
+void AllocatorAVLTree<Key, Value, Allocator>::clear()
+{
+    clearHelper(static_cast<AVLNode<Key, Value>*>(this->root_));
+    this->root_ = NULL;
+    this->resetExtremes();
+}
+
+template<class Key, class Value, class Allocator>
+typename AllocatorAVLTree<Key, Value, Allocator>::allocator_type AllocatorAVLTree<Key, Value, Allocator>::get_allocator() const
+{
+    return allocator_type(alloc_);
+}
+
+template<class Key, class Value, class Allocator>
+AVLNode<Key, Value>* AllocatorAVLTree<Key, Value, Allocator>::createNode(const Key& key, const Value& value,
+    AVLNode<Key, Value>* parent)
+{
+    ANode* node = NodeTraits::allocate(alloc_, 1);
+    try {
+        NodeTraits::construct(alloc_, node, key, value, parent);
+    }
+    catch (...) {
+        NodeTraits::deallocate(alloc_, node, 1);
+        throw;
+    }
+    return node;
+}
+
+template<class Key, class Value, class Allocator>
+void AllocatorAVLTree<Key, Value, Allocator>::destroyNode(AVLNode<Key, Value>* node)
+{
+    NodeTraits::destroy(alloc_, node);
+    NodeTraits::deallocate(alloc_, node, 1);
+}
+
+/**
+* Stateless allocators are interchangeable, so every such tree reports the
+* same source.
+*/
+template<class Key, class Value, class Allocator>
+const void* AllocatorAVLTree<Key, Value, Allocator>::nodeSource() const
+{
+    if (std::is_empty<Allocator>::value) return NULL;
+    return &alloc_;
+}
+
+/*
+  ----------------------------------------------------
+  End implementations for the AllocatorAVLTree class.
+  ----------------------------------------------------
+*/
+
+#endif
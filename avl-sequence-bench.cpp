@@ -0,0 +1,65 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include "avl-sequence.h"
+
+using namespace std;
+
+double msSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// Random positional inserts and erases, as an editor buffer would do them,
+// on an AVLSequence and on a std::vector of the same length.
+int main(int argc, char* argv[])
+{
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    size_t edits = argc > 2 ? strtoul(argv[2], NULL, 10) : 100000;
+
+    AVLSequence<int> seq;
+    vector<int> vec;
+    for (size_t i = 0; i < n; ++i) {
+        seq.pushBack((int)i);
+        vec.push_back((int)i);
+    }
+
+    mt19937_64 rng(37);
+    vector<size_t> positions(edits);
+    for (size_t e = 0; e < edits; ++e) positions[e] = rng() % n;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t e = 0; e < edits; ++e) {
+        seq.insertAt(positions[e], (int)e);
+        seq.eraseAt(positions[(e * 7) % edits]);
+    }
+    double seqMs = msSince(start);
+
+    start = chrono::steady_clock::now();
+    for (size_t e = 0; e < edits; ++e) {
+        vec.insert(vec.begin() + positions[e], (int)e);
+        vec.erase(vec.begin() + positions[(e * 7) % edits]);
+    }
+    double vecMs = msSince(start);
+
+    start = chrono::steady_clock::now();
+    AVLSequence<int> tail;
+    for (size_t e = 0; e < 1000; ++e) {
+        seq.splitAt(positions[e], tail);
+        seq.concat(tail);
+    }
+    double splitMs = msSince(start);
+
+    bool same = true;
+    for (size_t i = 0; i < n; i += 9973) same = same && seq.at(i) == vec[i];
+
+    cout << n << " elements, " << edits << " insert+erase pairs" << endl;
+    cout << fixed << setprecision(1);
+    cout << "AVLSequence:        " << seqMs << " ms" << (same ? "" : " (MISMATCH)") << endl;
+    cout << "std::vector:        " << vecMs << " ms" << endl;
+    cout << "1000 split+concat:  " << splitMs << " ms" << endl;
+    return 0;
+}
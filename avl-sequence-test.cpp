@@ -0,0 +1,120 @@
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <stdexcept>
+#include "avl-sequence.h"
+#include "test-util.h"
+
+using namespace std;
+
+bool sameContents(const AVLSequence<int>& seq, const vector<int>& ref)
+{
+    if (seq.size() != ref.size()) return false;
+    size_t i = 0;
+    for (AVLSequence<int>::iterator it = seq.begin(); it != seq.end(); ++it, ++i) {
+        if (i >= ref.size() || it->second != ref[i]) return false;
+    }
+    return i == ref.size();
+}
+
+int main()
+{
+    AVLSequence<int> seq;
+    vector<int> ref;
+    for (int i = 0; i < 10; ++i) {
+        seq.pushBack(i);
+        ref.push_back(i);
+    }
+    seq.insertAt(0, -1);
+    ref.insert(ref.begin(), -1);
+    seq.insertAt(5, 100);
+    ref.insert(ref.begin() + 5, 100);
+    seq.eraseAt(2);
+    ref.erase(ref.begin() + 2);
+    check(sameContents(seq, ref) && seq.at(4) == 100 && seq[0] == -1, "insertAt, eraseAt and at");
+
+    bool threw = false;
+    try {
+        seq.at(seq.size());
+    }
+    catch (const out_of_range&) {
+        threw = true;
+    }
+    check(threw, "at past the end throws");
+
+    // random positional edits against std::vector
+    srand(37);
+    bool agree = true;
+    for (int step = 0; step < 20000; ++step) {
+        if (rand() % 3 == 0 && !ref.empty()) {
+            size_t i = rand() % ref.size();
+            seq.eraseAt(i);
+            ref.erase(ref.begin() + i);
+        }
+        else {
+            size_t i = rand() % (ref.size() + 1);
+            seq.insertAt(i, step);
+            ref.insert(ref.begin() + i, step);
+        }
+        if (step % 1000 == 0) agree = agree && sameContents(seq, ref) && seq.isBalanced();
+    }
+    check(agree && sameContents(seq, ref), "random inserts and erases match std::vector");
+
+    // split at every kind of position, then glue the halves back together
+    agree = true;
+    for (int round = 0; round < 200; ++round) {
+        size_t i = rand() % (ref.size() + 1);
+        AVLSequence<int> rest;
+        seq.splitAt(i, rest);
+        vector<int> head(ref.begin(), ref.begin() + i);
+        vector<int> tail(ref.begin() + i, ref.end());
+        agree = agree && sameContents(seq, head) && sameContents(rest, tail)
+            && seq.isBalanced() && rest.isBalanced();
+        seq.concat(rest);
+        agree = agree && rest.empty() && sameContents(seq, ref) && seq.isBalanced();
+        if (!ref.empty()) {
+            size_t j = rand() % ref.size();
+            agree = agree && seq.at(j) == ref[j];
+        }
+    }
+    check(agree, "splitAt and concat round-trip");
+
+    // concatenating trees of very different heights
+    AVLSequence<int> big;
+    AVLSequence<int> small;
+    vector<int> bigRef;
+    for (int i = 0; i < 5000; ++i) {
+        big.pushBack(i);
+        bigRef.push_back(i);
+    }
+    for (int i = 0; i < 3; ++i) small.pushBack(-i);
+    AVLSequence<int> front;
+    front.pushBack(42);
+    front.concat(big);
+    bigRef.insert(bigRef.begin(), 42);
+    front.concat(small);
+    bigRef.push_back(0);
+    bigRef.push_back(-1);
+    bigRef.push_back(-2);
+    check(sameContents(front, bigRef) && front.isBalanced() && big.empty(), "concat of unequal heights");
+
+    bool edits = true;
+    for (int i = 0; i < 2000; ++i) {
+        size_t at = rand() % (bigRef.size() + 1);
+        front.insertAt(at, i);
+        bigRef.insert(bigRef.begin() + at, i);
+        size_t gone = rand() % bigRef.size();
+        front.eraseAt(gone);
+        bigRef.erase(bigRef.begin() + gone);
+    }
+    edits = sameContents(front, bigRef) && front.isBalanced();
+    check(edits, "edits after joins keep balances consistent");
+
+    AVLSequence<int> empty;
+    AVLSequence<int> none;
+    empty.splitAt(0, none);
+    empty.concat(none);
+    check(empty.empty() && empty.begin() == empty.end(), "empty sequences split and concat");
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,490 @@
+#ifndef AVL_SEQUENCE_H
+#define AVL_SEQUENCE_H
+
+#include <iostream>
+#include <cstddef>
+#include <cstdlib>
+#include <algorithm>
+#include <stdexcept>
+#include "aggregate-tree.h"
+
+/**
+* The key stored in every AVLSequence node. Positions are implied by subtree
+* sizes, so slots carry no data and all compare equal.
+*/
+struct SequenceSlot {
+    bool operator<(const SequenceSlot&) const { return false; }
+    bool operator>(const SequenceSlot&) const { return false; }
+    bool operator==(const SequenceSlot&) const { return true; }
+};
+
+inline std::ostream& operator<<(std::ostream& out, const SequenceSlot&)
+{
+    return out << "*";
+}
+
+/**
+* An ordered sequence (a rope) stored as an AVL tree whose in-order position
+* is the index. Every node keeps its subtree size as a CountOf aggregate, so
+* indexing, positional insert and erase, concatenation and splitting are all
+* O(log n). Insert and erase reuse AVLTree's insertFix/removeFix rebalancing;
+* concat and splitAt are built from a join that uses the same rotations.
+*
+* The key-based map interface is hidden. Iterators visit the elements in
+* order, with the element in it->second.
+*/
+template <typename Value>
+class AVLSequence : protected AggregateAVLTree<SequenceSlot, Value, CountOf>
+{
+public:
+    typedef typename BinarySearchTree<SequenceSlot, Value>::iterator iterator;
+
+    AVLSequence();
+    virtual ~AVLSequence();
+
+    using AggregateAVLTree<SequenceSlot, Value, CountOf>::empty;
+    using AggregateAVLTree<SequenceSlot, Value, CountOf>::end;
+    using AggregateAVLTree<SequenceSlot, Value, CountOf>::isBalanced;
+    using AggregateAVLTree<SequenceSlot, Value, CountOf>::begin;
+    size_t size() const;
+    void clear();
+
+    // Inserts value so that it becomes element i; i may equal size().
+    // Throws std::out_of_range for a larger i.
+    void insertAt(size_t i, const Value& value);
+    void pushBack(const Value& value);
+    // Removes element i. Throws std::out_of_range if there is none.
+    void eraseAt(size_t i);
+
+    // Element i. Throws std::out_of_range if there is none.
+    Value& at(size_t i);
+    Value const & at(size_t i) const;
+    Value& operator[](size_t i);
+    Value const & operator[](size_t i) const;
+
+    // Appends every element of other, leaving other empty.
+    void concat(AVLSequence& other);
+    // Keeps elements [0, i) and moves [i, size()) into rest, replacing its
+    // contents. Throws std::out_of_range if i > size().
+    void splitAt(size_t i, AVLSequence& rest);
+
+protected:
+    typedef AVLNode<SequenceSlot, Value> SNode;
+
+    AVLSequence(const AVLSequence&);
+    AVLSequence& operator=(const AVLSequence&);
+
+    SNode* root() const;
+    SNode* nodeAt(size_t i) const;
+    static int heightOf(SNode* n);
+    void clearHelper(SNode* n);
+
+    bool growFix(SNode* u, bool rightGrew);
+    SNode* join(SNode* left, int leftHeight, SNode* mid, SNode* right, int rightHeight, int& height);
+    void split(SNode* t, int height, size_t k, SNode*& left, int& leftHeight, SNode*& right, int& rightHeight);
+};
+
+/*
+  -------------------------------------------------
+  Begin implementations for the AVLSequence class.
+  -------------------------------------------------
+*/
+
+template<class Value>
+AVLSequence<Value>::AVLSequence()
+{
+
+}
+
+template<class Value>
+AVLSequence<Value>::~AVLSequence()
+{
+    clear();
+}
+
+template<class Value>
+typename AVLSequence<Value>::SNode* AVLSequence<Value>::root() const
+{
+    return static_cast<SNode*>(this->root_);
+}
+
+template<class Value>
+size_t AVLSequence<Value>::size() const
+{
+    return this->of(root());
+}
+
+template<class Value>
+void AVLSequence<Value>::clearHelper(SNode* n)
+{
+    if (n == NULL) return;
+    clearHelper(n->getLeft());
+    clearHelper(n->getRight());
+    this->destroyNode(n);
+}
+
+/**
+* Frees every node bottom-up in O(n), without any rebalancing.
+*/
+template<class Value>
+void AVLSequence<Value>::clear()
+{
+    clearHelper(root());
+    this->root_ = NULL;
+    this->resetExtremes();
+}
+
+/**
+* Walks down by subtree sizes to the node at position i, or NULL.
+*/
+template<class Value>
+typename AVLSequence<Value>::SNode* AVLSequence<Value>::nodeAt(size_t i) const
+{
+    SNode* n = root();
+    while (n != NULL) {
+        size_t leftSize = this->of(n->getLeft());
+        if (i < leftSize) n = n->getLeft();
+        else if (i == leftSize) return n;
+        else {
+            i -= leftSize + 1;
+            n = n->getRight();
+        }
+    }
+    return NULL;
+}
+
+/**
+* Height of the subtree at n, found by following the taller child.
+*/
+template<class Value>
+int AVLSequence<Value>::heightOf(SNode* n)
+{
+    int height = 0;
+    while (n != NULL) {
+        ++height;
+        n = n->getBalance() < 0 ? n->getLeft() : n->getRight();
+    }
+    return height;
+}
+
+/*
+ * The new node becomes the left child of the current element i, or the
+ * right child of its predecessor, which is the same in-order slot.
+ */
+template<class Value>
+void AVLSequence<Value>::insertAt(size_t i, const Value& value)
+{
+    size_t count = size();
+    if (i > count) throw std::out_of_range("Invalid position");
+
+    SNode* n = this->createNode(SequenceSlot(), value, NULL);
+    if (this->root_ == NULL) {
+        this->root_ = n;
+        this->updateNode(n);
+        this->resetExtremes();
+        return;
+    }
+
+    SNode* p = NULL;
+    if (i == count) {
+        p = root();
+        while (p->getRight() != NULL) p = p->getRight();
+        p->setRight(n);
+    }
+    else {
+        p = nodeAt(i);
+        if (p->getLeft() == NULL) p->setLeft(n);
+        else {
+            p = p->getLeft();
+            while (p->getRight() != NULL) p = p->getRight();
+            p->setRight(n);
+        }
+    }
+    n->setParent(p);
+    this->insertLinked(n);
+    // Slots all compare equal, so the cached ends follow the position instead.
+    if (i == 0) this->leftmost_ = n;
+    if (i == count) this->rightmost_ = n;
+}
+
+template<class Value>
+void AVLSequence<Value>::pushBack(const Value& value)
+{
+    insertAt(size(), value);
+}
+
+template<class Value>
+void AVLSequence<Value>::eraseAt(size_t i)
+{
+    SNode* n = nodeAt(i);
+    if (n == NULL) throw std::out_of_range("Invalid position");
+    this->detachNode(n);
+    this->destroyNode(n);
+}
+
+template<class Value>
+Value& AVLSequence<Value>::at(size_t i)
+{
+    SNode* n = nodeAt(i);
+    if (n == NULL) throw std::out_of_range("Invalid position");
+    return n->getValue();
+}
+
+template<class Value>
+Value const & AVLSequence<Value>::at(size_t i) const
+{
+    SNode* n = nodeAt(i);
+    if (n == NULL) throw std::out_of_range("Invalid position");
+    return n->getValue();
+}
+
+template<class Value>
+Value& AVLSequence<Value>::operator[](size_t i)
+{
+    return at(i);
+}
+
+template<class Value>
+Value const & AVLSequence<Value>::operator[](size_t i) const
+{
+    return at(i);
+}
+
+/**
+* Restores balance after the subtree on one side of u grew by one level,
+* walking up while the growth carries on. Sizes above the point where it
+* stops are refreshed too. Unlike insertFix this also handles a grown child
+* with balance 0, which a join can produce. Returns true if the growth
+* reached the top of the tree.
+*/
+template<class Value>
+bool AVLSequence<Value>::growFix(SNode* u, bool rightGrew)
+{
+    while (u != NULL) {
+        SNode* parent = u->getParent();
+        bool uIsRight = parent != NULL && parent->getRight() == u;
+        int balance = u->getBalance() + (rightGrew ? 1 : -1);
+
+        if (balance == 0) {
+            u->setBalance(0);
+            this->updatePath(u);
+            return false;
+        }
+        if (balance == 1 || balance == -1) {
+            u->setBalance(balance);
+            this->updateNode(u);
+            u = parent;
+            rightGrew = uIsRight;
+            continue;
+        }
+
+        SNode* top = NULL;
+        bool stillGrew = false;
+        if (balance == 2) {
+            SNode* c = u->getRight();
+            if (c->getBalance() >= 0) {
+                stillGrew = c->getBalance() == 0;
+                this->rotateLeft(u);
+                u->setBalance(stillGrew ? 1 : 0);
+                c->setBalance(stillGrew ? -1 : 0);
+                top = c;
+            }
+            else {
+                SNode* g = c->getLeft();
+                int gBalance = g->getBalance();
+                this->rotateRight(c);
+                this->rotateLeft(u);
+                u->setBalance(gBalance == 1 ? -1 : 0);
+                c->setBalance(gBalance == -1 ? 1 : 0);
+                g->setBalance(0);
+                top = g;
+            }
+        }
+        else {
+            SNode* c = u->getLeft();
+            if (c->getBalance() <= 0) {
+                stillGrew = c->getBalance() == 0;
+                this->rotateRight(u);
+                u->setBalance(stillGrew ? -1 : 0);
+                c->setBalance(stillGrew ? 1 : 0);
+                top = c;
+            }
+            else {
+                SNode* g = c->getRight();
+                int gBalance = g->getBalance();
+                this->rotateLeft(c);
+                this->rotateRight(u);
+                u->setBalance(gBalance == -1 ? 1 : 0);
+                c->setBalance(gBalance == 1 ? -1 : 0);
+                g->setBalance(0);
+                top = g;
+            }
+        }
+        if (!stillGrew) {
+            this->updatePath(top);
+            return false;
+        }
+        u = parent;
+        rightGrew = uIsRight;
+    }
+    return true;
+}
+
+/**
+* Joins left, mid and right (in that order) into one balanced tree and
+* returns its root; height receives its height. left and right are detached
+* trees of the given heights. If they differ in height by more than one, mid
+* is hung off the taller tree's inner spine at the first node short enough,
+* and growFix rebalances upward from there, so a join costs
+* O(|leftHeight - rightHeight| + 1).
+*
+* Rotations at the top of a detached tree move root_, so root_ is used as
+* scratch space here; callers set it afterwards.
+*/
+template<class Value>
+typename AVLSequence<Value>::SNode* AVLSequence<Value>::join(SNode* left, int leftHeight, SNode* mid,
+    SNode* right, int rightHeight, int& height)
+{
+    mid->setParent(NULL);
+    if (std::abs(leftHeight - rightHeight) <= 1) {
+        mid->setLeft(left);
+        mid->setRight(right);
+        if (left != NULL) left->setParent(mid);
+        if (right != NULL) right->setParent(mid);
+        mid->setBalance(rightHeight - leftHeight);
+        this->updateNode(mid);
+        height = std::max(leftHeight, rightHeight) + 1;
+        return mid;
+    }
+
+    if (leftHeight > rightHeight) {
+        this->root_ = left;
+        SNode* u = NULL;
+        SNode* v = left;
+        int vHeight = leftHeight;
+        while (vHeight > rightHeight + 1) {
+            u = v;
+            vHeight -= v->getBalance() < 0 ? 2 : 1;
+            v = v->getRight();
+        }
+        mid->setLeft(v);
+        mid->setRight(right);
+        if (v != NULL) v->setParent(mid);
+        if (right != NULL) right->setParent(mid);
+        mid->setBalance(rightHeight - vHeight);
+        this->updateNode(mid);
+        u->setRight(mid);
+        mid->setParent(u);
+        height = leftHeight + (growFix(u, true) ? 1 : 0);
+    }
+    else {
+        this->root_ = right;
+        SNode* u = NULL;
+        SNode* v = right;
+        int vHeight = rightHeight;
+        while (vHeight > leftHeight + 1) {
+            u = v;
+            vHeight -= v->getBalance() > 0 ? 2 : 1;
+            v = v->getLeft();
+        }
+        mid->setLeft(left);
+        mid->setRight(v);
+        if (left != NULL) left->setParent(mid);
+        if (v != NULL) v->setParent(mid);
+        mid->setBalance(vHeight - leftHeight);
+        this->updateNode(mid);
+        u->setLeft(mid);
+        mid->setParent(u);
+        height = rightHeight + (growFix(u, false) ? 1 : 0);
+    }
+    return root();
+}
+
+/**
+* Splits the detached tree t of the given height into its first k elements
+* and the rest. Each level takes t apart and joins it back onto one side, and
+* the joins' costs telescope, so the whole split is O(log n).
+*/
+template<class Value>
+void AVLSequence<Value>::split(SNode* t, int height, size_t k, SNode*& left, int& leftHeight,
+    SNode*& right, int& rightHeight)
+{
+    if (t == NULL) {
+        left = right = NULL;
+        leftHeight = rightHeight = 0;
+        return;
+    }
+    size_t leftSize = this->of(t->getLeft());
+    SNode* l = t->getLeft();
+    SNode* r = t->getRight();
+    int lHeight = height - 1 - (t->getBalance() > 0 ? 1 : 0);
+    int rHeight = height - 1 - (t->getBalance() < 0 ? 1 : 0);
+    if (l != NULL) l->setParent(NULL);
+    if (r != NULL) r->setParent(NULL);
+    t->setLeft(NULL);
+    t->setRight(NULL);
+
+    SNode* a = NULL;
+    SNode* b = NULL;
+    int aHeight = 0, bHeight = 0;
+    if (k <= leftSize) {
+        split(l, lHeight, k, a, aHeight, b, bHeight);
+        left = a;
+        leftHeight = aHeight;
+        right = join(b, bHeight, t, r, rHeight, rightHeight);
+    }
+    else {
+        split(r, rHeight, k - leftSize - 1, a, aHeight, b, bHeight);
+        left = join(l, lHeight, t, a, aHeight, leftHeight);
+        right = b;
+        rightHeight = bHeight;
+    }
+}
+
+/*
+ * The first element of other becomes the join point.
+ */
+template<class Value>
+void AVLSequence<Value>::concat(AVLSequence& other)
+{
+    if (&other == this || other.empty()) return;
+    if (this->empty()) {
+        std::swap(this->root_, other.root_);
+        std::swap(this->leftmost_, other.leftmost_);
+        std::swap(this->rightmost_, other.rightmost_);
+        return;
+    }
+    SNode* mid = static_cast<SNode*>(other.leftmost_);
+    Node<SequenceSlot, Value>* last = other.rightmost_;
+    other.detachNode(mid);
+    int height = 0;
+    SNode* joined = join(root(), heightOf(root()), mid, other.root(), heightOf(other.root()), height);
+    this->root_ = joined;
+    this->rightmost_ = last;
+    other.root_ = NULL;
+    other.resetExtremes();
+}
+
+template<class Value>
+void AVLSequence<Value>::splitAt(size_t i, AVLSequence& rest)
+{
+    if (i > size()) throw std::out_of_range("Invalid position");
+    if (&rest == this) return;
+    rest.clear();
+    SNode* left = NULL;
+    SNode* right = NULL;
+    int leftHeight = 0, rightHeight = 0;
+    split(root(), heightOf(root()), i, left, leftHeight, right, rightHeight);
+    this->root_ = left;
+    rest.root_ = right;
+    this->resetExtremes();
+    rest.resetExtremes();
+}
+
+/*
+  -----------------------------------------------
+  End implementations for the AVLSequence class.
+  -----------------------------------------------
+*/
+
+#endif
@@ -0,0 +1,100 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <set>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <new>
+#include "avl-set.h"
+#include "avlbst.h"
+
+using namespace std;
+
+// Every heap byte, so the node layouts can be compared by footprint.
+static size_t heapBytes = 0;
+
+void* operator new(size_t n)
+{
+    heapBytes += n;
+    void* p = malloc(n);
+    if (p == NULL) throw bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+double msSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// The three containers behind one interface for the timing loop.
+struct SetAdapter {
+    AVLSet<long long> s;
+    void add(long long k) { s.insert(k); }
+    bool has(long long k) const { return s.contains(k); }
+    void drop(long long k) { s.remove(k); }
+};
+
+struct TreeAdapter {
+    AVLTree<long long,bool> t;
+    void add(long long k) { t.insert(make_pair(k, true)); }
+    bool has(long long k) const { return t.find(k) != t.end(); }
+    void drop(long long k) { t.remove(k); }
+};
+
+struct StdSetAdapter {
+    set<long long> s;
+    void add(long long k) { s.insert(k); }
+    bool has(long long k) const { return s.count(k) != 0; }
+    void drop(long long k) { s.erase(k); }
+};
+
+// n random 8-byte keys: heap bytes per key after inserting, then lookups and removes.
+template<class Adapter>
+void run(const char* name, const vector<long long>& keys, size_t lookups)
+{
+    mt19937_64 rng(44);
+    size_t before = heapBytes;
+    Adapter* a = new Adapter;
+    before += sizeof(Adapter);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t i = 0; i < keys.size(); ++i) a->add(keys[i]);
+    double insertMs = msSince(start);
+    double bytes = (double)(heapBytes - before) / keys.size();
+
+    start = chrono::steady_clock::now();
+    size_t hits = 0;
+    for (size_t i = 0; i < lookups; ++i) hits += a->has(keys[rng() % keys.size()] + (long long)(rng() % 2));
+    double findMs = msSince(start);
+
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < keys.size(); ++i) a->drop(keys[i]);
+    double removeMs = msSince(start);
+    delete a;
+
+    cout << fixed << setprecision(1);
+    cout << name << bytes << " bytes/key, insert " << insertMs << " ms, find " << findMs
+         << " ms (" << hits << " hits), remove " << removeMs << " ms" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    size_t lookups = argc > 2 ? strtoul(argv[2], NULL, 10) : 2000000;
+
+    mt19937_64 rng(4444);
+    vector<long long> keys(n);
+    for (size_t i = 0; i < n; ++i) keys[i] = (long long)(rng() >> 2) * 2;
+
+    cout << n << " keys, " << lookups << " lookups" << endl;
+    run<TreeAdapter>("AVLTree<k,bool>: ", keys, lookups);
+    run<SetAdapter>("AVLSet:          ", keys, lookups);
+    run<StdSetAdapter>("std::set:        ", keys, lookups);
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include <iostream>
+#include <set>
+#include <cstdlib>
+#include "avl-set.h"
+#include "avlbst.h"
+#include "test-util.h"
+
+using namespace std;
+
+bool sameContents(const AVLSet<int>& s, const set<int>& ref)
+{
+    if (s.size() != ref.size()) return false;
+    set<int>::const_iterator r = ref.begin();
+    for (AVLSet<int>::iterator it = s.begin(); it != s.end(); ++it, ++r) {
+        if (r == ref.end() || *it != *r) return false;
+    }
+    return r == ref.end();
+}
+
+int main()
+{
+    AVLSet<int> s;
+    check(s.empty() && s.begin() == s.end() && s.min() == s.end() && !s.remove(1), "empty set");
+    check(s.insert(5) && !s.insert(5) && s.contains(5) && s.size() == 1, "insert reports duplicates");
+
+    // ascending and descending runs exercise the single rotations
+    for (int i = 0; i < 1000; ++i) s.insert(i);
+    for (int i = 2000; i > 1000; --i) s.insert(i);
+    check(s.isBalanced() && s.size() == 2000, "sequential inserts stay balanced");
+
+    srand(44);
+    set<int> ref;
+    for (AVLSet<int>::iterator it = s.begin(); it != s.end(); ++it) ref.insert(*it);
+    bool agree = true;
+    for (int step = 0; step < 50000; ++step) {
+        int key = rand() % 3000;
+        if (rand() % 2 == 0) agree = agree && s.remove(key) == (ref.erase(key) == 1);
+        else agree = agree && s.insert(key) == ref.insert(key).second;
+        if (step % 1000 == 0) agree = agree && s.isBalanced() && sameContents(s, ref);
+    }
+    check(agree && s.isBalanced() && sameContents(s, ref), "random inserts and removes match std::set");
+    check(*s.min() == *ref.begin() && *s.max() == *ref.rbegin(), "min and max");
+
+    bool bounds = true;
+    for (int i = 0; i < 2000; ++i) {
+        int key = rand() % 3100 - 50;
+        set<int>::iterator lo = ref.lower_bound(key);
+        set<int>::iterator hi = ref.upper_bound(key);
+        bounds = bounds && (lo == ref.end() ? s.lowerBound(key) == s.end() : *s.lowerBound(key) == *lo);
+        bounds = bounds && (hi == ref.end() ? s.upperBound(key) == s.end() : *s.upperBound(key) == *hi);
+        int other = key + rand() % 200;
+        size_t expect = 0;
+        for (set<int>::iterator it = lo; it != ref.end() && *it <= other; ++it) ++expect;
+        bounds = bounds && s.countRange(key, other) == expect;
+    }
+    check(bounds, "lowerBound, upperBound and countRange");
+
+    // removing other keys must not move a key to a different node
+    AVLSet<int>::iterator kept = s.find(*ref.begin());
+    const int* where = &*kept;
+    set<int>::iterator next = ref.begin();
+    ++next;
+    for (int i = 0; i < 200 && next != ref.end(); ++i) {
+        s.remove(*next);
+        ref.erase(next++);
+    }
+    check(&*s.find(*ref.begin()) == where && sameContents(s, ref), "iterators survive other removes");
+
+    s.clear();
+    check(s.empty() && s.size() == 0 && s.isBalanced(), "clear");
+
+    cout << "node bytes: SetNode<long long> " << sizeof(SetNode<long long>)
+         << ", AVLNode<long long,bool> " << sizeof(AVLNode<long long,bool>) << endl;
+    check(sizeof(SetNode<long long>) < sizeof(AVLNode<long long,bool>), "set nodes are smaller");
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,551 @@
+#ifndef AVL_SET_H
+#define AVL_SET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+/**
+* A node of an AVLSet. It holds the key and nothing else: no value, no pair
+* and, unlike Node, no vtable pointer, so for 8-byte keys a node is 40 bytes
+* where an AVLNode<Key, bool> is 56.
+*/
+template <typename Key>
+struct SetNode {
+    Key key;
+    SetNode* parent;
+    SetNode* left;
+    SetNode* right;
+    int8_t balance;     // height of right subtree minus height of left
+
+    SetNode(const Key& k, SetNode* p) : key(k), parent(p), left(NULL), right(NULL), balance(0) { }
+};
+
+/**
+* An ordered set of keys with the same AVL balancing as AVLTree (balance
+* factors kept in every node, single and double rotations, a node with two
+* children replaced by its predecessor), for the places that would otherwise
+* use AVLTree<Key, bool> and pay for a value they never read.
+*
+* Removing a key never moves another key to a different node, so iterators
+* to other keys stay valid.
+*/
+template <typename Key>
+class AVLSet
+{
+public:
+    AVLSet();
+    ~AVLSet();
+
+    // Returns false if key was already present.
+    bool insert(const Key& key);
+    // Returns false if key was not present.
+    bool remove(const Key& key);
+    void clear();
+    bool empty() const;
+    size_t size() const;
+    bool contains(const Key& key) const;
+    bool isBalanced() const;
+    void print() const;
+
+    /**
+    * An in-order iterator over the keys.
+    */
+    class iterator
+    {
+    public:
+        iterator();
+
+        const Key& operator*() const;
+        const Key* operator->() const;
+
+        bool operator==(const iterator& rhs) const;
+        bool operator!=(const iterator& rhs) const;
+
+        iterator& operator++();
+
+    protected:
+        friend class AVLSet<Key>;
+        explicit iterator(SetNode<Key>* ptr);
+        SetNode<Key>* current_;
+    };
+
+    iterator begin() const;
+    iterator end() const;
+    iterator find(const Key& key) const;
+    // The smallest and largest keys, or end() if the set is empty.
+    iterator min() const;
+    iterator max() const;
+    // The first key not less than key, and the first key greater than key.
+    iterator lowerBound(const Key& key) const;
+    iterator upperBound(const Key& key) const;
+    // Number of keys with lo <= key <= hi.
+    size_t countRange(const Key& lo, const Key& hi) const;
+
+protected:
+    typedef SetNode<Key> SNode;
+
+    static SNode* successor(SNode* n);
+    void replaceChild(SNode* parent, SNode* oldChild, SNode* newChild);
+    SNode* rotateLeft(SNode* x);
+    SNode* rotateRight(SNode* x);
+    SNode* rebalance(SNode* x);
+    void insertFix(SNode* n);
+    void removeFix(SNode* p, bool leftShrank);
+    void destroy(SNode* n);
+    int checkHeight(SNode* n) const;
+    void printHelper(SNode* n, int depth) const;
+
+    SNode* root_;
+    SNode* leftmost_;
+    SNode* rightmost_;
+    size_t size_;
+
+private:
+    AVLSet(const AVLSet&);
+    AVLSet& operator=(const AVLSet&);
+};
+
+/*
+  -------------------------------------------------
+  Begin implementations for the AVLSet::iterator class.
+  -------------------------------------------------
+*/
+
+template<class Key>
+AVLSet<Key>::iterator::iterator() :
+    current_(NULL)
+{
+
+}
+
+template<class Key>
+AVLSet<Key>::iterator::iterator(SetNode<Key>* ptr) :
+    current_(ptr)
+{
+
+}
+
+template<class Key>
+const Key& AVLSet<Key>::iterator::operator*() const
+{
+    return current_->key;
+}
+
+template<class Key>
+const Key* AVLSet<Key>::iterator::operator->() const
+{
+    return &current_->key;
+}
+
+template<class Key>
+bool AVLSet<Key>::iterator::operator==(const iterator& rhs) const
+{
+    return current_ == rhs.current_;
+}
+
+template<class Key>
+bool AVLSet<Key>::iterator::operator!=(const iterator& rhs) const
+{
+    return current_ != rhs.current_;
+}
+
+template<class Key>
+typename AVLSet<Key>::iterator& AVLSet<Key>::iterator::operator++()
+{
+    current_ = AVLSet<Key>::successor(current_);
+    return *this;
+}
+
+/*
+  -----------------------------------------------
+  End implementations for the AVLSet::iterator class.
+  -----------------------------------------------
+*/
+
+/*
+  -------------------------------------------
+  Begin implementations for the AVLSet class.
+  -------------------------------------------
+*/
+
+template<class Key>
+AVLSet<Key>::AVLSet() :
+    root_(NULL), leftmost_(NULL), rightmost_(NULL), size_(0)
+{
+
+}
+
+template<class Key>
+AVLSet<Key>::~AVLSet()
+{
+    clear();
+}
+
+template<class Key>
+typename AVLSet<Key>::SNode* AVLSet<Key>::successor(SNode* n)
+{
+    if (n->right != NULL) {
+        n = n->right;
+        while (n->left != NULL) n = n->left;
+        return n;
+    }
+    while (n->parent != NULL && n == n->parent->right) n = n->parent;
+    return n->parent;
+}
+
+template<class Key>
+void AVLSet<Key>::replaceChild(SNode* parent, SNode* oldChild, SNode* newChild)
+{
+    if (parent == NULL) root_ = newChild;
+    else if (parent->left == oldChild) parent->left = newChild;
+    else parent->right = newChild;
+    if (newChild != NULL) newChild->parent = parent;
+}
+
+/**
+* Both rotations return the new top of the subtree and leave the balance
+* factors to rebalance.
+*/
+template<class Key>
+typename AVLSet<Key>::SNode* AVLSet<Key>::rotateLeft(SNode* x)
+{
+    SNode* y = x->right;
+    x->right = y->left;
+    if (y->left != NULL) y->left->parent = x;
+    replaceChild(x->parent, x, y);
+    y->left = x;
+    x->parent = y;
+    return y;
+}
+
+template<class Key>
+typename AVLSet<Key>::SNode* AVLSet<Key>::rotateRight(SNode* x)
+{
+    SNode* y = x->left;
+    x->left = y->right;
+    if (y->right != NULL) y->right->parent = x;
+    replaceChild(x->parent, x, y);
+    y->right = x;
+    x->parent = y;
+    return y;
+}
+
+/**
+* Fixes a node whose balance reached +2 or -2 with a single rotation (zig-zig)
+* or a double rotation (zig-zag), and returns the subtree's new top. The
+* taller child's balance is 0 only after a remove, and then the subtree keeps
+* its height.
+*/
+template<class Key>
+typename AVLSet<Key>::SNode* AVLSet<Key>::rebalance(SNode* x)
+{
+    if (x->balance > 0) {
+        SNode* c = x->right;
+        if (c->balance >= 0) {
+            rotateLeft(x);
+            if (c->balance == 0) {
+                x->balance = 1;
+                c->balance = -1;
+            }
+            else {
+                x->balance = 0;
+                c->balance = 0;
+            }
+            return c;
+        }
+        SNode* g = c->left;
+        rotateRight(c);
+        rotateLeft(x);
+        x->balance = g->balance > 0 ? -1 : 0;
+        c->balance = g->balance < 0 ? 1 : 0;
+        g->balance = 0;
+        return g;
+    }
+    SNode* c = x->left;
+    if (c->balance <= 0) {
+        rotateRight(x);
+        if (c->balance == 0) {
+            x->balance = -1;
+            c->balance = 1;
+        }
+        else {
+            x->balance = 0;
+            c->balance = 0;
+        }
+        return c;
+    }
+    SNode* g = c->right;
+    rotateLeft(c);
+    rotateRight(x);
+    x->balance = g->balance < 0 ? 1 : 0;
+    c->balance = g->balance > 0 ? -1 : 0;
+    g->balance = 0;
+    return g;
+}
+
+/**
+* Walks up from the new leaf n until a subtree's height stops growing; at
+* most one rebalance is needed.
+*/
+template<class Key>
+void AVLSet<Key>::insertFix(SNode* n)
+{
+    SNode* child = n;
+    for (SNode* p = n->parent; p != NULL; child = p, p = p->parent) {
+        p->balance += (child == p->left) ? -1 : 1;
+        if (p->balance == 0) return;
+        if (p->balance == 2 || p->balance == -2) {
+            rebalance(p);
+            return;
+        }
+    }
+}
+
+/**
+* Walks up from p, whose left (or right) subtree just got shorter, until a
+* subtree keeps its height.
+*/
+template<class Key>
+void AVLSet<Key>::removeFix(SNode* p, bool leftShrank)
+{
+    while (p != NULL) {
+        p->balance += leftShrank ? 1 : -1;
+        if (p->balance == 1 || p->balance == -1) return;
+        SNode* top = p;
+        if (p->balance == 2 || p->balance == -2) {
+            top = rebalance(p);
+            if (top->balance != 0) return;
+        }
+        SNode* parent = top->parent;
+        if (parent != NULL) leftShrank = (parent->left == top);
+        p = parent;
+    }
+}
+
+template<class Key>
+bool AVLSet<Key>::insert(const Key& key)
+{
+    SNode* temp = root_;
+    SNode* p = NULL;
+    while (temp != NULL) {
+        p = temp;
+        if (key < temp->key) temp = temp->left;
+        else if (temp->key < key) temp = temp->right;
+        else return false;
+    }
+    SNode* n = new SNode(key, p);
+    if (p == NULL) root_ = n;
+    else if (key < p->key) p->left = n;
+    else p->right = n;
+    if (leftmost_ == NULL || key < leftmost_->key) leftmost_ = n;
+    if (rightmost_ == NULL || rightmost_->key < key) rightmost_ = n;
+    ++size_;
+    insertFix(n);
+    return true;
+}
+
+/**
+* A node with two children is replaced by its predecessor: the predecessor
+* is unlinked from its own spot (it has no right child) and the tree is
+* rebalanced there, then it is moved into the removed node's place, taking
+* over its links and balance.
+*/
+template<class Key>
+bool AVLSet<Key>::remove(const Key& key)
+{
+    SNode* n = find(key).current_;
+    if (n == NULL) return false;
+    if (n == leftmost_) leftmost_ = successor(n);
+    if (n == rightmost_) {
+        SNode* pred = n->left;
+        if (pred != NULL) while (pred->right != NULL) pred = pred->right;
+        else pred = n->parent;
+        rightmost_ = pred;
+    }
+
+    if (n->left != NULL && n->right != NULL) {
+        SNode* pred = n->left;
+        while (pred->right != NULL) pred = pred->right;
+        SNode* p = pred->parent;
+        bool leftShrank = (p->left == pred);
+        replaceChild(p, pred, pred->left);
+        removeFix(p, leftShrank);
+
+        pred->left = n->left;
+        pred->right = n->right;
+        pred->balance = n->balance;
+        if (pred->left != NULL) pred->left->parent = pred;
+        if (pred->right != NULL) pred->right->parent = pred;
+        replaceChild(n->parent, n, pred);
+    }
+    else {
+        SNode* child = n->left != NULL ? n->left : n->right;
+        SNode* p = n->parent;
+        bool leftShrank = (p != NULL && p->left == n);
+        replaceChild(p, n, child);
+        removeFix(p, leftShrank);
+    }
+    delete n;
+    --size_;
+    return true;
+}
+
+template<class Key>
+void AVLSet<Key>::destroy(SNode* n)
+{
+    if (n == NULL) return;
+    destroy(n->left);
+    destroy(n->right);
+    delete n;
+}
+
+template<class Key>
+void AVLSet<Key>::clear()
+{
+    destroy(root_);
+    root_ = NULL;
+    leftmost_ = NULL;
+    rightmost_ = NULL;
+    size_ = 0;
+}
+
+template<class Key>
+bool AVLSet<Key>::empty() const
+{
+    return root_ == NULL;
+}
+
+template<class Key>
+size_t AVLSet<Key>::size() const
+{
+    return size_;
+}
+
+template<class Key>
+bool AVLSet<Key>::contains(const Key& key) const
+{
+    return find(key) != end();
+}
+
+template<class Key>
+typename AVLSet<Key>::iterator AVLSet<Key>::begin() const
+{
+    return iterator(leftmost_);
+}
+
+template<class Key>
+typename AVLSet<Key>::iterator AVLSet<Key>::end() const
+{
+    return iterator(NULL);
+}
+
+template<class Key>
+typename AVLSet<Key>::iterator AVLSet<Key>::find(const Key& key) const
+{
+    SNode* temp = root_;
+    while (temp != NULL) {
+        if (key < temp->key) temp = temp->left;
+        else if (temp->key < key) temp = temp->right;
+        else break;
+    }
+    return iterator(temp);
+}
+
+template<class Key>
+typename AVLSet<Key>::iterator AVLSet<Key>::min() const
+{
+    return iterator(leftmost_);
+}
+
+template<class Key>
+typename AVLSet<Key>::iterator AVLSet<Key>::max() const
+{
+    return iterator(rightmost_);
+}
+
+template<class Key>
+typename AVLSet<Key>::iterator AVLSet<Key>::lowerBound(const Key& key) const
+{
+    SNode* temp = root_;
+    SNode* best = NULL;
+    while (temp != NULL) {
+        if (temp->key < key) temp = temp->right;
+        else {
+            best = temp;
+            temp = temp->left;
+        }
+    }
+    return iterator(best);
+}
+
+template<class Key>
+typename AVLSet<Key>::iterator AVLSet<Key>::upperBound(const Key& key) const
+{
+    SNode* temp = root_;
+    SNode* best = NULL;
+    while (temp != NULL) {
+        if (key < temp->key) {
+            best = temp;
+            temp = temp->left;
+        }
+        else temp = temp->right;
+    }
+    return iterator(best);
+}
+
+template<class Key>
+size_t AVLSet<Key>::countRange(const Key& lo, const Key& hi) const
+{
+    size_t count = 0;
+    if (hi < lo) return 0;
+    for (iterator it = lowerBound(lo); it != end() && !(hi < *it); ++it) ++count;
+    return count;
+}
+
+/**
+* Returns the height of n, or -1 if a balance factor anywhere below is wrong
+* or out of range.
+*/
+template<class Key>
+int AVLSet<Key>::checkHeight(SNode* n) const
+{
+    if (n == NULL) return 0;
+    int left = checkHeight(n->left);
+    int right = checkHeight(n->right);
+    if (left < 0 || right < 0) return -1;
+    if (right - left != n->balance || n->balance > 1 || n->balance < -1) return -1;
+    return std::max(left, right) + 1;
+}
+
+template<class Key>
+bool AVLSet<Key>::isBalanced() const
+{
+    return checkHeight(root_) >= 0;
+}
+
+template<class Key>
+void AVLSet<Key>::printHelper(SNode* n, int depth) const
+{
+    if (n == NULL) return;
+    printHelper(n->right, depth + 1);
+    std::cout << std::string(depth * 4, ' ') << n->key << std::endl;
+    printHelper(n->left, depth + 1);
+}
+
+template<class Key>
+void AVLSet<Key>::print() const
+{
+    if (root_ == NULL) std::cout << "<empty set>" << std::endl;
+    printHelper(root_, 0);
+}
+
+/*
+  -----------------------------------------
+  End implementations for the AVLSet class.
+  -----------------------------------------
+*/
+
+#endif
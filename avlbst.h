@@ -6,6 +6,8 @@
 #include <cstdlib>
 #include <cstdint>
 #include <algorithm>
+#include <stdexcept>
+#include <typeinfo>
 #include "bst.h"
 
 struct KeyError { };
@@ -132,11 +134,113 @@ template <class Key, class Value>
 class AVLTree : public BinarySearchTree<Key, Value>
 {
 public:
+    typedef typename BinarySearchTree<Key, Value>::iterator iterator;
+
+    /**
+    * Owns one node taken out of a tree by extract. Putting it back with
+    * insert relinks the same node, so neither the key nor the value is
+    * copied and nothing is allocated. A handle that still holds its node
+    * when it goes away gives the node back to the tree it came from, so it
+    * must not outlive that tree.
+    */
+    class NodeHandle
+    {
+    public:
+        NodeHandle();
+        NodeHandle(NodeHandle&& other);
+        NodeHandle& operator=(NodeHandle&& other);
+        ~NodeHandle();
+
+        bool empty() const;
+        const Key& key() const;
+        Value& value() const;
+
+    protected:
+        friend class AVLTree<Key, Value>;
+        NodeHandle(AVLTree<Key, Value>* owner, AVLNode<Key, Value>* node);
+        void reset();
+
+        AVLTree<Key, Value>* owner_;
+        AVLNode<Key, Value>* node_;
+
+    private:
+        NodeHandle(const NodeHandle&);
+        NodeHandle& operator=(const NodeHandle&);
+    };
+
+    virtual ~AVLTree();
     virtual void insert (const std::pair<const Key, Value> &new_item); // TODO
     virtual void remove(const Key& key);  // TODO
+    // Inserts new_item only if its key is absent. Returns an iterator to the
+    // item with that key and whether it was inserted, so a caller that must
+    // know whether the tree grew needs one descent, not find then insert.
+    // insert goes through this, so subclasses that must see every new item
+    // override this rather than insert.
+    virtual std::pair<iterator, bool> tryInsert(const std::pair<const Key, Value>& new_item);
+
+    // Unlink an item and rebalance, handing the node to the caller. An
+    // absent key or end() gives an empty handle.
+    NodeHandle extract(const Key& key);
+    NodeHandle extract(const iterator& pos);
+    // Links the handle's node back in and returns an iterator to it. If the
+    // key is already present, the tree is unchanged, nh keeps its node and
+    // the iterator points at the existing item. An empty handle gives end().
+    iterator insert(NodeHandle&& nh);
+    // Moves every item of other whose key is not already here into this
+    // tree, relinking nodes rather than copying them.
+    void merge(AVLTree<Key, Value>& other);
+
+    // Replaces the contents with the items in [first, last), which must be in
+    // strictly increasing key order. Builds a balanced tree in O(n) without
+    // any rotations.
+    template<class InputIt>
+    void bulkLoad(InputIt first, InputIt last);
+
+    // Remove the smallest or largest item. They start from the cached end
+    // node instead of searching for a key; do nothing if the tree is empty.
+    void popMin();
+    void popMax();
 protected:
     virtual void nodeSwap( AVLNode<Key,Value>* n1, AVLNode<Key,Value>* n2);
 
+    // Node lifetime hooks. Every node the tree owns is made by createNode and
+    // released by destroyNode, so subclasses can pool or otherwise place nodes.
+    // A subclass that overrides these must call clear() in its own destructor.
+    virtual AVLNode<Key,Value>* createNode(const Key& key, const Value& value, AVLNode<Key,Value>* parent);
+    virtual void destroyNode(AVLNode<Key,Value>* node);
+    // Where createNode gets its memory, NULL for the global heap. Two trees
+    // of the same type with the same source can trade nodes; otherwise a
+    // node moved between them is copied into a fresh one.
+    virtual const void* nodeSource() const;
+    bool sharesNodesWith(const AVLTree<Key,Value>& other) const;
+
+    // The node-level halves of extract and insert(NodeHandle&&). insertNode
+    // links a detached node and returns false, leaving it detached, if its
+    // key is already present. Subclasses that must see every node move in
+    // or out override these.
+    virtual void extractNode(AVLNode<Key,Value>* n);
+    virtual bool insertNode(AVLNode<Key,Value>* n);
+
+    // Rebalances after the leaf n was linked below its parent.
+    void insertLinked(AVLNode<Key,Value>* n);
+    // Unlinks n and rebalances without destroying it.
+    void detachNode(AVLNode<Key,Value>* n);
+
+    // Augmentation hooks. updateNode recomputes whatever a subclass stores in
+    // n from n's own item and its children; updatePath does the same for n and
+    // every ancestor. Rotations call updateNode on the two nodes they move, and
+    // insert/remove call updatePath on the node whose subtree changed before
+    // rebalancing. Both do nothing by default.
+    virtual void updateNode(AVLNode<Key,Value>* n);
+    virtual void updatePath(AVLNode<Key,Value>* n);
+
+    // Exact: by following the taller child, or from the parent's balance.
+    virtual int heightEstimate(Node<Key,Value>* n) const;
+    virtual int childHeightEstimate(Node<Key,Value>* n, int height, bool right) const;
+
+    template<class InputIt>
+    AVLNode<Key,Value>* buildRange(InputIt& it, size_t count, AVLNode<Key,Value>* parent, int& height);
+
     // Add helper functions here
 
     //p is parent and n is newly-inserted node
@@ -150,6 +254,172 @@ protected:
 
 };
 
+/*
+  ------------------------------------------------------
+  Begin implementations for the AVLTree::NodeHandle class.
+  ------------------------------------------------------
+*/
+
+template<class Key, class Value>
+AVLTree<Key, Value>::NodeHandle::NodeHandle() :
+    owner_(NULL), node_(NULL)
+{
+
+}
+
+template<class Key, class Value>
+AVLTree<Key, Value>::NodeHandle::NodeHandle(AVLTree<Key, Value>* owner, AVLNode<Key, Value>* node) :
+    owner_(owner), node_(node)
+{
+
+}
+
+template<class Key, class Value>
+AVLTree<Key, Value>::NodeHandle::NodeHandle(NodeHandle&& other) :
+    owner_(other.owner_), node_(other.node_)
+{
+    other.owner_ = NULL;
+    other.node_ = NULL;
+}
+
+template<class Key, class Value>
+typename AVLTree<Key, Value>::NodeHandle& AVLTree<Key, Value>::NodeHandle::operator=(NodeHandle&& other)
+{
+    if (this != &other) {
+        reset();
+        owner_ = other.owner_;
+        node_ = other.node_;
+        other.owner_ = NULL;
+        other.node_ = NULL;
+    }
+    return *this;
+}
+
+template<class Key, class Value>
+AVLTree<Key, Value>::NodeHandle::~NodeHandle()
+{
+    reset();
+}
+
+/**
+* Gives a node that was never reinserted back to its tree's destroyNode.
+*/
+template<class Key, class Value>
+void AVLTree<Key, Value>::NodeHandle::reset()
+{
+    if (node_ != NULL) owner_->destroyNode(node_);
+    owner_ = NULL;
+    node_ = NULL;
+}
+
+template<class Key, class Value>
+bool AVLTree<Key, Value>::NodeHandle::empty() const
+{
+    return node_ == NULL;
+}
+
+template<class Key, class Value>
+const Key& AVLTree<Key, Value>::NodeHandle::key() const
+{
+    if (node_ == NULL) throw std::out_of_range("Empty node handle");
+    return node_->getKey();
+}
+
+template<class Key, class Value>
+Value& AVLTree<Key, Value>::NodeHandle::value() const
+{
+    if (node_ == NULL) throw std::out_of_range("Empty node handle");
+    return node_->getValue();
+}
+
+/*
+  ----------------------------------------------------
+  End implementations for the AVLTree::NodeHandle class.
+  ----------------------------------------------------
+*/
+
+/**
+* Destructor which empties the tree while the AVLTree hooks are still
+* reachable, so every node goes back through destroyNode.
+*/
+template<class Key, class Value>
+AVLTree<Key, Value>::~AVLTree()
+{
+    this->clear();
+}
+
+/**
+* Allocates a new node. The default uses the global heap.
+*/
+template<class Key, class Value>
+AVLNode<Key, Value>* AVLTree<Key, Value>::createNode(const Key& key, const Value& value, AVLNode<Key, Value>* parent)
+{
+    return new AVLNode<Key, Value>(key, value, parent);
+}
+
+/**
+* Releases a node previously returned by createNode.
+*/
+template<class Key, class Value>
+void AVLTree<Key, Value>::destroyNode(AVLNode<Key, Value>* node)
+{
+    delete node;
+}
+
+template<class Key, class Value>
+void AVLTree<Key, Value>::updateNode(AVLNode<Key, Value>* n)
+{
+
+}
+
+template<class Key, class Value>
+void AVLTree<Key, Value>::updatePath(AVLNode<Key, Value>* n)
+{
+
+}
+
+template<class Key, class Value>
+template<class InputIt>
+void AVLTree<Key, Value>::bulkLoad(InputIt first, InputIt last)
+{
+    this->clear();
+    size_t count = 0;
+    for (InputIt it = first; it != last; ++it) ++count;
+    int height = 0;
+    this->root_ = buildRange(first, count, NULL, height);
+    this->resetExtremes();
+}
+
+/**
+* Builds a balanced subtree from the next count items of it, consuming them in
+* order, and reports the subtree's height. The left half is never taller than
+* the right half, so every balance is 0 or +1.
+*/
+template<class Key, class Value>
+template<class InputIt>
+AVLNode<Key, Value>* AVLTree<Key, Value>::buildRange(InputIt& it, size_t count, AVLNode<Key, Value>* parent, int& height)
+{
+    if (count == 0) {
+        height = 0;
+        return NULL;
+    }
+    size_t leftCount = count / 2;
+    int leftHeight = 0, rightHeight = 0;
+    AVLNode<Key, Value>* left = buildRange(it, leftCount, NULL, leftHeight);
+
+    AVLNode<Key, Value>* node = createNode(it->first, it->second, parent);
+    ++it;
+    node->setLeft(left);
+    if (left != NULL) left->setParent(node);
+
+    AVLNode<Key, Value>* right = buildRange(it, count - leftCount - 1, node, rightHeight);
+    node->setRight(right);
+    node->setBalance(rightHeight - leftHeight);
+    updateNode(node);
+    height = std::max(leftHeight, rightHeight) + 1;
+    return node;
+}
+
 /*
  * Recall: If key is already in the tree, you should 
  * overwrite the current value with the updated value.
@@ -158,51 +428,65 @@ template<class Key, class Value>
 void AVLTree<Key, Value>::insert (const std::pair<const Key, Value> &new_item)
 {
     // TODO
+    std::pair<iterator, bool> result = tryInsert(new_item);
+    if (!result.second) {
+        AVLNode<Key, Value>* toChange = static_cast<AVLNode<Key, Value>*>(this->nodeOf(result.first));
+        toChange->setValue(new_item.second); //only change value if key exists
+        updatePath(toChange);
+    }
+}
+
+template<class Key, class Value>
+std::pair<typename AVLTree<Key, Value>::iterator, bool> AVLTree<Key, Value>::tryInsert(const std::pair<const Key, Value>& new_item)
+{
     if (this->empty()) {
-        AVLNode<Key, Value>* nodeToAdd = new AVLNode<Key, Value>(new_item.first, new_item.second, NULL);
+        AVLNode<Key, Value>* nodeToAdd = createNode(new_item.first, new_item.second, NULL);
 				nodeToAdd->setBalance(0);
         this->root_ = nodeToAdd;
-    }
-
-    else if (this->internalFind(new_item.first) != NULL) {
-        AVLNode<Key, Value>* toChange = static_cast<AVLNode<Key, Value>*>(this->internalFind(new_item.first));
-        toChange->setValue(new_item.second); //only change value if key exists
+        updateNode(nodeToAdd);
+        this->noteInserted(nodeToAdd);
+        return std::make_pair(this->iteratorOf(nodeToAdd), true);
     }
 
     else {
-        AVLNode<Key, Value>* temp = static_cast<AVLNode<Key, Value>*>(this->root_);
-        AVLNode<Key, Value>* p = NULL;
-        while (temp != NULL) {
-            if (temp->getKey() > new_item.first) {
-                p = temp;
-                temp = temp->getLeft();
-            }
-            else if (temp->getKey() < new_item.first) {
-                p = temp;
-                temp = temp->getRight();
-            }
-        }
-				int diff = 0;  
-        AVLNode<Key, Value>* nodeToAdd = new AVLNode<Key, Value>(new_item.first, new_item.second, p);
+        //one descent finds either the key or the parent for the new leaf
+        Node<Key, Value>* last = NULL;
+        Node<Key, Value>* found = this->descend(new_item.first, last);
+        if (found != NULL) return std::make_pair(this->iteratorOf(found), false);
+        AVLNode<Key, Value>* p = static_cast<AVLNode<Key, Value>*>(last);
+        AVLNode<Key, Value>* nodeToAdd = createNode(new_item.first, new_item.second, p);
 				nodeToAdd->setBalance(0);
         if (p->getKey() > new_item.first) {
             p->setLeft(nodeToAdd);
-						diff = -1;
         }
         else {
             p->setRight(nodeToAdd);
-						diff = 1;
         }
-
-				//update balances and insertFix if necessary
-				if (p->getBalance() == 1 || p->getBalance() == -1) p->setBalance(0);
-				else if(p->getBalance() == 0) {
-						p->setBalance(p->getBalance() + diff);
-						insertFix(p, nodeToAdd);
-				}
+        this->noteInserted(nodeToAdd);
+        insertLinked(nodeToAdd);
+        return std::make_pair(this->iteratorOf(nodeToAdd), true);
     }
 }
 
+/**
+* Rebalances after the new leaf n was linked in below its parent.
+*/
+template<class Key, class Value>
+void AVLTree<Key, Value>::insertLinked(AVLNode<Key, Value>* n)
+{
+    AVLNode<Key, Value>* p = n->getParent();
+    updatePath(n);
+    if (p == NULL) return;
+    int diff = (p->getLeft() == n) ? -1 : 1;
+
+		//update balances and insertFix if necessary
+		if (p->getBalance() == 1 || p->getBalance() == -1) p->setBalance(0);
+		else if(p->getBalance() == 0) {
+				p->setBalance(p->getBalance() + diff);
+				insertFix(p, n);
+		}
+}
+
 /*
  * Recall: The writeup specifies that if a node has 2 children you
  * should swap with the predecessor and then remove.
@@ -215,6 +499,171 @@ void AVLTree<Key, Value>::remove(const Key& key)
 	AVLNode<Key, Value>* toRemove = static_cast<AVLNode<Key, Value>*>(this->internalFind(key));
 	
 	if (toRemove == NULL) return;
+	detachNode(toRemove);
+	destroyNode(toRemove);
+}
+
+template<class Key, class Value>
+void AVLTree<Key, Value>::popMin()
+{
+	if (this->leftmost_ == NULL) return;
+	AVLNode<Key, Value>* n = static_cast<AVLNode<Key, Value>*>(this->leftmost_);
+	detachNode(n);
+	destroyNode(n);
+}
+
+template<class Key, class Value>
+void AVLTree<Key, Value>::popMax()
+{
+	if (this->rightmost_ == NULL) return;
+	AVLNode<Key, Value>* n = static_cast<AVLNode<Key, Value>*>(this->rightmost_);
+	detachNode(n);
+	destroyNode(n);
+}
+
+template<class Key, class Value>
+typename AVLTree<Key, Value>::NodeHandle AVLTree<Key, Value>::extract(const Key& key)
+{
+	AVLNode<Key, Value>* n = static_cast<AVLNode<Key, Value>*>(this->internalFind(key));
+	if (n == NULL) return NodeHandle();
+	extractNode(n);
+	return NodeHandle(this, n);
+}
+
+template<class Key, class Value>
+typename AVLTree<Key, Value>::NodeHandle AVLTree<Key, Value>::extract(const iterator& pos)
+{
+	AVLNode<Key, Value>* n = static_cast<AVLNode<Key, Value>*>(this->nodeOf(pos));
+	if (n == NULL) return NodeHandle();
+	extractNode(n);
+	return NodeHandle(this, n);
+}
+
+/**
+* A node from a tree that allocates differently is copied into one of ours,
+* and the original goes back to its own tree.
+*/
+template<class Key, class Value>
+typename AVLTree<Key, Value>::iterator AVLTree<Key, Value>::insert(NodeHandle&& nh)
+{
+	if (nh.empty()) return this->end();
+	typename BinarySearchTree<Key, Value>::iterator existing = this->find(nh.key());
+	if (existing != this->end()) return existing;
+
+	AVLNode<Key, Value>* n = nh.node_;
+	if (!sharesNodesWith(*nh.owner_)) {
+		n = createNode(nh.key(), nh.value(), NULL);
+		nh.reset();
+	}
+	nh.owner_ = NULL;
+	nh.node_ = NULL;
+	insertNode(n);
+	return this->iteratorOf(n);
+}
+
+/**
+* Walks other in order, remembering each node's successor before the node
+* leaves; extracting one node never moves the others.
+*/
+template<class Key, class Value>
+void AVLTree<Key, Value>::merge(AVLTree<Key, Value>& other)
+{
+	if (&other == this) return;
+	bool shared = sharesNodesWith(other);
+	AVLNode<Key, Value>* n = static_cast<AVLNode<Key, Value>*>(other.leftmost_);
+	while (n != NULL) {
+		AVLNode<Key, Value>* next = static_cast<AVLNode<Key, Value>*>(this->successor(n));
+		if (this->internalFind(n->getKey()) == NULL) {
+			other.extractNode(n);
+			if (shared) insertNode(n);
+			else {
+				insertNode(createNode(n->getKey(), n->getValue(), NULL));
+				other.destroyNode(n);
+			}
+		}
+		n = next;
+	}
+}
+
+template<class Key, class Value>
+const void* AVLTree<Key, Value>::nodeSource() const
+{
+	return NULL;
+}
+
+template<class Key, class Value>
+int AVLTree<Key, Value>::heightEstimate(Node<Key, Value>* n) const
+{
+	int height = 0;
+	AVLNode<Key, Value>* temp = static_cast<AVLNode<Key, Value>*>(n);
+	while (temp != NULL) {
+		++height;
+		temp = temp->getBalance() < 0 ? temp->getLeft() : temp->getRight();
+	}
+	return height;
+}
+
+/**
+* The taller child is one level below n; the other is two below if n leans.
+*/
+template<class Key, class Value>
+int AVLTree<Key, Value>::childHeightEstimate(Node<Key, Value>* n, int height, bool right) const
+{
+	int balance = static_cast<AVLNode<Key, Value>*>(n)->getBalance();
+	return (right ? balance < 0 : balance > 0) ? height - 2 : height - 1;
+}
+
+template<class Key, class Value>
+bool AVLTree<Key, Value>::sharesNodesWith(const AVLTree<Key, Value>& other) const
+{
+	return typeid(*this) == typeid(other) && nodeSource() == other.nodeSource();
+}
+
+template<class Key, class Value>
+void AVLTree<Key, Value>::extractNode(AVLNode<Key, Value>* n)
+{
+	detachNode(n);
+}
+
+/**
+* The same descent as insert, but linking n instead of a new node.
+*/
+template<class Key, class Value>
+bool AVLTree<Key, Value>::insertNode(AVLNode<Key, Value>* n)
+{
+	AVLNode<Key, Value>* temp = static_cast<AVLNode<Key, Value>*>(this->root_);
+	AVLNode<Key, Value>* p = NULL;
+	while (temp != NULL) {
+		p = temp;
+		if (temp->getKey() > n->getKey()) temp = temp->getLeft();
+		else if (temp->getKey() < n->getKey()) temp = temp->getRight();
+		else return false;
+	}
+	n->setParent(p);
+	n->setLeft(NULL);
+	n->setRight(NULL);
+	n->setBalance(0);
+	if (p == NULL) {
+		this->root_ = n;
+		updateNode(n);
+		this->noteInserted(n);
+		return true;
+	}
+	if (p->getKey() > n->getKey()) p->setLeft(n);
+	else p->setRight(n);
+	this->noteInserted(n);
+	insertLinked(n);
+	return true;
+}
+
+/**
+* Unlinks toRemove from the tree and rebalances, but leaves the node itself
+* allocated, with its links cleared, for the caller to destroy or reuse.
+*/
+template<class Key, class Value>
+void AVLTree<Key, Value>::detachNode(AVLNode<Key, Value>* toRemove)
+{
+	this->noteRemoving(toRemove);
 
 	//case for if there are 2 children
 	if (toRemove->getLeft() != NULL && toRemove->getRight() != NULL) {
@@ -241,7 +690,6 @@ void AVLTree<Key, Value>::remove(const Key& key)
 	if (toRemove->getRight() == NULL && toRemove->getLeft() == NULL) {
 			//first check if toRemove is root
 			if (p == NULL) {
-				delete toRemove;
 				this->root_ = NULL;
 				return;
 			}
@@ -250,14 +698,12 @@ void AVLTree<Key, Value>::remove(const Key& key)
 			else if (p->getLeft() == toRemove) {
 				//if toRemove is a left child then set left child of parent to NULL
 				p->setLeft(NULL);
-				delete toRemove;
 			}
 
 			//check if toRemove is a right node
 			else if (p->getRight() == toRemove) {
 				//if its a right node, set right node to NULL
 				p->setRight(NULL);
-				delete toRemove;
 			}
 	}
 
@@ -269,13 +715,11 @@ void AVLTree<Key, Value>::remove(const Key& key)
 			if (toRemove->getRight() == NULL) {
 				toRemove->getLeft()->setParent(NULL);
 				this->root_ = toRemove->getLeft();
-				delete toRemove;
 			}
 			//if has a right child
 			else if (toRemove->getLeft() == NULL) {
 				toRemove->getRight()->setParent(NULL);
 				this->root_ = toRemove->getRight();
-				delete toRemove;
 			}
 		}
 
@@ -294,7 +738,6 @@ void AVLTree<Key, Value>::remove(const Key& key)
 				p->setRight(toRemove->getRight());
 			}
 			toRemove->getRight()->setParent(p);
-			delete toRemove;
 		}
 		//
 		//if has a left child
@@ -307,9 +750,13 @@ void AVLTree<Key, Value>::remove(const Key& key)
 				p->setRight(toRemove->getLeft());
 			}
 			toRemove->getLeft()->setParent(p);
-			delete toRemove;
 		}
 	}
+	toRemove->setParent(NULL);
+	toRemove->setLeft(NULL);
+	toRemove->setRight(NULL);
+	toRemove->setBalance(0);
+	if (p != NULL) updatePath(p);
 	removeFix(p, diff);
 }
 
@@ -575,6 +1022,8 @@ void AVLTree<Key, Value>::rotateRight(AVLNode<Key,Value>* node) {
 		else {
 				node->setLeft(NULL);
 		}
+		updateNode(node);
+		updateNode(left);
 }
     
 //helper to rotate left
@@ -618,7 +1067,8 @@ void AVLTree<Key, Value>::rotateLeft(AVLNode<Key,Value>* node) {
     else {
         node->setRight(NULL);
     }
-		
+    updateNode(node);
+    updateNode(right);
 }
 
 //helper that determines zig-zig cases
@@ -0,0 +1,59 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cstdlib>
+#include "avlbst.h"
+#include "bplustree.h"
+
+using namespace std;
+
+struct Result {
+    double insertNs, findNs, scanNs;
+};
+
+template<class Tree>
+Result measure(const vector<long long>& keys, const vector<long long>& probes)
+{
+    Result r;
+    Tree tree;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t i = 0; i < keys.size(); ++i) tree.insert(make_pair(keys[i], (long long)i));
+    r.insertNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / keys.size();
+
+    long long sink = 0;
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < probes.size(); ++i) sink += tree.find(probes[i])->second;
+    r.findNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / probes.size();
+
+    start = chrono::steady_clock::now();
+    for (typename Tree::iterator it = tree.begin(); it != tree.end(); ++it) sink += it->second;
+    r.scanNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / keys.size();
+
+    if (sink == 42) cout << "";
+    return r;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 2000000;
+    mt19937_64 rng(5);
+    vector<long long> keys(n);
+    for (size_t i = 0; i < n; ++i) keys[i] = (long long)(rng() >> 1);
+    vector<long long> probes(keys);
+    shuffle(probes.begin(), probes.end(), rng);
+
+    Result avl = measure<AVLTree<long long,long long> >(keys, probes);
+    Result bp = measure<BPlusTree<long long,long long> >(keys, probes);
+    Result bp512 = measure<BPlusTree<long long,long long,512> >(keys, probes);
+
+    cout << n << " random 8-byte keys, times in ns per item" << endl;
+    cout << setw(16) << "tree" << setw(10) << "insert" << setw(10) << "find" << setw(10) << "scan" << endl;
+    cout << fixed << setprecision(1);
+    cout << setw(16) << "AVLTree" << setw(10) << avl.insertNs << setw(10) << avl.findNs << setw(10) << avl.scanNs << endl;
+    cout << setw(16) << "BPlusTree<256>" << setw(10) << bp.insertNs << setw(10) << bp.findNs << setw(10) << bp.scanNs << endl;
+    cout << setw(16) << "BPlusTree<512>" << setw(10) << bp512.insertNs << setw(10) << bp512.findNs << setw(10) << bp512.scanNs << endl;
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include <iostream>
+#include <map>
+#include <string>
+#include <cstdlib>
+#include "avlbst.h"
+#include "bplustree.h"
+#include "test-util.h"
+
+using namespace std;
+
+template<class Tree>
+bool sameContents(const Tree& tree, const map<int,int>& ref)
+{
+    map<int,int>::const_iterator r = ref.begin();
+    for (typename Tree::iterator it = tree.begin(); it != tree.end(); ++it, ++r) {
+        if (r == ref.end() || it->first != r->first || it->second != r->second) return false;
+    }
+    return r == ref.end();
+}
+
+// Runs the same workload against any tree with the BinarySearchTree API.
+template<class Tree>
+void exercise(const string& name)
+{
+    Tree tree;
+    map<int,int> ref;
+    srand(99);
+    bool found = true;
+    for (int i = 0; i < 40000; ++i) {
+        int key = rand() % 5000;
+        int op = rand() % 4;
+        if (op < 2) {
+            tree.insert(make_pair(key, i));
+            ref[key] = i;
+        }
+        else if (op == 2) {
+            tree.remove(key);
+            ref.erase(key);
+        }
+        else if ((tree.find(key) != tree.end()) != (ref.count(key) == 1)) {
+            found = false;
+        }
+    }
+    check(found, name + ": find agrees with std::map");
+    check(sameContents(tree, ref), name + ": random insert/remove agrees with std::map");
+    check(tree.isBalanced(), name + ": tree is balanced");
+
+    for (int i = 0; i < 5000; ++i) tree.remove(i);
+    check(tree.empty(), name + ": removing every key empties the tree");
+
+    for (int i = 0; i < 3000; ++i) tree.insert(make_pair(i, -i));
+    bool lookups = true;
+    for (int i = 0; i < 3000; ++i) lookups = lookups && tree[i] == -i;
+    check(lookups, name + ": ascending inserts are all found");
+
+    bool threw = false;
+    try {
+        tree[-1];
+    }
+    catch (const out_of_range&) {
+        threw = true;
+    }
+    check(threw, name + ": operator[] throws on a missing key");
+    tree.clear();
+    check(tree.empty(), name + ": clear empties the tree");
+}
+
+int main()
+{
+    BPlusTree<char,int,32> small;
+    small.insert(make_pair('a', 1));
+    small.insert(make_pair('b', 2));
+    small.insert(make_pair('c', 3));
+    small.insert(make_pair('c', 7));
+    cout << "B+ Tree contents:" << endl;
+    for (BPlusTree<char,int,32>::iterator it = small.begin(); it != small.end(); ++it) {
+        cout << it->first << " " << it->second << endl;
+    }
+    small.print();
+
+    exercise<AVLTree<int,int> >("AVLTree");
+    exercise<BPlusTree<int,int,32> >("BPlusTree<32>");
+    exercise<BPlusTree<int,int> >("BPlusTree<256>");
+    return failures == 0 ? 0 : 1;
+}
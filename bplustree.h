@@ -0,0 +1,655 @@
+#ifndef BPLUSTREE_H
+#define BPLUSTREE_H
+
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include <new>
+#include <type_traits>
+#include "simd-search.h"
+
+/**
+* A cache-conscious B+-tree with the same insert/remove/find/iterator API as
+* BinarySearchTree, so an index can switch between the two by changing its type.
+*
+* Every node keeps its keys in a sorted array sized to roughly NodeBytes bytes
+* (a few cache lines), so a lookup touches about log_B(n) nodes instead of the
+* log_2(n) a binary tree needs. Items live only in the leaves, which are
+* linked left to right so iteration is a sequential walk over leaf arrays.
+*
+* Keys need operator< and must be default constructible and assignable.
+* Iterators are invalidated by any insert or remove.
+*/
+template <typename Key, typename Value, size_t NodeBytes = 256>
+class BPlusTree
+{
+public:
+    BPlusTree();
+    ~BPlusTree();
+
+    void insert(const std::pair<const Key, Value>& keyValuePair);
+    void remove(const Key& key);
+    void clear();
+    bool isBalanced() const;
+    void print() const;
+    bool empty() const;
+    size_t size() const;
+
+    // Entries per leaf and separator keys per inner node.
+    static const size_t LeafCapacity = NodeBytes / sizeof(Key) < 4 ? 4 : NodeBytes / sizeof(Key);
+    static const size_t InnerCapacity = NodeBytes / (sizeof(Key) + sizeof(void*)) < 4 ? 4 : NodeBytes / (sizeof(Key) + sizeof(void*));
+
+protected:
+    typedef std::pair<const Key, Value> Item;
+
+    struct NodeBase {
+        bool leaf;
+        size_t count;       // number of keys
+        explicit NodeBase(bool isLeaf) : leaf(isLeaf), count(0) { }
+    };
+
+    // Both node types have one spare slot so an overflowing insert can land
+    // before the node is split.
+    struct LeafNode : public NodeBase {
+        Key keys[LeafCapacity + 1];
+        typename std::aligned_storage<sizeof(Item), alignof(Item)>::type items[LeafCapacity + 1];
+        LeafNode* next;
+        LeafNode* prev;
+
+        LeafNode() : NodeBase(true), next(NULL), prev(NULL) { }
+        ~LeafNode();
+        Item* item(size_t i) { return reinterpret_cast<Item*>(&items[i]); }
+        const Item* item(size_t i) const { return reinterpret_cast<const Item*>(&items[i]); }
+        void insertAt(size_t pos, const Key& key, const Value& value);
+        void eraseAt(size_t pos);
+        void moveTo(LeafNode* dst, size_t from);
+    };
+
+    struct InnerNode : public NodeBase {
+        Key keys[InnerCapacity + 1];
+        NodeBase* children[InnerCapacity + 2];
+        InnerNode() : NodeBase(false) { }
+    };
+
+    // One step of a root-to-leaf descent: the inner node and the child taken.
+    struct PathEntry {
+        InnerNode* node;
+        size_t child;
+    };
+
+public:
+    /**
+    * An iterator over the leaf chain.
+    */
+    class iterator
+    {
+    public:
+        iterator();
+
+        std::pair<const Key,Value>& operator*() const;
+        std::pair<const Key,Value>* operator->() const;
+
+        bool operator==(const iterator& rhs) const;
+        bool operator!=(const iterator& rhs) const;
+
+        iterator& operator++();
+
+    protected:
+        friend class BPlusTree<Key, Value, NodeBytes>;
+        iterator(LeafNode* leaf, size_t index);
+        LeafNode* leaf_;
+        size_t index_;
+    };
+
+public:
+    iterator begin() const;
+    iterator end() const;
+    iterator find(const Key& key) const;
+    Value& operator[](const Key& key);
+    Value const & operator[](const Key& key) const;
+
+protected:
+    // Position of the first key in keys[0, n) that is not less than key.
+    static size_t lowerBound(const Key* keys, size_t n, const Key& key);
+    // Position of the first key in keys[0, n) that is greater than key.
+    static size_t upperBound(const Key* keys, size_t n, const Key& key);
+
+    LeafNode* findLeaf(const Key& key, std::vector<PathEntry>* path) const;
+    void insertIntoParent(std::vector<PathEntry>& path, NodeBase* left, const Key& separator, NodeBase* right);
+    void fixLeafUnderflow(std::vector<PathEntry>& path, LeafNode* leaf);
+    void fixInnerUnderflow(std::vector<PathEntry>& path, InnerNode* node);
+    void destroy(NodeBase* node);
+    int leafDepth(NodeBase* node) const;
+    void printNode(NodeBase* node, int depth) const;
+
+    NodeBase* root_;
+    LeafNode* head_;    // leftmost leaf, where iteration starts
+    size_t size_;
+
+private:
+    BPlusTree(const BPlusTree&);
+    BPlusTree& operator=(const BPlusTree&);
+};
+
+/*
+  -----------------------------------------------
+  Begin implementations for the BPlusTree nodes.
+  -----------------------------------------------
+*/
+
+template<class Key, class Value, size_t NodeBytes>
+BPlusTree<Key, Value, NodeBytes>::LeafNode::~LeafNode()
+{
+    for (size_t i = 0; i < this->count; ++i) item(i)->~Item();
+}
+
+/**
+* Shifts items right by one from pos and constructs the new item there.
+*/
+template<class Key, class Value, size_t NodeBytes>
+void BPlusTree<Key, Value, NodeBytes>::LeafNode::insertAt(size_t pos, const Key& key, const Value& value)
+{
+    for (size_t i = this->count; i > pos; --i) {
+        keys[i] = keys[i - 1];
+        new (item(i)) Item(*item(i - 1));
+        item(i - 1)->~Item();
+    }
+    keys[pos] = key;
+    new (item(pos)) Item(key, value);
+    ++this->count;
+}
+
+/**
+* Destroys the item at pos and shifts the rest left by one.
+*/
+template<class Key, class Value, size_t NodeBytes>
+void BPlusTree<Key, Value, NodeBytes>::LeafNode::eraseAt(size_t pos)
+{
+    item(pos)->~Item();
+    for (size_t i = pos + 1; i < this->count; ++i) {
+        keys[i - 1] = keys[i];
+        new (item(i - 1)) Item(*item(i));
+        item(i)->~Item();
+    }
+    --this->count;
+}
+
+/**
+* Appends items [from, count) to dst and drops them from this leaf.
+*/
+template<class Key, class Value, size_t NodeBytes>
+void BPlusTree<Key, Value, NodeBytes>::LeafNode::moveTo(LeafNode* dst, size_t from)
+{
+    for (size_t i = from; i < this->count; ++i) {
+        dst->keys[dst->count] = keys[i];
+        new (dst->item(dst->count)) Item(*item(i));
+        item(i)->~Item();
+        ++dst->count;
+    }
+    this->count = from;
+}
+
+/*
+  ------------------------------------------------------
+  Begin implementations for the BPlusTree::iterator class.
+  ------------------------------------------------------
+*/
+
+template<class Key, class Value, size_t NodeBytes>
+BPlusTree<Key, Value, NodeBytes>::iterator::iterator() :
+    leaf_(NULL), index_(0)
+{
+
+}
+
+template<class Key, class Value, size_t NodeBytes>
+BPlusTree<Key, Value, NodeBytes>::iterator::iterator(LeafNode* leaf, size_t index) :
+    leaf_(leaf), index_(index)
+{
+
+}
+
+template<class Key, class Value, size_t NodeBytes>
+std::pair<const Key,Value>& BPlusTree<Key, Value, NodeBytes>::iterator::operator*() const
+{
+    return *leaf_->item(index_);
+}
+
+template<class Key, class Value, size_t NodeBytes>
+std::pair<const Key,Value>* BPlusTree<Key, Value, NodeBytes>::iterator::operator->() const
+{
+    return leaf_->item(index_);
+}
+
+template<class Key, class Value, size_t NodeBytes>
+bool BPlusTree<Key, Value, NodeBytes>::iterator::operator==(const iterator& rhs) const
+{
+    return leaf_ == rhs.leaf_ && index_ == rhs.index_;
+}
+
+template<class Key, class Value, size_t NodeBytes>
+bool BPlusTree<Key, Value, NodeBytes>::iterator::operator!=(const iterator& rhs) const
+{
+    return !(*this == rhs);
+}
+
+/**
+* Steps within the leaf, then follows the leaf link.
+*/
+template<class Key, class Value, size_t NodeBytes>
+typename BPlusTree<Key, Value, NodeBytes>::iterator& BPlusTree<Key, Value, NodeBytes>::iterator::operator++()
+{
+    if (++index_ >= leaf_->count) {
+        leaf_ = leaf_->next;
+        index_ = 0;
+    }
+    return *this;
+}
+
+/*
+  ----------------------------------------------
+  Begin implementations for the BPlusTree class.
+  ----------------------------------------------
+*/
+
+template<class Key, class Value, size_t NodeBytes>
+BPlusTree<Key, Value, NodeBytes>::BPlusTree() :
+    root_(NULL), head_(NULL), size_(0)
+{
+
+}
+
+template<class Key, class Value, size_t NodeBytes>
+BPlusTree<Key, Value, NodeBytes>::~BPlusTree()
+{
+    clear();
+}
+
+template<class Key, class Value, size_t NodeBytes>
+bool BPlusTree<Key, Value, NodeBytes>::empty() const
+{
+    return root_ == NULL;
+}
+
+template<class Key, class Value, size_t NodeBytes>
+size_t BPlusTree<Key, Value, NodeBytes>::size() const
+{
+    return size_;
+}
+
+template<class Key, class Value, size_t NodeBytes>
+void BPlusTree<Key, Value, NodeBytes>::clear()
+{
+    if (root_ != NULL) destroy(root_);
+    root_ = NULL;
+    head_ = NULL;
+    size_ = 0;
+}
+
+template<class Key, class Value, size_t NodeBytes>
+void BPlusTree<Key, Value, NodeBytes>::destroy(NodeBase* node)
+{
+    if (node->leaf) {
+        delete static_cast<LeafNode*>(node);
+        return;
+    }
+    InnerNode* inner = static_cast<InnerNode*>(node);
+    for (size_t i = 0; i <= inner->count; ++i) destroy(inner->children[i]);
+    delete inner;
+}
+
+/**
+* In-node searches go through the simd kernels, which count 8-16 keys per
+* compare for integral and floating-point keys and binary search otherwise.
+*/
+template<class Key, class Value, size_t NodeBytes>
+size_t BPlusTree<Key, Value, NodeBytes>::lowerBound(const Key* keys, size_t n, const Key& key)
+{
+    return simd::lowerBound(keys, n, key);
+}
+
+template<class Key, class Value, size_t NodeBytes>
+size_t BPlusTree<Key, Value, NodeBytes>::upperBound(const Key* keys, size_t n, const Key& key)
+{
+    return simd::upperBound(keys, n, key);
+}
+
+/**
+* Descends to the leaf that owns key, recording the route in path if given.
+* Child i of an inner node holds the keys k with keys[i-1] <= k < keys[i].
+*/
+template<class Key, class Value, size_t NodeBytes>
+typename BPlusTree<Key, Value, NodeBytes>::LeafNode*
+BPlusTree<Key, Value, NodeBytes>::findLeaf(const Key& key, std::vector<PathEntry>* path) const
+{
+    NodeBase* temp = root_;
+    if (temp == NULL) return NULL;
+    while (!temp->leaf) {
+        InnerNode* inner = static_cast<InnerNode*>(temp);
+        size_t child = upperBound(inner->keys, inner->count, key);
+        if (path != NULL) {
+            PathEntry step = { inner, child };
+            path->push_back(step);
+        }
+        temp = inner->children[child];
+    }
+    return static_cast<LeafNode*>(temp);
+}
+
+template<class Key, class Value, size_t NodeBytes>
+typename BPlusTree<Key, Value, NodeBytes>::iterator BPlusTree<Key, Value, NodeBytes>::begin() const
+{
+    if (head_ == NULL || head_->count == 0) return end();
+    return iterator(head_, 0);
+}
+
+template<class Key, class Value, size_t NodeBytes>
+typename BPlusTree<Key, Value, NodeBytes>::iterator BPlusTree<Key, Value, NodeBytes>::end() const
+{
+    return iterator(NULL, 0);
+}
+
+/**
+* Returns an iterator to the item with the given key, or end() if absent.
+*/
+template<class Key, class Value, size_t NodeBytes>
+typename BPlusTree<Key, Value, NodeBytes>::iterator BPlusTree<Key, Value, NodeBytes>::find(const Key& key) const
+{
+    LeafNode* leaf = findLeaf(key, NULL);
+    if (leaf == NULL) return end();
+    size_t pos = lowerBound(leaf->keys, leaf->count, key);
+    if (pos == leaf->count || key < leaf->keys[pos]) return end();
+    return iterator(leaf, pos);
+}
+
+/**
+ * @precondition The key exists in the map
+ * Returns the value associated with the key
+ */
+template<class Key, class Value, size_t NodeBytes>
+Value& BPlusTree<Key, Value, NodeBytes>::operator[](const Key& key)
+{
+    iterator it = find(key);
+    if (it == end()) throw std::out_of_range("Invalid key");
+    return it->second;
+}
+
+template<class Key, class Value, size_t NodeBytes>
+Value const & BPlusTree<Key, Value, NodeBytes>::operator[](const Key& key) const
+{
+    iterator it = find(key);
+    if (it == end()) throw std::out_of_range("Invalid key");
+    return it->second;
+}
+
+/**
+* Inserts the pair, or overwrites the value if the key exists. A full leaf is
+* split in half and the first key of the new right half is pushed up.
+*/
+template<class Key, class Value, size_t NodeBytes>
+void BPlusTree<Key, Value, NodeBytes>::insert(const std::pair<const Key, Value>& keyValuePair)
+{
+    if (root_ == NULL) {
+        head_ = new LeafNode();
+        root_ = head_;
+    }
+
+    std::vector<PathEntry> path;
+    LeafNode* leaf = findLeaf(keyValuePair.first, &path);
+    size_t pos = lowerBound(leaf->keys, leaf->count, keyValuePair.first);
+    if (pos < leaf->count && !(keyValuePair.first < leaf->keys[pos])) {
+        leaf->item(pos)->second = keyValuePair.second;
+        return;
+    }
+
+    leaf->insertAt(pos, keyValuePair.first, keyValuePair.second);
+    ++size_;
+    if (leaf->count <= LeafCapacity) return;
+
+    LeafNode* right = new LeafNode();
+    leaf->moveTo(right, leaf->count / 2);
+    right->next = leaf->next;
+    right->prev = leaf;
+    if (leaf->next != NULL) leaf->next->prev = right;
+    leaf->next = right;
+    insertIntoParent(path, leaf, right->keys[0], right);
+}
+
+/**
+* Links right in as the sibling after left with the given separator, splitting
+* inner nodes up the path as they overflow.
+*/
+template<class Key, class Value, size_t NodeBytes>
+void BPlusTree<Key, Value, NodeBytes>::insertIntoParent(std::vector<PathEntry>& path, NodeBase* left, const Key& separator, NodeBase* right)
+{
+    if (path.empty()) {
+        InnerNode* root = new InnerNode();
+        root->keys[0] = separator;
+        root->children[0] = left;
+        root->children[1] = right;
+        root->count = 1;
+        root_ = root;
+        return;
+    }
+
+    InnerNode* parent = path.back().node;
+    size_t pos = path.back().child;
+    path.pop_back();
+
+    for (size_t i = parent->count; i > pos; --i) {
+        parent->keys[i] = parent->keys[i - 1];
+        parent->children[i + 1] = parent->children[i];
+    }
+    parent->keys[pos] = separator;
+    parent->children[pos + 1] = right;
+    ++parent->count;
+    if (parent->count <= InnerCapacity) return;
+
+    //the middle key moves up; it is not kept in either half
+    InnerNode* sibling = new InnerNode();
+    size_t mid = parent->count / 2;
+    Key up = parent->keys[mid];
+    for (size_t i = mid + 1; i < parent->count; ++i) {
+        sibling->keys[sibling->count] = parent->keys[i];
+        sibling->children[sibling->count] = parent->children[i];
+        ++sibling->count;
+    }
+    sibling->children[sibling->count] = parent->children[parent->count];
+    parent->count = mid;
+    insertIntoParent(path, parent, up, sibling);
+}
+
+/**
+* Removes the key if present. Leaves that fall below half full borrow from or
+* merge with a sibling under the same parent.
+*/
+template<class Key, class Value, size_t NodeBytes>
+void BPlusTree<Key, Value, NodeBytes>::remove(const Key& key)
+{
+    std::vector<PathEntry> path;
+    LeafNode* leaf = findLeaf(key, &path);
+    if (leaf == NULL) return;
+    size_t pos = lowerBound(leaf->keys, leaf->count, key);
+    if (pos == leaf->count || key < leaf->keys[pos]) return;
+
+    leaf->eraseAt(pos);
+    --size_;
+
+    if (path.empty()) {
+        //the root is a leaf, which may shrink all the way down to nothing
+        if (leaf->count == 0) clear();
+        return;
+    }
+    if (leaf->count < (LeafCapacity + 1) / 2) fixLeafUnderflow(path, leaf);
+}
+
+template<class Key, class Value, size_t NodeBytes>
+void BPlusTree<Key, Value, NodeBytes>::fixLeafUnderflow(std::vector<PathEntry>& path, LeafNode* leaf)
+{
+    const size_t minCount = (LeafCapacity + 1) / 2;
+    InnerNode* parent = path.back().node;
+    size_t idx = path.back().child;
+    LeafNode* left = idx > 0 ? static_cast<LeafNode*>(parent->children[idx - 1]) : NULL;
+    LeafNode* right = idx < parent->count ? static_cast<LeafNode*>(parent->children[idx + 1]) : NULL;
+
+    //borrow the largest item from the left sibling
+    if (left != NULL && left->count > minCount) {
+        size_t last = left->count - 1;
+        leaf->insertAt(0, left->keys[last], left->item(last)->second);
+        left->eraseAt(last);
+        parent->keys[idx - 1] = leaf->keys[0];
+        return;
+    }
+    //borrow the smallest item from the right sibling
+    if (right != NULL && right->count > minCount) {
+        leaf->insertAt(leaf->count, right->keys[0], right->item(0)->second);
+        right->eraseAt(0);
+        parent->keys[idx] = right->keys[0];
+        return;
+    }
+
+    //merge the right one of the pair into the left one
+    LeafNode* dst = left != NULL ? left : leaf;
+    LeafNode* src = left != NULL ? leaf : right;
+    size_t sepIndex = left != NULL ? idx - 1 : idx;
+    src->moveTo(dst, 0);
+    dst->next = src->next;
+    if (src->next != NULL) src->next->prev = dst;
+    delete src;
+
+    for (size_t i = sepIndex; i + 1 < parent->count; ++i) {
+        parent->keys[i] = parent->keys[i + 1];
+        parent->children[i + 1] = parent->children[i + 2];
+    }
+    --parent->count;
+    path.pop_back();
+    fixInnerUnderflow(path, parent);
+}
+
+template<class Key, class Value, size_t NodeBytes>
+void BPlusTree<Key, Value, NodeBytes>::fixInnerUnderflow(std::vector<PathEntry>& path, InnerNode* node)
+{
+    if (path.empty()) {
+        //an inner root with a single child hands the root down
+        if (node->count == 0) {
+            root_ = node->children[0];
+            delete node;
+        }
+        return;
+    }
+
+    const size_t minCount = InnerCapacity / 2;
+    if (node->count >= minCount) return;
+
+    InnerNode* parent = path.back().node;
+    size_t idx = path.back().child;
+    InnerNode* left = idx > 0 ? static_cast<InnerNode*>(parent->children[idx - 1]) : NULL;
+    InnerNode* right = idx < parent->count ? static_cast<InnerNode*>(parent->children[idx + 1]) : NULL;
+
+    //rotate a key through the parent from the left sibling
+    if (left != NULL && left->count > minCount) {
+        for (size_t i = node->count; i > 0; --i) node->keys[i] = node->keys[i - 1];
+        for (size_t i = node->count + 1; i > 0; --i) node->children[i] = node->children[i - 1];
+        node->keys[0] = parent->keys[idx - 1];
+        node->children[0] = left->children[left->count];
+        ++node->count;
+        parent->keys[idx - 1] = left->keys[left->count - 1];
+        --left->count;
+        return;
+    }
+    //rotate a key through the parent from the right sibling
+    if (right != NULL && right->count > minCount) {
+        node->keys[node->count] = parent->keys[idx];
+        node->children[node->count + 1] = right->children[0];
+        ++node->count;
+        parent->keys[idx] = right->keys[0];
+        for (size_t i = 0; i + 1 < right->count; ++i) right->keys[i] = right->keys[i + 1];
+        for (size_t i = 0; i < right->count; ++i) right->children[i] = right->children[i + 1];
+        --right->count;
+        return;
+    }
+
+    //merge: the separator comes down between the two halves
+    InnerNode* dst = left != NULL ? left : node;
+    InnerNode* src = left != NULL ? node : right;
+    size_t sepIndex = left != NULL ? idx - 1 : idx;
+    dst->keys[dst->count] = parent->keys[sepIndex];
+    ++dst->count;
+    for (size_t i = 0; i < src->count; ++i) {
+        dst->keys[dst->count] = src->keys[i];
+        dst->children[dst->count] = src->children[i];
+        ++dst->count;
+    }
+    dst->children[dst->count] = src->children[src->count];
+    delete src;
+
+    for (size_t i = sepIndex; i + 1 < parent->count; ++i) {
+        parent->keys[i] = parent->keys[i + 1];
+        parent->children[i + 1] = parent->children[i + 2];
+    }
+    --parent->count;
+    path.pop_back();
+    fixInnerUnderflow(path, parent);
+}
+
+/**
+* Returns the depth of the leaves under node, or -1 if they differ.
+*/
+template<class Key, class Value, size_t NodeBytes>
+int BPlusTree<Key, Value, NodeBytes>::leafDepth(NodeBase* node) const
+{
+    if (node->leaf) return 0;
+    InnerNode* inner = static_cast<InnerNode*>(node);
+    int depth = leafDepth(inner->children[0]);
+    for (size_t i = 1; i <= inner->count && depth >= 0; ++i) {
+        if (leafDepth(inner->children[i]) != depth) return -1;
+    }
+    return depth < 0 ? -1 : depth + 1;
+}
+
+/**
+* Return true iff every leaf is at the same depth.
+*/
+template<class Key, class Value, size_t NodeBytes>
+bool BPlusTree<Key, Value, NodeBytes>::isBalanced() const
+{
+    return root_ == NULL || leafDepth(root_) >= 0;
+}
+
+/**
+* Prints one line per node, indented by depth, with the node's keys.
+*/
+template<class Key, class Value, size_t NodeBytes>
+void BPlusTree<Key, Value, NodeBytes>::print() const
+{
+    if (root_ == NULL) std::cout << "<empty tree>" << std::endl;
+    else printNode(root_, 0);
+    std::cout << "\n";
+}
+
+template<class Key, class Value, size_t NodeBytes>
+void BPlusTree<Key, Value, NodeBytes>::printNode(NodeBase* node, int depth) const
+{
+    std::cout << std::string(depth * 2, ' ') << (node->leaf ? "leaf [" : "inner [");
+    const Key* keys = node->leaf ? static_cast<LeafNode*>(node)->keys : static_cast<InnerNode*>(node)->keys;
+    for (size_t i = 0; i < node->count; ++i) {
+        std::cout << (i ? " " : "") << keys[i];
+    }
+    std::cout << "]" << std::endl;
+    if (!node->leaf) {
+        InnerNode* inner = static_cast<InnerNode*>(node);
+        for (size_t i = 0; i <= inner->count; ++i) printNode(inner->children[i], depth + 1);
+    }
+}
+
+/*
+  --------------------------------------------
+  End implementations for the BPlusTree class.
+  --------------------------------------------
+*/
+
+#endif
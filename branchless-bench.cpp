@@ -0,0 +1,128 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "avlbst.h"
+
+using namespace std;
+
+double msSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+* A hardware counter for this process's user-space branch misses, through
+* perf_event_open. Containers and VMs often hide the PMU; then valid() is
+* false and the benchmark reports times only.
+*/
+class BranchMissCounter
+{
+public:
+    BranchMissCounter() : fd_(-1)
+    {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+
+    ~BranchMissCounter()
+    {
+        if (fd_ >= 0) close(fd_);
+    }
+
+    bool valid() const { return fd_ >= 0; }
+
+    void start()
+    {
+        if (fd_ < 0) return;
+        ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    long long stop()
+    {
+        if (fd_ < 0) return -1;
+        ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+        long long count = 0;
+        if (read(fd_, &count, sizeof(count)) != (ssize_t)sizeof(count)) return -1;
+        return count;
+    }
+
+private:
+    int fd_;
+};
+
+// The same integers behind a class, which keeps the branching descent.
+struct BoxedKey {
+    long long v;
+    BoxedKey(long long x = 0) : v(x) { }
+    bool operator==(const BoxedKey& rhs) const { return v == rhs.v; }
+    bool operator<(const BoxedKey& rhs) const { return v < rhs.v; }
+    bool operator>(const BoxedKey& rhs) const { return v > rhs.v; }
+};
+
+ostream& operator<<(ostream& out, const BoxedKey& k)
+{
+    return out << k.v;
+}
+
+template<class Key>
+void run(const char* name, const vector<long long>& keys, const vector<long long>& probes)
+{
+    AVLTree<Key, int> tree;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t i = 0; i < keys.size(); ++i) tree.insert(make_pair(Key(keys[i]), (int)i));
+    double insertMs = msSince(start);
+
+    BranchMissCounter counter;
+    counter.start();
+    start = chrono::steady_clock::now();
+    size_t hits = 0;
+    for (size_t i = 0; i < probes.size(); ++i) hits += tree.find(Key(probes[i])) != tree.end();
+    double findMs = msSince(start);
+    long long misses = counter.stop();
+
+    cout << fixed << setprecision(1);
+    cout << name << "insert " << insertMs << " ms, find " << findMs << " ms (" << hits << " hits), ";
+    if (misses >= 0) cout << setprecision(2) << (double)misses / probes.size() << " branch misses/find" << endl;
+    else cout << "branch misses n/a" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    size_t lookups = argc > 2 ? strtoul(argv[2], NULL, 10) : 2000000;
+
+    mt19937_64 rng(47);
+    vector<long long> keys(n);
+    for (size_t i = 0; i < n; ++i) keys[i] = (long long)(rng() >> 2) * 2;
+    vector<long long> probes(lookups);
+    for (size_t i = 0; i < lookups; ++i) probes[i] = keys[rng() % n] + (long long)(rng() % 2);
+
+    if (!BranchMissCounter().valid()) cout << "perf_event_open unavailable; reporting times only" << endl;
+    cout << n << " random keys, " << lookups << " lookups (half present)" << endl;
+    run<BoxedKey>("branching:   ", keys, probes);
+    run<long long>("branchless:  ", keys, probes);
+    // a tree that fits in cache, where mispredictions rather than misses dominate
+    vector<long long> few(keys.begin(), keys.begin() + min<size_t>(n, 4096));
+    vector<long long> fewProbes(lookups);
+    for (size_t i = 0; i < lookups; ++i) fewProbes[i] = few[rng() % few.size()] + (long long)(rng() % 2);
+    cout << few.size() << " keys:" << endl;
+    run<BoxedKey>("branching:   ", few, fewProbes);
+    run<long long>("branchless:  ", few, fewProbes);
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include <iostream>
+#include <map>
+#include <cstdlib>
+#include "bst.h"
+#include "avlbst.h"
+#include "test-util.h"
+
+using namespace std;
+
+// Not arithmetic, so trees over it keep the branching descent.
+struct BoxedKey {
+    int v;
+    BoxedKey(int x = 0) : v(x) { }
+    bool operator==(const BoxedKey& rhs) const { return v == rhs.v; }
+    bool operator<(const BoxedKey& rhs) const { return v < rhs.v; }
+    bool operator>(const BoxedKey& rhs) const { return v > rhs.v; }
+};
+
+ostream& operator<<(ostream& out, const BoxedKey& k)
+{
+    return out << k.v;
+}
+
+// Random inserts, removes and finds against std::map, for any key type
+// that converts from int.
+template<class Key, class Tree>
+bool matchesMap(Tree& tree, int range, int steps)
+{
+    map<int, int> ref;
+    bool ok = true;
+    for (int step = 0; step < steps; ++step) {
+        int key = rand() % range - range / 2;
+        int op = rand() % 4;
+        if (op == 0) {
+            tree.remove(Key(key));
+            ref.erase(key);
+        }
+        else if (op == 1) {
+            bool present = tree.find(Key(key)) != tree.end();
+            ok = ok && present == (ref.count(key) == 1);
+            if (present) ok = ok && tree[Key(key)] == ref[key];
+        }
+        else {
+            tree.insert(make_pair(Key(key), step));
+            ref[key] = step;
+        }
+    }
+    typename Tree::iterator it = tree.begin();
+    for (map<int, int>::iterator r = ref.begin(); r != ref.end(); ++r, ++it) {
+        ok = ok && it != tree.end() && it->first == Key(r->first) && it->second == r->second;
+    }
+    return ok && it == tree.end();
+}
+
+int main()
+{
+    srand(47);
+    AVLTree<long long, int> wide;
+    check(matchesMap<long long>(wide, 2000, 30000) && wide.isBalanced(), "long long keys");
+    AVLTree<int, int> narrow;
+    check(matchesMap<int>(narrow, 2000, 30000) && narrow.isBalanced(), "int keys, negative and positive");
+    AVLTree<signed char, int> bytes;
+    check(matchesMap<signed char>(bytes, 256, 5000) && bytes.isBalanced(), "signed char keys");
+    AVLTree<double, int> reals;
+    check(matchesMap<double>(reals, 2000, 30000) && reals.isBalanced(), "double keys");
+    AVLTree<BoxedKey, int> boxed;
+    check(matchesMap<BoxedKey>(boxed, 2000, 30000) && boxed.isBalanced(), "class keys take the branching descent");
+    BinarySearchTree<long long, int> plain;
+    check(matchesMap<long long>(plain, 2000, 10000), "BinarySearchTree with long long keys");
+
+    Node<int, int> parent(5, 0, NULL), left(3, 0, &parent), right(8, 0, &parent);
+    parent.setLeft(&left);
+    parent.setRight(&right);
+    check(parent.getChild(false) == &left && parent.getChild(true) == &right && left.getChild(true) == NULL,
+        "getChild picks the side");
+
+    return failures == 0 ? 0 : 1;
+}
@@ -4,7 +4,11 @@
 #include <iostream>
 #include <exception>
 #include <cstdlib>
+#include <cstdint>
+#include <cmath>
 #include <utility>
+#include <vector>
+#include <type_traits>
 
 /**
  * A templated class for a Node in a search tree.
@@ -29,6 +33,9 @@ public:
     virtual Node<Key, Value>* getParent() const;
     virtual Node<Key, Value>* getLeft() const;
     virtual Node<Key, Value>* getRight() const;
+    // The right child if right is true, else the left; not virtual, so a
+    // descent can pick the side straight from a compare result.
+    Node<Key, Value>* getChild(bool right) const;
 
     void setParent(Node<Key, Value>* parent);
     void setLeft(Node<Key, Value>* left);
@@ -144,6 +151,18 @@ Node<Key, Value>* Node<Key, Value>::getRight() const
     return right_;
 }
 
+/**
+* Blends the two links with a mask instead of branching on right, so the
+* choice costs no misprediction however random the compares are.
+*/
+template<typename Key, typename Value>
+Node<Key, Value>* Node<Key, Value>::getChild(bool right) const
+{
+    uintptr_t mask = (uintptr_t)0 - (uintptr_t)right;
+    return reinterpret_cast<Node<Key, Value>*>(
+        (reinterpret_cast<uintptr_t>(left_) & ~mask) | (reinterpret_cast<uintptr_t>(right_) & mask));
+}
+
 /**
 * A setter for setting the parent of a node.
 */
@@ -231,6 +250,27 @@ public:
     iterator begin() const;
     iterator end() const;
     iterator find(const Key& key) const;
+    // The smallest and largest items in O(1), or end() if the tree is empty.
+    iterator min() const;
+    iterator max() const;
+    // Finger search: start from a node near key instead of from the root,
+    // climbing only until key is inside the current subtree and then
+    // descending. For a key d positions from the start this is usually
+    // O(log d), so sorted batches of lookups and merge-joins stay cheap.
+    // find(key, hint) starts from a caller-held iterator (end() means the
+    // root). findNear starts from, and then moves, a finger kept in the tree:
+    // the node found, or the last node visited on a miss. findNear writes
+    // that finger, so unlike find it must not run concurrently with itself.
+    iterator find(const Key& key, const iterator& hint) const;
+    iterator findNear(const Key& key) const;
+    // Splits the items into at most k consecutive, disjoint, non-empty
+    // ranges [first, second) that cover the tree in key order, for handing
+    // to separate threads. A tree that knows its subtree sizes cuts by rank
+    // and the ranges differ by at most one item; otherwise the cuts fall on
+    // subtree boundaries near the top, even for a balanced tree. Fewer than
+    // k ranges come back only when the tree holds fewer than k items (or,
+    // for an unbalanced tree, has too few nodes near the top).
+    std::vector<std::pair<iterator, iterator> > partition(size_t k) const;
     Value& operator[](const Key& key);
     Value const & operator[](const Key& key) const;
 
@@ -238,7 +278,41 @@ protected:
     // Mandatory helper functions
     Node<Key, Value>* internalFind(const Key& k) const; // TODO
     Node<Key, Value> *getSmallestNode() const;  // TODO
+    // Only the tree can see inside an iterator; these let subclasses do too.
+    static Node<Key, Value>* nodeOf(const iterator& it);
+    static iterator iteratorOf(Node<Key, Value>* n);
     static Node<Key, Value>* predecessor(Node<Key, Value>* current); // TODO
+    static Node<Key, Value>* successor(Node<Key, Value>* current);
+    // Finds key from the root. last is set to the node found, or to the
+    // node the key would hang under if absent (NULL for an empty tree).
+    // Arithmetic keys take a descent without data-dependent branches.
+    Node<Key, Value>* descend(const Key& key, Node<Key, Value>*& last) const;
+    Node<Key, Value>* descend(const Key& key, Node<Key, Value>*& last, std::true_type) const;
+    Node<Key, Value>* descend(const Key& key, Node<Key, Value>*& last, std::false_type) const;
+    // Finds key starting from finger (the root if NULL). last is set to the
+    // node found, or to the last node visited if key is absent.
+    Node<Key, Value>* fingerFind(Node<Key, Value>* finger, const Key& key, Node<Key, Value>*& last) const;
+    // Trees that keep subtree sizes override this to report the number of
+    // items under n (0 for NULL) and return true; partition then cuts by rank.
+    virtual bool subtreeSize(Node<Key, Value>* n, size_t& size) const;
+    // The node at position rank in key order, by subtree sizes.
+    Node<Key, Value>* nodeAtRank(size_t rank) const;
+    // About the height of the subtree at n (0 for NULL), or -1 if the tree
+    // cannot tell in O(log n), as by default. Trees that can override this
+    // so partition cuts by height, and childHeightEstimate too if a child's
+    // height follows from n's more cheaply than from scratch.
+    virtual int heightEstimate(Node<Key, Value>* n) const;
+    virtual int childHeightEstimate(Node<Key, Value>* n, int height, bool right) const;
+    // Called before a walk over the whole tree starts, so trees that defer
+    // work on values (see LazyAVLTree) can finish it first. Does nothing by
+    // default.
+    virtual void prepareScan() const;
+    // Appends, in key order, the top nodes under n to top, and the estimated
+    // size of each subtree between them to gaps, so gaps gains one more
+    // entry than top. Top nodes are those taller than limit or, where
+    // heights are unknown (height -1), those in the top limit levels.
+    void topNodes(Node<Key, Value>* n, int height, int limit,
+        std::vector<Node<Key, Value>*>& top, std::vector<double>& gaps) const;
     // Note:  static means these functions don't have a "this" pointer
     //        and instead just use the input argument.
 
@@ -250,11 +324,22 @@ protected:
 	int getHeight(Node<Key, Value>* root) const; //gets height of tree to assist isBalanced()
 	bool isBalancedHelper(Node<Key, Value>* root) const; //uses getHeight recursively to determine whether tree is balanced
 
+    // Keep leftmost_ and rightmost_ current. Every tree calls noteInserted on
+    // a node it has just linked in and noteRemoving on a node it is about to
+    // unlink; rotations and nodeSwap move nodes but never change which node
+    // is first or last. Code that builds or relinks whole subtrees at once
+    // calls resetExtremes instead, which also drops the findNear finger.
+    void noteInserted(Node<Key, Value>* n);
+    void noteRemoving(Node<Key, Value>* n);
+    void resetExtremes();
+
 
 
 protected:
     Node<Key, Value>* root_;
-    // You should not need other data members
+    Node<Key, Value>* leftmost_;    // smallest item, NULL when empty
+    Node<Key, Value>* rightmost_;   // largest item, NULL when empty
+    mutable Node<Key, Value>* finger_;  // where findNear starts, or NULL
 };
 
 /*
@@ -387,6 +472,9 @@ BinarySearchTree<Key, Value>::BinarySearchTree()
 {
     // TODO
     root_ = NULL;
+    leftmost_ = NULL;
+    rightmost_ = NULL;
+    finger_ = NULL;
 }
 
 template<typename Key, typename Value>
@@ -419,10 +507,38 @@ template<class Key, class Value>
 typename BinarySearchTree<Key, Value>::iterator
 BinarySearchTree<Key, Value>::begin() const
 {
+    prepareScan();
     BinarySearchTree<Key, Value>::iterator begin(getSmallestNode());
     return begin;
 }
 
+template<class Key, class Value>
+typename BinarySearchTree<Key, Value>::iterator
+BinarySearchTree<Key, Value>::min() const
+{
+    return iterator(leftmost_);
+}
+
+template<class Key, class Value>
+typename BinarySearchTree<Key, Value>::iterator
+BinarySearchTree<Key, Value>::max() const
+{
+    return iterator(rightmost_);
+}
+
+template<class Key, class Value>
+Node<Key, Value>* BinarySearchTree<Key, Value>::nodeOf(const iterator& it)
+{
+    return it.current_;
+}
+
+template<class Key, class Value>
+typename BinarySearchTree<Key, Value>::iterator
+BinarySearchTree<Key, Value>::iteratorOf(Node<Key, Value>* n)
+{
+    return iterator(n);
+}
+
 /**
 * Returns an iterator whose value means INVALID
 */
@@ -447,6 +563,89 @@ BinarySearchTree<Key, Value>::find(const Key & k) const
     return it;
 }
 
+template<class Key, class Value>
+typename BinarySearchTree<Key, Value>::iterator
+BinarySearchTree<Key, Value>::find(const Key& key, const iterator& hint) const
+{
+    Node<Key, Value>* last = NULL;
+    return iterator(fingerFind(hint.current_, key, last));
+}
+
+template<class Key, class Value>
+typename BinarySearchTree<Key, Value>::iterator
+BinarySearchTree<Key, Value>::findNear(const Key& key) const
+{
+    Node<Key, Value>* found = fingerFind(finger_, key, finger_);
+    return iterator(found);
+}
+
+/**
+* Without sizes, ranks are estimated. Where the tree knows its heights,
+* the top nodes are the ones taller than a limit, and the subtrees hanging
+* between them are taken to hold 2^height - 1 items each. Cutting by
+* height rather than depth matters: a few levels down an AVL tree,
+* subtrees can differ in size several times over, while subtrees of equal
+* height are close. Other trees fall back to the nodes in the top levels,
+* counting each subtree below them alike. Cuts go at the top nodes where
+* the running estimate crosses each k-th of the total, and top nodes are
+* added until there are about four per range.
+*/
+template<class Key, class Value>
+std::vector<std::pair<typename BinarySearchTree<Key, Value>::iterator, typename BinarySearchTree<Key, Value>::iterator> >
+BinarySearchTree<Key, Value>::partition(size_t k) const
+{
+    std::vector<std::pair<iterator, iterator> > ranges;
+    if (root_ == NULL) return ranges;
+    if (k == 0) k = 1;
+    //the ranges go to other threads, so deferred work must be done here, in one
+    prepareScan();
+
+    std::vector<Node<Key, Value>*> cuts;
+    size_t total = 0;
+    if (subtreeSize(root_, total)) {
+        if (k > total) k = total;
+        for (size_t i = 1; i < k; ++i) {
+            cuts.push_back(nodeAtRank(i * total / k));
+        }
+    }
+    else {
+        std::vector<Node<Key, Value>*> top;
+        std::vector<double> gaps;
+        int height = heightEstimate(root_);
+        //a balanced tree needs about log2(4k) levels, so start just short of that
+        int level = 1;
+        while (((size_t)1 << (level + 1)) < 4 * k) ++level;
+        for (; ; ++level) {
+            size_t before = top.size();
+            top.clear();
+            gaps.clear();
+            topNodes(root_, height, height >= 0 ? height - level : level, top, gaps);
+            if (top.size() >= 4 * k || top.size() == before) break;
+        }
+        double estimate = top.size();
+        for (size_t j = 0; j < gaps.size(); ++j) estimate += gaps[j];
+
+        //items before top[j] are gaps[0..j] and top[0..j-1]
+        double before = 0;
+        size_t i = 1;
+        for (size_t j = 0; j < top.size() && i < k; ++j) {
+            before += gaps[j];
+            if (before + j >= estimate * i / k) {
+                if (before + j > 0) cuts.push_back(top[j]);
+                while (i < k && before + j >= estimate * i / k) ++i;
+            }
+        }
+    }
+
+    iterator first = begin();
+    for (size_t i = 0; i < cuts.size(); ++i) {
+        ranges.push_back(std::make_pair(first, iterator(cuts[i])));
+        first = iterator(cuts[i]);
+    }
+    ranges.push_back(std::make_pair(first, end()));
+    return ranges;
+}
+
 /**
  * @precondition The key exists in the map
  * Returns the value associated with the key
@@ -480,6 +679,7 @@ void BinarySearchTree<Key, Value>::insert(const std::pair<const Key, Value> &key
         //if tree is empty, create a new node and add it as root
         Node<Key, Value>* nodeToAdd = new Node<Key, Value>(keyValuePair.first, keyValuePair.second, NULL);
         this->root_ = nodeToAdd;
+        noteInserted(nodeToAdd);
     }
 
     else if (internalFind(keyValuePair.first) != NULL) {
@@ -511,6 +711,7 @@ void BinarySearchTree<Key, Value>::insert(const std::pair<const Key, Value> &key
         else if (keyValuePair.first > parent->getKey()) {
             parent->setRight(nodeToAdd);
         }
+        noteInserted(nodeToAdd);
     }
 }
 
@@ -526,6 +727,7 @@ void BinarySearchTree<Key, Value>::remove(const Key& key)
     // TODO
     Node<Key, Value>* toRemove = internalFind(key);
 		if (toRemove == NULL) return;
+		noteRemoving(toRemove);
 		
 		//if node has two children, swap with predecessor to ensure node has 0 or 1 children after swap
     if (toRemove->getRight() != NULL && toRemove->getLeft() != NULL) {
@@ -647,6 +849,62 @@ BinarySearchTree<Key, Value>::predecessor(Node<Key, Value>* current)
 }
 
 
+/**
+* The in-order successor of current, or NULL if it is the largest node.
+*/
+template<class Key, class Value>
+Node<Key, Value>*
+BinarySearchTree<Key, Value>::successor(Node<Key, Value>* current)
+{
+    Node<Key, Value>* temp = current;
+    if (temp->getRight() != NULL) {
+        temp = temp->getRight();
+        while (temp->getLeft() != NULL) temp = temp->getLeft();
+        return temp;
+    }
+    while (temp->getParent() != NULL && temp == temp->getParent()->getRight()) {
+        temp = temp->getParent();
+    }
+    return temp->getParent();
+}
+
+/**
+* Updates the cached extremes after n was linked into the tree.
+*/
+template<class Key, class Value>
+void BinarySearchTree<Key, Value>::noteInserted(Node<Key, Value>* n)
+{
+    if (leftmost_ == NULL || n->getKey() < leftmost_->getKey()) leftmost_ = n;
+    if (rightmost_ == NULL || rightmost_->getKey() < n->getKey()) rightmost_ = n;
+}
+
+/**
+* Updates the cached extremes before n is unlinked. The smallest node has no
+* left child, so its successor is at most a short walk away (in an AVL tree,
+* its right child or its parent); likewise for the largest.
+*/
+template<class Key, class Value>
+void BinarySearchTree<Key, Value>::noteRemoving(Node<Key, Value>* n)
+{
+    if (n == leftmost_) leftmost_ = successor(n);
+    if (n == rightmost_) rightmost_ = predecessor(n);
+    if (n == finger_) finger_ = NULL;
+}
+
+/**
+* Recomputes the cached extremes by walking both spines.
+*/
+template<class Key, class Value>
+void BinarySearchTree<Key, Value>::resetExtremes()
+{
+    leftmost_ = root_;
+    rightmost_ = root_;
+    finger_ = NULL;
+    if (root_ == NULL) return;
+    while (leftmost_->getLeft() != NULL) leftmost_ = leftmost_->getLeft();
+    while (rightmost_->getRight() != NULL) rightmost_ = rightmost_->getRight();
+}
+
 /**
 * A method to remove all contents of the tree and
 * reset the values in the tree for use again.
@@ -661,18 +919,13 @@ void BinarySearchTree<Key, Value>::clear()
 
 
 /**
-* A helper function to find the smallest node in the tree.
+* A helper function to find the smallest node in the tree, or NULL if it is
+* empty. The node is cached, so this no longer walks the left spine.
 */
 template<typename Key, typename Value>
 Node<Key, Value>* BinarySearchTree<Key, Value>::getSmallestNode() const
 {
-    Node<Key, Value>* temp = root_;
-
-    while (temp->getLeft() != NULL) {
-        temp = temp->getLeft();
-    }
-
-    return temp;
+    return leftmost_;
 }
 
 /**
@@ -682,17 +935,163 @@ Node<Key, Value>* BinarySearchTree<Key, Value>::getSmallestNode() const
 */
 template<typename Key, typename Value>
 Node<Key, Value>* BinarySearchTree<Key, Value>::internalFind(const Key& key) const
+{
+    Node<Key, Value>* last = NULL;
+    return descend(key, last);
+}
+
+template<typename Key, typename Value>
+Node<Key, Value>* BinarySearchTree<Key, Value>::descend(const Key& key, Node<Key, Value>*& last) const
+{
+    return descend(key, last, typename std::is_arithmetic<Key>::type());
+}
+
+/**
+* On random keys the left/right choice is a coin flip the branch predictor
+* loses half the time, so it goes through getChild instead. The equality
+* test stays a branch: it is false at every level but the last, which the
+* predictor gets right.
+*/
+template<typename Key, typename Value>
+Node<Key, Value>* BinarySearchTree<Key, Value>::descend(const Key& key, Node<Key, Value>*& last,
+    std::true_type) const
 {
     Node<Key, Value>* temp = this->root_;
+    last = NULL;
+    while (temp != NULL) {
+        last = temp;
+        const Key k = temp->getKey();
+        if (k == key) return temp;
+        temp = temp->getChild(k < key);
+    }
+    return NULL;
+}
+
+template<typename Key, typename Value>
+Node<Key, Value>* BinarySearchTree<Key, Value>::descend(const Key& key, Node<Key, Value>*& last,
+    std::false_type) const
+{
+    Node<Key, Value>* temp = this->root_;
+    last = NULL;
 
     //classic binary search algorithm but just traversing the tree based on if the value is larger or smaller than current node
     while (temp != NULL) {
+        last = temp;
+        const Key& k = temp->getKey();
+        if (k == key) return temp;
+        else if (k < key) temp = temp->getRight();
+        else temp = temp->getLeft();
+    }
+    return NULL;
+}
+
+/**
+* Climbs from finger until key must be inside the current subtree, then
+* descends as internalFind does. Going right, a right child's whole subtree
+* lies below key already, so the climb only stops at a left child whose
+* parent is above key; going left is the mirror image.
+*/
+template<class Key, class Value>
+Node<Key, Value>* BinarySearchTree<Key, Value>::fingerFind(Node<Key, Value>* finger, const Key& key,
+    Node<Key, Value>*& last) const
+{
+    Node<Key, Value>* temp = finger != NULL ? finger : root_;
+    last = temp;
+    if (temp == NULL) return NULL;
+
+    if (temp->getKey() < key) {
+        while (temp->getParent() != NULL) {
+            Node<Key, Value>* parent = temp->getParent();
+            if (temp == parent->getLeft() && parent->getKey() > key) break;
+            temp = parent;
+            if (temp->getKey() == key) {
+                last = temp;
+                return temp;
+            }
+        }
+    }
+    else if (temp->getKey() > key) {
+        while (temp->getParent() != NULL) {
+            Node<Key, Value>* parent = temp->getParent();
+            if (temp == parent->getRight() && parent->getKey() < key) break;
+            temp = parent;
+            if (temp->getKey() == key) {
+                last = temp;
+                return temp;
+            }
+        }
+    }
+
+    while (temp != NULL) {
+        last = temp;
         if (temp->getKey() == key) return temp;
         else if (temp->getKey() < key) temp = temp->getRight();
-        else if (temp->getKey() > key) temp = temp->getLeft();
+        else temp = temp->getLeft();
+    }
+    return NULL;
+}
+
+template<class Key, class Value>
+bool BinarySearchTree<Key, Value>::subtreeSize(Node<Key, Value>*, size_t&) const
+{
+    return false;
+}
+
+/**
+* Only called once subtreeSize has said sizes are available.
+*/
+template<class Key, class Value>
+Node<Key, Value>* BinarySearchTree<Key, Value>::nodeAtRank(size_t rank) const
+{
+    Node<Key, Value>* temp = root_;
+    while (temp != NULL) {
+        size_t left = 0;
+        subtreeSize(temp->getLeft(), left);
+        if (rank == left) return temp;
+        if (rank < left) temp = temp->getLeft();
+        else {
+            rank -= left + 1;
+            temp = temp->getRight();
+        }
     }
+    return NULL;
+}
 
-    return temp;    
+template<class Key, class Value>
+int BinarySearchTree<Key, Value>::heightEstimate(Node<Key, Value>*) const
+{
+    return -1;
+}
+
+template<class Key, class Value>
+int BinarySearchTree<Key, Value>::childHeightEstimate(Node<Key, Value>* n, int, bool right) const
+{
+    return heightEstimate(n->getChild(right));
+}
+
+template<class Key, class Value>
+void BinarySearchTree<Key, Value>::prepareScan() const
+{
+
+}
+
+template<class Key, class Value>
+void BinarySearchTree<Key, Value>::topNodes(Node<Key, Value>* n, int height, int limit,
+    std::vector<Node<Key, Value>*>& top, std::vector<double>& gaps) const
+{
+    if (n == NULL) {
+        gaps.push_back(0);
+        return;
+    }
+    bool known = height >= 0;
+    if (known ? height <= limit : limit <= 0) {
+        gaps.push_back(known ? std::ldexp(1.0, height) - 1 : 1);
+        return;
+    }
+    int below = known ? limit : limit - 1;
+    topNodes(n->getLeft(), known ? childHeightEstimate(n, height, false) : -1, below, top, gaps);
+    top.push_back(n);
+    topNodes(n->getRight(), known ? childHeightEstimate(n, height, true) : -1, below, top, gaps);
 }
 
 /**
@@ -0,0 +1,104 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include "compact-tree.h"
+
+using namespace std;
+
+double msSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// Random lookups and a full in-order scan.
+void measure(const char* name, const CompactAVLTree<long long, long long>& tree, const vector<long long>& probes)
+{
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    size_t hits = 0;
+    for (size_t i = 0; i < probes.size(); ++i) hits += tree.find(probes[i]) != tree.end();
+    double findMs = msSince(start);
+
+    start = chrono::steady_clock::now();
+    long long sum = 0;
+    for (int pass = 0; pass < 5; ++pass) {
+        for (CompactAVLTree<long long, long long>::iterator it = tree.begin(); it != tree.end(); ++it) sum += it->second;
+    }
+    double scanMs = msSince(start) / 5;
+
+    cout << fixed << setprecision(1);
+    cout << name << "find " << findMs << " ms (" << hits << " hits), scan " << scanMs << " ms" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    size_t lookups = argc > 2 ? strtoul(argv[2], NULL, 10) : 2000000;
+    size_t slice = argc > 3 ? strtoul(argv[3], NULL, 10) : 4096;
+    mt19937_64 rng(49);
+
+    // churn: the tree grows and shrinks while other allocations come and go,
+    // so its nodes end up scattered the way a long-lived service's would
+    CompactAVLTree<long long, long long> tree;
+    vector<long long> live;
+    vector<vector<char>*> noise;
+    for (size_t i = 0; i < 3 * n; ++i) {
+        long long key = (long long)(rng() % (4 * n));
+        if (rng() % 3 == 0 && !live.empty()) {
+            size_t at = rng() % live.size();
+            tree.remove(live[at]);
+            live[at] = live.back();
+            live.pop_back();
+        }
+        else {
+            tree.insert(make_pair(key, key));
+            live.push_back(key);
+        }
+        if (rng() % 4 == 0) noise.push_back(new vector<char>(16 + rng() % 200));
+        if (noise.size() > n / 4) {
+            size_t at = rng() % noise.size();
+            delete noise[at];
+            noise[at] = noise.back();
+            noise.pop_back();
+        }
+    }
+    vector<long long> probes(lookups);
+    for (size_t i = 0; i < lookups; ++i) probes[i] = (long long)(rng() % (4 * n));
+
+    cout << "churned tree, " << lookups << " lookups" << endl;
+    measure("scattered:   ", tree, probes);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    tree.compact();
+    double compactMs = msSince(start);
+    measure("compacted:   ", tree, probes);
+
+    // the same again in bounded slices, timing the worst slice
+    for (size_t i = 0; i < n / 2; ++i) {
+        long long key = (long long)(rng() % (4 * n));
+        if (i % 2 == 0) tree.remove(key);
+        else tree.insert(make_pair(key, key));
+    }
+    // the first slice allocates the pass's block, which after heavy churn
+    // can cost the allocator more than any tree work, so it is shown apart
+    double firstMs = 0;
+    double worstMs = 0;
+    size_t slices = 0;
+    bool done = false;
+    while (!done) {
+        start = chrono::steady_clock::now();
+        done = tree.compactStep(slice);
+        double ms = msSince(start);
+        if (slices == 0) firstMs = ms;
+        else if (ms > worstMs) worstMs = ms;
+        ++slices;
+    }
+    cout << setprecision(1) << "compact(): " << compactMs << " ms at once" << endl;
+    cout << "compactStep(" << slice << "): " << slices << " slices, first " << setprecision(3) << firstMs
+         << " ms, worst of the rest " << worstMs << " ms" << endl;
+
+    for (size_t i = 0; i < noise.size(); ++i) delete noise[i];
+    return 0;
+}
@@ -0,0 +1,145 @@
+#include <iostream>
+#include <map>
+#include <cstdlib>
+#include "compact-tree.h"
+#include "test-util.h"
+
+using namespace std;
+
+// Exposes the layout so the test can see where nodes live.
+class Inspected : public CompactAVLTree<int, int>
+{
+public:
+    // Every parent/child link agrees in both directions.
+    bool linksAgree() const
+    {
+        return root_ == NULL || (root_->getParent() == NULL && linksBelow(static_cast<ANode*>(root_)));
+    }
+
+    // Nodes in a block, and how many of them in the first block after the root's.
+    size_t inBlocks() const
+    {
+        return countIn(static_cast<ANode*>(root_));
+    }
+
+    // The root is the first slot of its block, and its children the next two.
+    bool breadthFirstTop() const
+    {
+        ANode* root = static_cast<ANode*>(root_);
+        Block* b = blockOf(root);
+        if (b == NULL || root != reinterpret_cast<ANode*>(&b->slots[0])) return false;
+        return root->getLeft() == reinterpret_cast<ANode*>(&b->slots[1])
+            && root->getRight() == reinterpret_cast<ANode*>(&b->slots[2]);
+    }
+
+private:
+    bool linksBelow(ANode* n) const
+    {
+        if (n->getLeft() != NULL && (n->getLeft()->getParent() != n || !linksBelow(n->getLeft()))) return false;
+        if (n->getRight() != NULL && (n->getRight()->getParent() != n || !linksBelow(n->getRight()))) return false;
+        return true;
+    }
+
+    size_t countIn(ANode* n) const
+    {
+        if (n == NULL) return 0;
+        return (blockOf(n) != NULL ? 1 : 0) + countIn(n->getLeft()) + countIn(n->getRight());
+    }
+};
+
+bool sameContents(const Inspected& tree, const map<int, int>& ref)
+{
+    Inspected::iterator it = tree.begin();
+    for (map<int, int>::const_iterator r = ref.begin(); r != ref.end(); ++r, ++it) {
+        if (it == tree.end() || it->first != r->first || it->second != r->second) return false;
+    }
+    return it == tree.end();
+}
+
+int main()
+{
+    Inspected empty;
+    empty.compact();
+    check(empty.compactStep(10) && empty.blockCount() == 0 && !empty.compacting(), "compacting an empty tree");
+
+    srand(49);
+    Inspected tree;
+    map<int, int> ref;
+    for (int i = 0; i < 20000; ++i) {
+        int key = rand() % 50000;
+        tree.insert(make_pair(key, i));
+        ref[key] = i;
+    }
+    for (int i = 0; i < 10000; ++i) {
+        int key = rand() % 50000;
+        tree.remove(key);
+        ref.erase(key);
+    }
+    tree.compact();
+    check(sameContents(tree, ref) && tree.isBalanced() && tree.linksAgree(), "compact keeps the items and links");
+    check(tree.blockCount() == 1 && tree.inBlocks() == ref.size(), "every node is in one block");
+    check(tree.breadthFirstTop(), "the top levels are laid out breadth-first");
+    check(tree.min()->first == ref.begin()->first && tree.max()->first == ref.rbegin()->first, "min and max follow the move");
+
+    // still an ordinary tree afterwards
+    bool mutable_ = true;
+    for (int i = 0; i < 20000; ++i) {
+        int key = rand() % 50000;
+        if (rand() % 2 == 0) {
+            tree.remove(key);
+            ref.erase(key);
+        }
+        else {
+            tree.insert(make_pair(key, i));
+            ref[key] = i;
+        }
+    }
+    mutable_ = sameContents(tree, ref) && tree.isBalanced() && tree.linksAgree();
+    check(mutable_, "inserts and removes after compact");
+
+    // bounded slices with changes in between
+    bool sliced = true;
+    int passes = 0;
+    for (int round = 0; round < 3000; ++round) {
+        if (tree.compactStep(64)) ++passes;
+        for (int j = 0; j < 5; ++j) {
+            int key = rand() % 50000;
+            int op = rand() % 4;
+            if (op == 0) {
+                tree.remove(key);
+                ref.erase(key);
+            }
+            else if (op == 1) {
+                tree.popMin();
+                ref.erase(ref.begin());
+            }
+            else if (op == 2 && ref.count(key) == 1) {
+                Inspected::NodeHandle nh = tree.extract(key);
+                tree.insert(std::move(nh));
+            }
+            else {
+                tree.insert(make_pair(key, round));
+                ref[key] = round;
+            }
+        }
+        if (round % 100 == 0) sliced = sliced && sameContents(tree, ref) && tree.linksAgree() && tree.isBalanced();
+    }
+    check(sliced && passes > 0, "compactStep interleaved with changes");
+    while (!tree.compactStep(1000)) { }
+    tree.compact();
+    check(sameContents(tree, ref) && tree.blockCount() == 1 && tree.inBlocks() == ref.size(), "a quiet pass gathers everything");
+
+    // other trees get copies, never block nodes
+    Inspected other;
+    other.insert(make_pair(-1, -1));
+    other.compact();
+    other.merge(tree);
+    ref[-1] = -1;
+    check(tree.empty() && sameContents(other, ref) && other.linksAgree(), "merge copies out of the blocks");
+    check(tree.blockCount() == 0, "an emptied block is freed");
+
+    other.clear();
+    check(other.empty() && other.blockCount() == 0, "clear frees the blocks");
+
+    return failures == 0 ? 0 : 1;
+}
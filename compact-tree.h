@@ -0,0 +1,376 @@
+#ifndef COMPACT_TREE_H
+#define COMPACT_TREE_H
+
+#include <cstddef>
+#include <new>
+#include <deque>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+#include "avlbst.h"
+
+/**
+* An AVLTree that can move its live nodes into one contiguous block, in an
+* order that keeps a lookup's path close together: the top BreadthLevels
+* levels breadth-first, so the first steps of every descent share a few
+* cache lines, then each subtree below them depth-first, so a parent sits
+* next to its left child and a subtree is one stretch of memory for scans.
+*
+* compact() relays the whole tree at once. compactStep(n) moves at most n
+* nodes per call, so a long-lived tree can be defragmented a slice at a
+* time from a maintenance loop without a pause proportional to its size.
+* The one exception is the block itself, allocated by the first slice of a
+* pass; after heavy churn the allocator may take a while over that.
+* The tree may be changed between slices: nodes removed before the pass
+* reached them are dropped from it, and nodes the pass can no longer reach
+* after rotations stay where they are until the next pass.
+*
+* Nodes inserted after a pass come from the heap as usual. A block is freed
+* once every node in it is gone. The old copies of moved nodes are kept
+* until the pass ends, so a pass briefly needs room for two of every node.
+* Moving a node invalidates iterators to it, so iterators do not survive a
+* compaction step.
+*/
+template <typename Key, typename Value>
+class CompactAVLTree : public AVLTree<Key, Value>
+{
+public:
+    static const unsigned BreadthLevels = 5;
+
+    CompactAVLTree();
+    virtual ~CompactAVLTree();
+
+    void compact();
+    // Does at most maxNodes units of work (moving a node, or freeing the
+    // old copy of one), starting a pass if none is running. Returns true
+    // once the pass has finished.
+    bool compactStep(size_t maxNodes);
+    bool compacting() const;
+    // Blocks still holding nodes, for tests and tuning.
+    size_t blockCount() const;
+
+protected:
+    typedef AVLNode<Key, Value> ANode;
+    typedef typename std::aligned_storage<sizeof(ANode), alignof(ANode)>::type Slot;
+    // Balance of an old copy left behind by move; no node in a tree has it.
+    static const int8_t MovedMark = 100;
+
+    struct Block {
+        Slot* slots;
+        size_t capacity;
+        size_t used;
+        size_t live;
+    };
+
+    virtual AVLNode<Key, Value>* createNode(const Key& key, const Value& value, AVLNode<Key, Value>* parent);
+    virtual void destroyNode(AVLNode<Key, Value>* node);
+    virtual const void* nodeSource() const;
+    virtual void extractNode(AVLNode<Key, Value>* n);
+
+    // The block holding n, or NULL for a heap node.
+    Block* blockOf(const ANode* n) const;
+    // Destroys n and gives its memory back to its block or the heap.
+    void release(ANode* n);
+    void freeIfEmpty(Block* b);
+    // Copies n into the next slot of the filling block and relinks it. The
+    // old copy is marked and kept until the pass ends.
+    ANode* move(ANode* n);
+    void beginPass();
+    // Stops the walk; what is left is freeing the old copies.
+    void stopWalk();
+    void endPass();
+    // Drops n from the nodes the pass has yet to visit.
+    void forget(ANode* n);
+
+    std::vector<Block*> blocks_;
+    size_t nodes_;                  // live nodes this tree made, in or out of the tree
+    Block* filling_;                // block the current pass moves into, or NULL
+    std::deque<std::pair<ANode*, unsigned> > breadth_;  // top levels still to move, with depth
+    std::vector<ANode*> subtrees_;  // roots below the top levels, in breadth-first order
+    size_t nextSubtree_;
+    std::vector<ANode*> depth_;     // depth-first stack within the current subtree
+    std::vector<ANode*> movedFrom_; // old copies of the nodes this pass moved
+    bool draining_;                 // walk done, old copies still being freed
+
+private:
+    CompactAVLTree(const CompactAVLTree&);
+    CompactAVLTree& operator=(const CompactAVLTree&);
+};
+
+/*
+  ---------------------------------------------------
+  Begin implementations for the CompactAVLTree class.
+  ---------------------------------------------------
+*/
+
+template<class Key, class Value>
+CompactAVLTree<Key, Value>::CompactAVLTree() :
+    nodes_(0), filling_(NULL), nextSubtree_(0), draining_(false)
+{
+
+}
+
+template<class Key, class Value>
+CompactAVLTree<Key, Value>::~CompactAVLTree()
+{
+    endPass();
+    this->clear();
+    for (size_t i = 0; i < blocks_.size(); ++i) {
+        delete [] blocks_[i]->slots;
+        delete blocks_[i];
+    }
+}
+
+template<class Key, class Value>
+typename CompactAVLTree<Key, Value>::Block* CompactAVLTree<Key, Value>::blockOf(const ANode* n) const
+{
+    std::less<const void*> before;
+    for (size_t i = 0; i < blocks_.size(); ++i) {
+        Block* b = blocks_[i];
+        if (!before(n, b->slots) && before(n, b->slots + b->capacity)) return b;
+    }
+    return NULL;
+}
+
+template<class Key, class Value>
+void CompactAVLTree<Key, Value>::freeIfEmpty(Block* b)
+{
+    if (b->live != 0 || b == filling_) return;
+    blocks_.erase(std::find(blocks_.begin(), blocks_.end(), b));
+    delete [] b->slots;
+    delete b;
+}
+
+template<class Key, class Value>
+void CompactAVLTree<Key, Value>::release(ANode* n)
+{
+    Block* b = blockOf(n);
+    if (b == NULL) {
+        AVLTree<Key, Value>::destroyNode(n);
+        return;
+    }
+    n->~ANode();
+    --b->live;
+    freeIfEmpty(b);
+}
+
+template<class Key, class Value>
+AVLNode<Key, Value>* CompactAVLTree<Key, Value>::createNode(const Key& key, const Value& value,
+    AVLNode<Key, Value>* parent)
+{
+    ANode* n = AVLTree<Key, Value>::createNode(key, value, parent);
+    ++nodes_;
+    return n;
+}
+
+template<class Key, class Value>
+void CompactAVLTree<Key, Value>::destroyNode(AVLNode<Key, Value>* node)
+{
+    forget(node);
+    release(node);
+    --nodes_;
+}
+
+/**
+* Block nodes cannot be handed to another tree to free, so node handles
+* only move nodes back into this same tree; other trees get copies.
+*/
+template<class Key, class Value>
+const void* CompactAVLTree<Key, Value>::nodeSource() const
+{
+    return this;
+}
+
+template<class Key, class Value>
+void CompactAVLTree<Key, Value>::extractNode(AVLNode<Key, Value>* n)
+{
+    forget(n);
+    AVLTree<Key, Value>::extractNode(n);
+}
+
+template<class Key, class Value>
+void CompactAVLTree<Key, Value>::forget(ANode* n)
+{
+    if (filling_ == NULL) return;
+    for (size_t i = 0; i < breadth_.size(); ++i) {
+        if (breadth_[i].first == n) breadth_[i].first = NULL;
+    }
+    std::replace(subtrees_.begin() + nextSubtree_, subtrees_.end(), n, (ANode*)NULL);
+    std::replace(depth_.begin(), depth_.end(), n, (ANode*)NULL);
+}
+
+/**
+* The copy takes over n's links in both directions, and the tree's cached
+* ends and finger if they pointed at n.
+*/
+template<class Key, class Value>
+typename CompactAVLTree<Key, Value>::ANode* CompactAVLTree<Key, Value>::move(ANode* n)
+{
+    ANode* m = new (&filling_->slots[filling_->used]) ANode(n->getKey(), n->getValue(), n->getParent());
+    ++filling_->used;
+    ++filling_->live;
+    m->setBalance(n->getBalance());
+    m->setLeft(n->getLeft());
+    m->setRight(n->getRight());
+    if (m->getLeft() != NULL) m->getLeft()->setParent(m);
+    if (m->getRight() != NULL) m->getRight()->setParent(m);
+
+    ANode* p = m->getParent();
+    if (p == NULL) this->root_ = m;
+    else if (p->getLeft() == n) p->setLeft(m);
+    else p->setRight(m);
+
+    if (this->leftmost_ == n) this->leftmost_ = m;
+    if (this->rightmost_ == n) this->rightmost_ = m;
+    if (this->finger_ == n) this->finger_ = m;
+    n->setBalance(MovedMark);
+    movedFrom_.push_back(n);
+    return m;
+}
+
+/**
+* Sized for every node this tree owns, which is at least every node in it.
+*/
+template<class Key, class Value>
+void CompactAVLTree<Key, Value>::beginPass()
+{
+    Block* b = new Block;
+    b->capacity = nodes_;
+    b->used = 0;
+    b->live = 0;
+    b->slots = new Slot[b->capacity];
+    blocks_.push_back(b);
+    filling_ = b;
+    breadth_.clear();
+    subtrees_.clear();
+    nextSubtree_ = 0;
+    depth_.clear();
+    breadth_.push_back(std::make_pair(static_cast<ANode*>(this->root_), 0u));
+}
+
+/**
+* With the queues gone no stale entry can reach an old copy any more, so
+* the old copies are safe to free.
+*/
+template<class Key, class Value>
+void CompactAVLTree<Key, Value>::stopWalk()
+{
+    breadth_.clear();
+    subtrees_.clear();
+    depth_.clear();
+    nextSubtree_ = 0;
+    draining_ = true;
+}
+
+template<class Key, class Value>
+void CompactAVLTree<Key, Value>::endPass()
+{
+    Block* b = filling_;
+    stopWalk();
+    for (size_t i = 0; i < movedFrom_.size(); ++i) release(movedFrom_[i]);
+    movedFrom_.clear();
+    draining_ = false;
+    filling_ = NULL;
+    if (b != NULL) freeIfEmpty(b);
+    // blocks the pass emptied out were freed as it went; earlier blocks that
+    // only hold nodes it could not reach stay until those nodes go
+}
+
+/**
+* Rotations between slices can carry a node under another one still
+* waiting, so the same node may be queued twice. The second time it is
+* either already in the filling block or, through a stale entry, its
+* marked old copy; both are skipped along with whatever hangs below them.
+*/
+template<class Key, class Value>
+bool CompactAVLTree<Key, Value>::compactStep(size_t maxNodes)
+{
+    if (filling_ == NULL) {
+        if (this->root_ == NULL) return true;
+        beginPass();
+    }
+    if (maxNodes == 0) maxNodes = 1;
+    size_t work = 0;
+    while (!draining_ && work < maxNodes) {
+        ANode* n = NULL;
+        unsigned depth = BreadthLevels;
+        if (!breadth_.empty()) {
+            n = breadth_.front().first;
+            depth = breadth_.front().second;
+            breadth_.pop_front();
+        }
+        else if (!depth_.empty()) {
+            n = depth_.back();
+            depth_.pop_back();
+        }
+        else if (nextSubtree_ < subtrees_.size()) {
+            depth_.push_back(subtrees_[nextSubtree_++]);
+            continue;
+        }
+        else {
+            stopWalk();
+            break;
+        }
+        if (n == NULL || n->getBalance() == MovedMark || blockOf(n) == filling_) continue;
+        if (filling_->used == filling_->capacity) {
+            stopWalk();
+            break;
+        }
+        n = move(n);
+        ++work;
+
+        ANode* left = n->getLeft();
+        ANode* right = n->getRight();
+        if (depth + 1 < BreadthLevels) {
+            if (left != NULL) breadth_.push_back(std::make_pair(left, depth + 1));
+            if (right != NULL) breadth_.push_back(std::make_pair(right, depth + 1));
+        }
+        else if (depth + 1 == BreadthLevels) {
+            if (left != NULL) subtrees_.push_back(left);
+            if (right != NULL) subtrees_.push_back(right);
+        }
+        else {
+            //right first so the left subtree comes off the stack next
+            if (right != NULL) depth_.push_back(right);
+            if (left != NULL) depth_.push_back(left);
+        }
+    }
+    while (draining_ && work < maxNodes && !movedFrom_.empty()) {
+        release(movedFrom_.back());
+        movedFrom_.pop_back();
+        ++work;
+    }
+    if (draining_ && movedFrom_.empty()) {
+        endPass();
+        return true;
+    }
+    return false;
+}
+
+template<class Key, class Value>
+void CompactAVLTree<Key, Value>::compact()
+{
+    while (!compactStep(nodes_ + 1)) { }
+}
+
+template<class Key, class Value>
+bool CompactAVLTree<Key, Value>::compacting() const
+{
+    return filling_ != NULL;
+}
+
+template<class Key, class Value>
+size_t CompactAVLTree<Key, Value>::blockCount() const
+{
+    return blocks_.size();
+}
+
+/*
+  -------------------------------------------------
+  End implementations for the CompactAVLTree class.
+  -------------------------------------------------
+*/
+
+#endif
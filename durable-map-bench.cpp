@@ -0,0 +1,81 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include "durable-map.h"
+
+using namespace std;
+
+double msSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+void removeDir(const string& dir)
+{
+    unlink((dir + "/wal").c_str());
+    unlink((dir + "/checkpoint").c_str());
+    rmdir(dir.c_str());
+}
+
+// Insert throughput for one durability setting.
+void run(const string& dir, const vector<long long>& keys, size_t groupOps, bool fsyncEnabled)
+{
+    removeDir(dir);
+    DurableOptions options;
+    options.groupCommitOps = groupOps;
+    options.fsyncEnabled = fsyncEnabled;
+    options.checkpointOps = 0;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    {
+        DurableAVLMap<long long,long long> m(dir, options);
+        for (size_t i = 0; i < keys.size(); ++i) m.insert(make_pair(keys[i], (long long)i));
+    }
+    double ms = msSince(start);
+    cout << setw(8) << groupOps << setw(8) << (fsyncEnabled ? "on" : "off")
+         << setw(14) << (long long)(keys.size() / (ms / 1000)) << " ops/s" << endl;
+}
+
+// Compares insert throughput across group commit sizes with and without
+// fsync, then times recovery from a log alone and from a checkpoint.
+int main(int argc, char* argv[])
+{
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 20000;
+    string dir = argc > 2 ? argv[2] : "/tmp/durable-map-bench." + to_string(getpid());
+
+    mt19937_64 rng(32);
+    vector<long long> keys(n);
+    for (size_t i = 0; i < n; ++i) keys[i] = (long long)(rng() >> 1);
+
+    cout << n << " inserts" << endl;
+    cout << setw(8) << "group" << setw(8) << "fsync" << setw(14) << "throughput" << endl;
+    size_t groups[] = { 1, 16, 256, 4096 };
+    for (size_t g = 0; g < sizeof(groups) / sizeof(groups[0]); ++g) run(dir, keys, groups[g], true);
+    run(dir, keys, 1, false);
+    run(dir, keys, 4096, false);
+
+    chrono::steady_clock::time_point start;
+    double logMs = 0;
+    {
+        start = chrono::steady_clock::now();
+        DurableAVLMap<long long,long long> m(dir);
+        logMs = msSince(start);
+        m.checkpoint();
+    }
+    start = chrono::steady_clock::now();
+    {
+        DurableAVLMap<long long,long long> m(dir);
+        double checkpointMs = msSince(start);
+        cout << fixed << setprecision(1);
+        cout << "recover from log:        " << logMs << " ms" << endl;
+        cout << "recover from checkpoint: " << checkpointMs << " ms" << endl;
+    }
+    removeDir(dir);
+    return 0;
+}
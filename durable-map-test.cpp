@@ -0,0 +1,205 @@
+#include <iostream>
+#include <string>
+#include <map>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <csignal>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "durable-map.h"
+#include "test-util.h"
+
+using namespace std;
+
+void removeDir(const string& dir)
+{
+    unlink((dir + "/wal").c_str());
+    unlink((dir + "/checkpoint").c_str());
+    unlink((dir + "/checkpoint.tmp").c_str());
+    rmdir(dir.c_str());
+}
+
+// true iff the map holds exactly the entries of expect
+bool matches(const DurableAVLMap<int,long>& m, const map<int,long>& expect)
+{
+    map<int,long> seen;
+    m.forEach([&seen](const int& k, const long& v) { seen[k] = v; });
+    return seen == expect;
+}
+
+int main()
+{
+    // bulkLoad builds a valid AVL tree that later updates keep balanced
+    vector<pair<int,long> > sorted;
+    for (int i = 0; i < 1000; ++i) sorted.push_back(make_pair(i, (long)i));
+    AVLTree<int,long> loaded;
+    loaded.bulkLoad(sorted.begin(), sorted.end());
+    bool same = loaded.isBalanced();
+    for (int i = 0; i < 1000; ++i) same = same && loaded.find(i) != loaded.end() && loaded[i] == i;
+    for (int i = 0; i < 1000; i += 3) loaded.remove(i);
+    for (int i = 1000; i < 1300; ++i) loaded.insert(make_pair(i, (long)i));
+    check(same && loaded.isBalanced(), "bulkLoad builds a balanced tree");
+
+    string dir = "/tmp/durable-map-test." + to_string(getpid());
+    removeDir(dir);
+    map<int,long> expect;
+
+    {
+        DurableAVLMap<int,long> m(dir);
+        for (int i = 0; i < 500; ++i) {
+            m.insert(make_pair(i, (long)i * 3));
+            expect[i] = (long)i * 3;
+        }
+        for (int i = 0; i < 500; i += 5) {
+            m.remove(i);
+            expect.erase(i);
+        }
+        m.insert(make_pair(7, 70L));
+        expect[7] = 70;
+    }
+    {
+        DurableAVLMap<int,long> m(dir);
+        check(m.replayedOps() == 601, "reopening replays the whole log");
+        check(matches(m, expect), "log replay restores inserts, overwrites and removes");
+        long v = 0;
+        check(m.find(7, v) && v == 70 && !m.contains(10), "find and contains after replay");
+
+        m.checkpoint();
+        check(m.logBytes() == 0, "checkpoint empties the log");
+        for (int i = 1000; i < 1100; ++i) {
+            m.insert(make_pair(i, (long)-i));
+            expect[i] = -i;
+        }
+        m.remove(1);
+        expect.erase(1);
+    }
+    {
+        DurableAVLMap<int,long> m(dir);
+        check(m.replayedOps() == 101, "only the tail after the checkpoint is replayed");
+        check(matches(m, expect), "checkpoint plus tail restores the map");
+    }
+
+    // a torn record at the end of the log is cut off
+    {
+        FILE* wal = fopen((dir + "/wal").c_str(), "ab");
+        fwrite("partial", 1, 7, wal);
+        fclose(wal);
+        DurableAVLMap<int,long> m(dir);
+        check(matches(m, expect), "torn tail is ignored");
+        m.insert(make_pair(2000, 1L));
+        expect[2000] = 1;
+    }
+    {
+        DurableAVLMap<int,long> m(dir);
+        check(matches(m, expect), "writes after a torn tail replay cleanly");
+    }
+
+    // a process that dies without running destructors keeps every committed op
+    pid_t child = fork();
+    if (child == 0) {
+        DurableAVLMap<int,long>* m = new DurableAVLMap<int,long>(dir);
+        for (int i = 3000; i < 3050; ++i) m->insert(make_pair(i, (long)i));
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    for (int i = 3000; i < 3050; ++i) expect[i] = i;
+    {
+        DurableAVLMap<int,long> m(dir);
+        check(WIFEXITED(status) && matches(m, expect), "committed ops survive a crash");
+    }
+
+    // grouped commits lose at most the unsynced group, and sync() commits it
+    {
+        DurableOptions options;
+        options.groupCommitOps = 64;
+        DurableAVLMap<int,long> m(dir, options);
+        for (int i = 4000; i < 4010; ++i) {
+            m.insert(make_pair(i, (long)i));
+            expect[i] = i;
+        }
+        m.sync();
+    }
+    {
+        DurableAVLMap<int,long> m(dir);
+        check(matches(m, expect), "sync commits a partial group");
+    }
+
+    // the group commit timer fires without another write, so a process that
+    // goes idle and then dies keeps its buffered group
+    child = fork();
+    if (child == 0) {
+        DurableOptions options;
+        options.groupCommitOps = 64;
+        options.groupCommitMicros = 2000;
+        DurableAVLMap<int,long>* m = new DurableAVLMap<int,long>(dir, options);
+        for (int i = 4100; i < 4105; ++i) m->insert(make_pair(i, (long)i));
+        usleep(200000);
+        _exit(0);
+    }
+    waitpid(child, &status, 0);
+    for (int i = 4100; i < 4105; ++i) expect[i] = i;
+    {
+        DurableAVLMap<int,long> m(dir);
+        check(WIFEXITED(status) && matches(m, expect), "an idle map commits its group on the timer");
+    }
+
+    // an operation whose log write fails throws and leaves the map unchanged
+    {
+        DurableAVLMap<int,long> m(dir);
+        m.sync();
+        struct stat st;
+        stat((dir + "/wal").c_str(), &st);
+        struct rlimit saved;
+        getrlimit(RLIMIT_FSIZE, &saved);
+        struct rlimit tight = saved;
+        tight.rlim_cur = st.st_size;
+        signal(SIGXFSZ, SIG_IGN);
+        setrlimit(RLIMIT_FSIZE, &tight);
+        bool threw = false;
+        try {
+            m.insert(make_pair(4200, 1L));
+        }
+        catch (const runtime_error&) {
+            threw = true;
+        }
+        bool removeThrew = false;
+        try {
+            m.remove(4100);
+        }
+        catch (const runtime_error&) {
+            removeThrew = true;
+        }
+        setrlimit(RLIMIT_FSIZE, &saved);
+        check(threw && !m.contains(4200), "a failed insert is not applied");
+        check(removeThrew && m.contains(4100), "a failed remove is not applied");
+        m.insert(make_pair(4201, 2L));
+        expect[4201] = 2;
+    }
+    {
+        DurableAVLMap<int,long> m(dir);
+        check(matches(m, expect), "the log holds nothing of the failed operations");
+    }
+
+    // automatic compaction
+    {
+        DurableOptions options;
+        options.checkpointOps = 100;
+        DurableAVLMap<int,long> m(dir, options);
+        for (int i = 5000; i < 5250; ++i) {
+            m.insert(make_pair(i, (long)i));
+            expect[i] = i;
+        }
+        check(m.logBytes() < 100 * (sizeof(int) + sizeof(long) + 8) * 2, "log is compacted every checkpointOps");
+    }
+    {
+        DurableAVLMap<int,long> m(dir);
+        check(matches(m, expect), "automatic checkpoints recover");
+    }
+
+    removeDir(dir);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,459 @@
+#ifndef DURABLE_MAP_H
+#define DURABLE_MAP_H
+
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <utility>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <stdexcept>
+#include <type_traits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "avlbst.h"
+#include "mapped-tree.h"
+
+/**
+* Tuning knobs for DurableAVLMap.
+*
+* groupCommitOps is how many log records are buffered before they are
+* written and synced together. 1 makes every insert/remove durable before it
+* returns; larger values trade the last few operations on a crash for
+* throughput. groupCommitMicros also forces a commit once the oldest buffered
+* record is that old, from a background thread, so records buffered by a map
+* that then goes idle are still made durable within that time (0 disables
+* the timer and the thread; call sync() instead). fsyncEnabled=false still writes
+* each group to the OS but never waits for the disk, which survives a process
+* crash but not a power loss. checkpointOps compacts the log into a new
+* checkpoint after that many operations (0 means only on checkpoint()).
+*/
+struct DurableOptions {
+    size_t groupCommitOps;
+    unsigned groupCommitMicros;
+    bool fsyncEnabled;
+    size_t checkpointOps;
+
+    DurableOptions() :
+        groupCommitOps(1), groupCommitMicros(0), fsyncEnabled(true), checkpointOps(1000000)
+    {
+
+    }
+};
+
+/**
+* An AVLTree whose contents survive restarts. The directory holds two files:
+*
+*   checkpoint  a MappedTree snapshot of the whole map, in key order
+*   wal         an append-only log of the inserts and removes made since
+*
+* Opening the map loads the checkpoint with bulkLoad and replays the log on
+* top. Each log record carries a checksum, so a record torn by a crash ends
+* the replay and is cut off. Log records are absolute (set key to value,
+* erase key), so replaying one that the checkpoint already contains is
+* harmless; that makes a crash between writing a checkpoint and truncating
+* the log safe.
+*
+* Every operation is logged before it is applied, so if logging fails the
+* operation throws and the map is left as it was.
+*
+* Reads are served from memory. All operations take one mutex, so the map
+* can be shared between threads, but a group commit holds it while syncing.
+* Key and Value must be trivially copyable, as for MappedTree.
+*/
+template <typename Key, typename Value>
+class DurableAVLMap
+{
+public:
+    explicit DurableAVLMap(const std::string& dir, const DurableOptions& options = DurableOptions());
+    ~DurableAVLMap();
+
+    void insert(const std::pair<const Key, Value>& item);
+    void remove(const Key& key);
+
+    bool find(const Key& key, Value& value) const;
+    bool contains(const Key& key) const;
+
+    // Calls f(key, value) for every entry in key order.
+    template<class F>
+    void forEach(F f) const;
+
+    // Writes and syncs any buffered log records.
+    void sync();
+    // Snapshots the map into a new checkpoint and empties the log.
+    void checkpoint();
+
+    // Bytes currently in the log file, including records not yet written.
+    uint64_t logBytes() const;
+    // Log records applied while opening the map.
+    uint64_t replayedOps() const;
+
+private:
+    enum { OpInsert = 1, OpRemove = 2 };
+
+    struct LogRecord {
+        uint32_t op;
+        uint32_t checksum;
+        Key key;
+        Value value;
+    };
+
+    static uint32_t checksumOf(LogRecord record);
+
+    void recover();
+    // Logs one record; the caller applies the operation once this returns.
+    void append(uint32_t op, const Key& key, const Value& value);
+    // Checkpoints if checkpointOps operations have been applied since the last.
+    void applied();
+    void commitLocked();
+    void checkpointLocked();
+    // Body of the flusher thread that enforces groupCommitMicros.
+    void flushLoop();
+
+    std::string dir_;
+    std::string logPath_;
+    std::string checkpointPath_;
+    DurableOptions options_;
+
+    mutable std::mutex mutex_;
+    AVLTree<Key, Value> tree_;
+    int logFd_;
+    uint64_t logSize_;              // bytes written to the log file
+    std::vector<char> pending_;     // records not yet written
+    size_t pendingOps_;
+    std::chrono::steady_clock::time_point pendingSince_;
+    size_t opsSinceCheckpoint_;
+    uint64_t replayed_;
+    std::condition_variable wake_;  // tells flusher_ a group has started, or to stop
+    bool stopping_;
+    std::thread flusher_;
+
+    // prevent copying
+    DurableAVLMap(const DurableAVLMap&);
+    DurableAVLMap& operator=(const DurableAVLMap&);
+
+    static_assert(std::is_trivially_copyable<Key>::value, "DurableAVLMap keys must be trivially copyable");
+    static_assert(std::is_trivially_copyable<Value>::value, "DurableAVLMap values must be trivially copyable");
+};
+
+/*
+  -------------------------------------------------
+  Begin implementations for the DurableAVLMap class.
+  -------------------------------------------------
+*/
+
+/**
+* Opens (creating if needed) the map stored in dir and recovers its contents.
+*/
+template<class Key, class Value>
+DurableAVLMap<Key, Value>::DurableAVLMap(const std::string& dir, const DurableOptions& options) :
+    dir_(dir), logPath_(dir + "/wal"), checkpointPath_(dir + "/checkpoint"), options_(options),
+    logFd_(-1), logSize_(0), pendingOps_(0), opsSinceCheckpoint_(0), replayed_(0), stopping_(false)
+{
+    if (options_.groupCommitOps == 0) options_.groupCommitOps = 1;
+    if (mkdir(dir_.c_str(), 0755) != 0 && errno != EEXIST) {
+        throw std::runtime_error("DurableAVLMap: cannot create " + dir_);
+    }
+    recover();
+    if (options_.groupCommitMicros != 0 && options_.groupCommitOps > 1) {
+        flusher_ = std::thread(&DurableAVLMap<Key, Value>::flushLoop, this);
+    }
+}
+
+/**
+* A clean shutdown commits whatever is still buffered.
+*/
+template<class Key, class Value>
+DurableAVLMap<Key, Value>::~DurableAVLMap()
+{
+    if (flusher_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_one();
+        flusher_.join();
+    }
+    try {
+        sync();
+    }
+    catch (...) {
+    }
+    if (logFd_ >= 0) ::close(logFd_);
+}
+
+/**
+* FNV-1a over the whole record with the checksum field zeroed. Records are
+* zero-filled before they are built, so padding bytes hash the same way on
+* write and on replay.
+*/
+template<class Key, class Value>
+uint32_t DurableAVLMap<Key, Value>::checksumOf(LogRecord record)
+{
+    record.checksum = 0;
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&record);
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < sizeof(record); ++i) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+* Loads the checkpoint, replays every intact log record after it and cuts
+* off anything past the first bad one.
+*/
+template<class Key, class Value>
+void DurableAVLMap<Key, Value>::recover()
+{
+    struct stat st;
+    if (stat(checkpointPath_.c_str(), &st) == 0) {
+        MappedTree<Key, Value> snapshot(checkpointPath_);
+        tree_.bulkLoad(snapshot.begin(), snapshot.end());
+    }
+
+    logFd_ = ::open(logPath_.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (logFd_ < 0) throw std::runtime_error("DurableAVLMap: cannot open " + logPath_);
+
+    LogRecord record;
+    uint64_t good = 0;
+    while (true) {
+        ssize_t got = pread(logFd_, &record, sizeof(record), good);
+        if (got != (ssize_t)sizeof(record)) break;
+        if (record.checksum != checksumOf(record)) break;
+        if (record.op == OpInsert) tree_.insert(std::make_pair(record.key, record.value));
+        else if (record.op == OpRemove) tree_.remove(record.key);
+        else break;
+        good += sizeof(record);
+        ++replayed_;
+    }
+
+    if (fstat(logFd_, &st) != 0) throw std::runtime_error("DurableAVLMap: cannot stat " + logPath_);
+    if ((uint64_t)st.st_size != good) {
+        //torn or corrupt tail from a crash mid-write
+        if (ftruncate(logFd_, good) != 0 || fsync(logFd_) != 0) {
+            throw std::runtime_error("DurableAVLMap: cannot truncate " + logPath_);
+        }
+    }
+    logSize_ = good;
+    opsSinceCheckpoint_ = replayed_;
+}
+
+template<class Key, class Value>
+void DurableAVLMap<Key, Value>::insert(const std::pair<const Key, Value>& item)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    append(OpInsert, item.first, item.second);
+    tree_.insert(item);
+    applied();
+}
+
+template<class Key, class Value>
+void DurableAVLMap<Key, Value>::remove(const Key& key)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Value none;
+    std::memset(&none, 0, sizeof(none));
+    append(OpRemove, key, none);
+    tree_.remove(key);
+    applied();
+}
+
+/**
+* Buffers one log record and commits the group when it is full or old
+* enough. If the commit fails, this record is dropped again and the earlier
+* ones stay buffered for the next attempt. Called with mutex_ held.
+*/
+template<class Key, class Value>
+void DurableAVLMap<Key, Value>::append(uint32_t op, const Key& key, const Value& value)
+{
+    LogRecord record;
+    std::memset(&record, 0, sizeof(record));
+    record.op = op;
+    std::memcpy(&record.key, &key, sizeof(Key));
+    std::memcpy(&record.value, &value, sizeof(Value));
+    record.checksum = checksumOf(record);
+
+    const char* bytes = reinterpret_cast<const char*>(&record);
+    pending_.insert(pending_.end(), bytes, bytes + sizeof(record));
+    if (pendingOps_++ == 0) {
+        pendingSince_ = std::chrono::steady_clock::now();
+        wake_.notify_one();
+    }
+
+    bool full = pendingOps_ >= options_.groupCommitOps;
+    bool stale = options_.groupCommitMicros != 0 &&
+        std::chrono::steady_clock::now() - pendingSince_ >= std::chrono::microseconds(options_.groupCommitMicros);
+    if (!full && !stale) return;
+    try {
+        commitLocked();
+    }
+    catch (...) {
+        pending_.resize(pending_.size() - sizeof(record));
+        --pendingOps_;
+        throw;
+    }
+}
+
+/**
+* The checkpoint snapshots tree_, so it runs only once the operation that
+* reached checkpointOps is in it.
+*/
+template<class Key, class Value>
+void DurableAVLMap<Key, Value>::applied()
+{
+    ++opsSinceCheckpoint_;
+    if (options_.checkpointOps != 0 && opsSinceCheckpoint_ >= options_.checkpointOps) {
+        checkpointLocked();
+    }
+}
+
+/**
+* A failed commit leaves its records buffered and is retried after another
+* interval, or sooner by the next write or sync, which also report the error.
+*/
+template<class Key, class Value>
+void DurableAVLMap<Key, Value>::flushLoop()
+{
+    std::chrono::microseconds interval(options_.groupCommitMicros);
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        if (pendingOps_ == 0) {
+            wake_.wait(lock);
+            continue;
+        }
+        std::chrono::steady_clock::time_point due = pendingSince_ + interval;
+        if (std::chrono::steady_clock::now() < due) {
+            wake_.wait_until(lock, due);
+            continue;
+        }
+        try {
+            commitLocked();
+        }
+        catch (...) {
+            wake_.wait_for(lock, interval);
+        }
+    }
+}
+
+/**
+* Writes the buffered records with one write and, unless disabled, one fsync.
+* On failure the log is cut back to its last committed size, so nothing of
+* the group is left in it and the records are still buffered.
+*/
+template<class Key, class Value>
+void DurableAVLMap<Key, Value>::commitLocked()
+{
+    if (pending_.empty()) return;
+    size_t done = 0;
+    bool ok = true;
+    while (ok && done < pending_.size()) {
+        ssize_t n = ::write(logFd_, &pending_[done], pending_.size() - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            ok = false;
+        }
+        else done += n;
+    }
+    if (ok && options_.fsyncEnabled && fdatasync(logFd_) != 0) ok = false;
+    if (!ok) {
+        if (done > 0 && ftruncate(logFd_, logSize_) != 0) {
+            //a torn tail is cut off on the next open anyway
+        }
+        throw std::runtime_error("DurableAVLMap: commit failed for " + logPath_);
+    }
+    logSize_ += pending_.size();
+    pending_.clear();
+    pendingOps_ = 0;
+}
+
+template<class Key, class Value>
+void DurableAVLMap<Key, Value>::sync()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    commitLocked();
+}
+
+template<class Key, class Value>
+void DurableAVLMap<Key, Value>::checkpoint()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    checkpointLocked();
+}
+
+/**
+* save replaces the checkpoint atomically, so the log is only emptied once
+* the new snapshot is durable. Buffered records are dropped rather than
+* written, since the snapshot already includes them.
+*/
+template<class Key, class Value>
+void DurableAVLMap<Key, Value>::checkpointLocked()
+{
+    MappedTree<Key, Value>::save(tree_, checkpointPath_);
+
+    if (ftruncate(logFd_, 0) != 0 || fsync(logFd_) != 0) {
+        throw std::runtime_error("DurableAVLMap: cannot truncate " + logPath_);
+    }
+    logSize_ = 0;
+    pending_.clear();
+    pendingOps_ = 0;
+    opsSinceCheckpoint_ = 0;
+}
+
+template<class Key, class Value>
+bool DurableAVLMap<Key, Value>::find(const Key& key, Value& value) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    typename BinarySearchTree<Key, Value>::iterator it = tree_.find(key);
+    if (it == tree_.end()) return false;
+    value = it->second;
+    return true;
+}
+
+template<class Key, class Value>
+bool DurableAVLMap<Key, Value>::contains(const Key& key) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tree_.find(key) != tree_.end();
+}
+
+template<class Key, class Value>
+template<class F>
+void DurableAVLMap<Key, Value>::forEach(F f) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (tree_.empty()) return;
+    for (typename BinarySearchTree<Key, Value>::iterator it = tree_.begin(); it != tree_.end(); ++it) {
+        f(it->first, it->second);
+    }
+}
+
+template<class Key, class Value>
+uint64_t DurableAVLMap<Key, Value>::logBytes() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return logSize_ + pending_.size();
+}
+
+template<class Key, class Value>
+uint64_t DurableAVLMap<Key, Value>::replayedOps() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return replayed_;
+}
+
+/*
+  -----------------------------------------------
+  End implementations for the DurableAVLMap class.
+  -----------------------------------------------
+*/
+
+#endif
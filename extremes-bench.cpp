@@ -0,0 +1,79 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <queue>
+#include <set>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <functional>
+#include "avlbst.h"
+
+using namespace std;
+
+double msSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// A discrete-event scheduler: keep `pending` timers queued, and on each step
+// fire the earliest one and schedule a new one a random delay later. Keys are
+// (time, sequence number) packed into one integer so they stay unique.
+int main(int argc, char* argv[])
+{
+    size_t pending = argc > 1 ? strtoul(argv[1], NULL, 10) : 100000;
+    size_t steps = argc > 2 ? strtoul(argv[2], NULL, 10) : 2000000;
+    const unsigned long long SeqBits = 24;
+    const unsigned long long SeqMask = (1ULL << SeqBits) - 1;
+
+    mt19937_64 rng(38);
+    vector<unsigned long long> delays(pending + steps);
+    for (size_t i = 0; i < delays.size(); ++i) delays[i] = rng() % 10000;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    AVLTree<unsigned long long,int> tree;
+    for (size_t i = 0; i < pending; ++i) tree.insert(make_pair((delays[i] << SeqBits) | (i & SeqMask), 0));
+    unsigned long long treeLast = 0;
+    for (size_t s = 0; s < steps; ++s) {
+        unsigned long long now = tree.min()->first >> SeqBits;
+        tree.popMin();
+        size_t id = pending + s;
+        tree.insert(make_pair(((now + delays[id]) << SeqBits) | (id & SeqMask), 0));
+        treeLast = now;
+    }
+    double treeMs = msSince(start);
+
+    start = chrono::steady_clock::now();
+    priority_queue<unsigned long long, vector<unsigned long long>, greater<unsigned long long> > heap;
+    for (size_t i = 0; i < pending; ++i) heap.push((delays[i] << SeqBits) | (i & SeqMask));
+    unsigned long long heapLast = 0;
+    for (size_t s = 0; s < steps; ++s) {
+        unsigned long long now = heap.top() >> SeqBits;
+        heap.pop();
+        size_t id = pending + s;
+        heap.push(((now + delays[id]) << SeqBits) | (id & SeqMask));
+        heapLast = now;
+    }
+    double heapMs = msSince(start);
+
+    start = chrono::steady_clock::now();
+    set<unsigned long long> ordered;
+    for (size_t i = 0; i < pending; ++i) ordered.insert((delays[i] << SeqBits) | (i & SeqMask));
+    unsigned long long setLast = 0;
+    for (size_t s = 0; s < steps; ++s) {
+        unsigned long long now = *ordered.begin() >> SeqBits;
+        ordered.erase(ordered.begin());
+        size_t id = pending + s;
+        ordered.insert(((now + delays[id]) << SeqBits) | (id & SeqMask));
+        setLast = now;
+    }
+    double setMs = msSince(start);
+
+    cout << pending << " pending timers, " << steps << " fire+reschedule steps" << endl;
+    cout << fixed << setprecision(1);
+    cout << "AVLTree popMin:       " << treeMs << " ms" << endl;
+    cout << "std::priority_queue:  " << heapMs << " ms" << endl;
+    cout << "std::set:             " << setMs << " ms" << endl;
+    if (treeLast != heapLast || treeLast != setLast) cout << "(final clocks differ)" << endl;
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include <iostream>
+#include <map>
+#include <vector>
+#include <cstdlib>
+#include "bst.h"
+#include "avlbst.h"
+#include "splaybst.h"
+#include "wavlbst.h"
+#include "lazy-tree.h"
+#include "test-util.h"
+
+using namespace std;
+
+// min() and max() agree with the first and last items of ref.
+template<class Tree>
+bool sameEnds(const Tree& tree, const map<int,int>& ref)
+{
+    if (ref.empty()) return tree.min() == tree.end() && tree.max() == tree.end() && tree.begin() == tree.end();
+    return tree.min() != tree.end() && tree.min()->first == ref.begin()->first
+        && tree.max()->first == ref.rbegin()->first && tree.begin() == tree.min();
+}
+
+// Random inserts and removes, checking the cached ends after every step.
+template<class Tree>
+bool randomOps(Tree& tree, int steps)
+{
+    map<int,int> ref;
+    bool ok = true;
+    for (int step = 0; step < steps; ++step) {
+        int key = rand() % 500;
+        if (rand() % 3 == 0) {
+            tree.remove(key);
+            ref.erase(key);
+        }
+        else {
+            tree.insert(make_pair(key, step));
+            ref[key] = step;
+        }
+        ok = ok && sameEnds(tree, ref);
+    }
+    return ok;
+}
+
+int main()
+{
+    BinarySearchTree<int,int> emptyBst;
+    check(emptyBst.begin() == emptyBst.end(), "begin() on an empty tree is end()");
+    check(emptyBst.min() == emptyBst.end() && emptyBst.max() == emptyBst.end(), "min() and max() on an empty tree");
+
+    srand(38);
+    BinarySearchTree<int,int> bst;
+    check(randomOps(bst, 5000), "BinarySearchTree keeps its ends");
+    SplayTree<int,int> splay;
+    check(randomOps(splay, 5000), "SplayTree keeps its ends");
+    WAVLTree<int,int> wavl;
+    check(randomOps(wavl, 5000), "WAVLTree keeps its ends");
+    AVLTree<int,int> avl;
+    check(randomOps(avl, 5000) && avl.isBalanced(), "AVLTree keeps its ends");
+
+    // popMin and popMax drain the tree in order from both sides
+    AVLTree<int,int> pq;
+    map<int,int> ref;
+    for (int i = 0; i < 2000; ++i) {
+        int key = rand() % 100000;
+        pq.insert(make_pair(key, i));
+        ref[key] = i;
+    }
+    bool ordered = true;
+    while (!ref.empty()) {
+        if (rand() % 2 == 0) {
+            ordered = ordered && pq.min()->first == ref.begin()->first;
+            pq.popMin();
+            ref.erase(ref.begin());
+        }
+        else {
+            ordered = ordered && pq.max()->first == ref.rbegin()->first;
+            pq.popMax();
+            ref.erase(--ref.end());
+        }
+        ordered = ordered && sameEnds(pq, ref);
+    }
+    check(ordered && pq.empty() && pq.isBalanced(), "popMin and popMax drain in key order");
+    pq.popMin();
+    pq.popMax();
+    check(pq.empty(), "popping an empty tree does nothing");
+
+    // interleaved with inserts, as a scheduler would use it
+    bool schedule = true;
+    for (int i = 0; i < 20000; ++i) {
+        int key = rand() % 100000;
+        pq.insert(make_pair(key, i));
+        ref[key] = i;
+        if (i % 3 == 0) {
+            pq.popMin();
+            ref.erase(ref.begin());
+        }
+        if (i % 500 == 0) schedule = schedule && pq.isBalanced();
+        schedule = schedule && sameEnds(pq, ref);
+    }
+    check(schedule, "popMin interleaved with inserts");
+
+    vector<pair<int,int> > sorted;
+    for (int i = 0; i < 100; ++i) sorted.push_back(make_pair(i * 2, i));
+    AVLTree<int,int> loaded;
+    loaded.bulkLoad(sorted.begin(), sorted.end());
+    check(loaded.min()->first == 0 && loaded.max()->first == 198, "bulkLoad sets the ends");
+
+    // the lazy tree pushes pending updates onto the ends before handing them out
+    LazyAVLTree<int,int,RangeAdd<int> > lazy;
+    for (int i = 0; i < 100; ++i) lazy.insert(make_pair(i, 0));
+    lazy.applyRange(0, 99, 5);
+    check(lazy.min()->second == 5 && lazy.max()->second == 5, "lazy min() and max() see updates");
+    lazy.popMin();
+    lazy.popMax();
+    check(lazy.min()->first == 1 && lazy.max()->first == 98 && lazy[50] == 5 && lazy.isBalanced(),
+        "lazy popMin and popMax keep tags");
+
+    return failures == 0 ? 0 : 1;
+}
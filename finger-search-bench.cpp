@@ -0,0 +1,95 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <algorithm>
+#include "avlbst.h"
+
+using namespace std;
+
+double msSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// A sorted batch of probes with small gaps, looked up with find from the root,
+// with findNear, and with a caller-held hint; then a merge-join of two trees
+// that probes the second with a hint from the previous match.
+int main(int argc, char* argv[])
+{
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    size_t probes = argc > 2 ? strtoul(argv[2], NULL, 10) : 1000000;
+
+    mt19937_64 rng(39);
+    vector<pair<long long,int> > items(n);
+    for (size_t i = 0; i < n; ++i) items[i] = make_pair((long long)i * 4, (int)i);
+    AVLTree<long long,int> tree;
+    tree.bulkLoad(items.begin(), items.end());
+
+    vector<long long> keys(probes);
+    long long at = 0;
+    for (size_t i = 0; i < probes; ++i) {
+        at += (long long)(rng() % 16);
+        keys[i] = at % ((long long)n * 4);
+    }
+    sort(keys.begin(), keys.end());
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    size_t rootHits = 0;
+    for (size_t i = 0; i < probes; ++i) rootHits += tree.find(keys[i]) != tree.end();
+    double rootMs = msSince(start);
+
+    start = chrono::steady_clock::now();
+    size_t nearHits = 0;
+    for (size_t i = 0; i < probes; ++i) nearHits += tree.findNear(keys[i]) != tree.end();
+    double nearMs = msSince(start);
+
+    start = chrono::steady_clock::now();
+    size_t hintHits = 0;
+    AVLTree<long long,int>::iterator hint = tree.end();
+    for (size_t i = 0; i < probes; ++i) {
+        AVLTree<long long,int>::iterator it = tree.find(keys[i], hint);
+        if (it != tree.end()) {
+            ++hintHits;
+            hint = it;
+        }
+    }
+    double hintMs = msSince(start);
+
+    // join every third key of a second tree against the first
+    vector<pair<long long,int> > others;
+    for (size_t i = 0; i < n; ++i) others.push_back(make_pair((long long)i * 3, (int)i));
+    AVLTree<long long,int> other;
+    other.bulkLoad(others.begin(), others.end());
+
+    start = chrono::steady_clock::now();
+    size_t plainJoin = 0;
+    for (AVLTree<long long,int>::iterator it = other.begin(); it != other.end(); ++it) {
+        plainJoin += tree.find(it->first) != tree.end();
+    }
+    double plainJoinMs = msSince(start);
+
+    start = chrono::steady_clock::now();
+    size_t fingerJoin = 0;
+    hint = tree.end();
+    for (AVLTree<long long,int>::iterator it = other.begin(); it != other.end(); ++it) {
+        AVLTree<long long,int>::iterator match = tree.find(it->first, hint);
+        if (match != tree.end()) {
+            ++fingerJoin;
+            hint = match;
+        }
+    }
+    double fingerJoinMs = msSince(start);
+
+    cout << n << " keys, " << probes << " sorted probes" << endl;
+    cout << fixed << setprecision(1);
+    cout << "find from root:     " << rootMs << " ms" << endl;
+    cout << "findNear:           " << nearMs << " ms" << endl;
+    cout << "find with hint:     " << hintMs << " ms" << endl;
+    cout << "merge-join, find:   " << plainJoinMs << " ms" << endl;
+    cout << "merge-join, hint:   " << fingerJoinMs << " ms" << endl;
+    if (rootHits != nearHits || rootHits != hintHits || plainJoin != fingerJoin) cout << "(hit counts differ)" << endl;
+    return 0;
+}
@@ -0,0 +1,102 @@
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include "bst.h"
+#include "avlbst.h"
+#include "splaybst.h"
+#include "wavlbst.h"
+#include "lazy-tree.h"
+#include "test-util.h"
+
+using namespace std;
+
+// Hinted finds from random fingers, and findNear, agree with a plain find
+// for keys that are present and keys that are not.
+template<class Tree>
+bool fingersAgree(Tree& tree, int range)
+{
+    vector<typename Tree::iterator> fingers;
+    fingers.push_back(tree.end());
+    for (int i = 0; i < 50; ++i) {
+        typename Tree::iterator it = tree.find(rand() % range);
+        if (it != tree.end()) fingers.push_back(it);
+    }
+    bool ok = true;
+    for (int i = 0; i < 5000; ++i) {
+        int key = rand() % (range + 20) - 10;
+        typename Tree::iterator expect = tree.find(key);
+        ok = ok && tree.find(key, fingers[rand() % fingers.size()]) == expect;
+        ok = ok && tree.findNear(key) == expect;
+    }
+    return ok;
+}
+
+template<class Tree>
+void fill(Tree& tree, int count, int range)
+{
+    for (int i = 0; i < count; ++i) tree.insert(make_pair(rand() % range, i));
+}
+
+int main()
+{
+    srand(39);
+    AVLTree<int,int> avl;
+    check(avl.findNear(5) == avl.end() && avl.find(5, avl.end()) == avl.end(), "finger search on an empty tree");
+
+    fill(avl, 3000, 10000);
+    check(fingersAgree(avl, 10000), "AVLTree finger search matches find");
+    BinarySearchTree<int,int> bst;
+    fill(bst, 2000, 10000);
+    check(fingersAgree(bst, 10000), "BinarySearchTree finger search matches find");
+    WAVLTree<int,int> wavl;
+    fill(wavl, 3000, 10000);
+    check(fingersAgree(wavl, 10000), "WAVLTree finger search matches find");
+
+    // a sorted walk with findNear visits every key in order
+    bool walk = true;
+    int seen = 0;
+    for (int key = 0; key < 10000; ++key) {
+        AVLTree<int,int>::iterator it = avl.findNear(key);
+        if (it != avl.end()) {
+            walk = walk && it->first == key;
+            ++seen;
+        }
+    }
+    int count = 0;
+    for (AVLTree<int,int>::iterator it = avl.begin(); it != avl.end(); ++it) ++count;
+    check(walk && seen == count, "sorted findNear walk finds every key");
+
+    // removing the finger's node must not leave it dangling
+    bool removed = true;
+    for (int i = 0; i < 2000; ++i) {
+        int key = rand() % 10000;
+        avl.findNear(key);
+        avl.remove(key);
+        removed = removed && avl.findNear(key) == avl.end();
+        int other = rand() % 10000;
+        removed = removed && avl.findNear(other) == avl.find(other);
+    }
+    check(removed && avl.isBalanced(), "findNear after removing its finger");
+
+    SplayTree<int,int> splay;
+    fill(splay, 2000, 10000);
+    bool splayOk = true;
+    for (int i = 0; i < 2000; ++i) {
+        int key = rand() % 10000;
+        splay.remove(key);
+        key = rand() % 10000;
+        const SplayTree<int,int>& view = splay;
+        splayOk = splayOk && splay.findNear(key) == view.find(key);
+    }
+    check(splayOk, "SplayTree findNear with removes");
+
+    LazyAVLTree<int,int,RangeAdd<int> > lazy;
+    for (int i = 0; i < 200; ++i) lazy.insert(make_pair(i, i));
+    lazy.findNear(100);
+    lazy.applyRange(50, 150, 1000);
+    LazyAVLTree<int,int,RangeAdd<int> >::iterator hint = lazy.find(10);
+    check(lazy.findNear(120)->second == 1120 && lazy.find(60, hint)->second == 1060,
+        "lazy finger search sees pending updates");
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,66 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include "front-cache.h"
+
+using namespace std;
+
+double msSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// The profiled mix: 40% of lookups miss, and 80% of the hits go to 5% of the
+// keys. The same lookups run on a plain AVLTree and on a FrontCachedTree.
+int main(int argc, char* argv[])
+{
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    size_t lookups = argc > 2 ? strtoul(argv[2], NULL, 10) : 5000000;
+    size_t sets = argc > 3 ? strtoul(argv[3], NULL, 10) : 16384;
+
+    mt19937_64 rng(40);
+    vector<long long> keys(n);
+    for (size_t i = 0; i < n; ++i) keys[i] = (long long)(rng() >> 2) * 2;
+    size_t hot = n / 20;
+
+    vector<long long> probes(lookups);
+    for (size_t i = 0; i < lookups; ++i) {
+        unsigned r = rng() % 100;
+        if (r < 40) probes[i] = (long long)(rng() >> 2) * 2 + 1;
+        else if (r < 88) probes[i] = keys[rng() % hot];
+        else probes[i] = keys[rng() % n];
+    }
+
+    AVLTree<long long,int> plain;
+    FrontCachedTree<long long,int> cached(sets);
+    for (size_t i = 0; i < n; ++i) {
+        plain.insert(make_pair(keys[i], (int)i));
+        cached.insert(make_pair(keys[i], (int)i));
+    }
+    cached.resetStats();
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    size_t plainHits = 0;
+    for (size_t i = 0; i < lookups; ++i) plainHits += plain.find(probes[i]) != plain.end();
+    double plainMs = msSince(start);
+
+    start = chrono::steady_clock::now();
+    size_t cachedHits = 0;
+    for (size_t i = 0; i < lookups; ++i) cachedHits += cached.find(probes[i]) != cached.end();
+    double cachedMs = msSince(start);
+
+    const FrontCacheStats& s = cached.stats();
+    cout << n << " keys, " << lookups << " lookups, " << sets << " cache sets" << endl;
+    cout << fixed << setprecision(1);
+    cout << "AVLTree find:          " << plainMs << " ms" << endl;
+    cout << "FrontCachedTree find:  " << cachedMs << " ms" << endl;
+    cout << setprecision(3);
+    cout << "cache hit rate:        " << s.hitRate() << endl;
+    cout << "filter rejects:        " << s.filterRejects << endl;
+    cout << "false positive rate:   " << s.falsePositiveRate() << endl;
+    if (plainHits != cachedHits) cout << "(hit counts differ)" << endl;
+    return 0;
+}
@@ -0,0 +1,159 @@
+#include <iostream>
+#include <map>
+#include <vector>
+#include <cstdlib>
+#include <stdexcept>
+#include "front-cache.h"
+#include "wavlbst.h"
+#include "test-util.h"
+
+using namespace std;
+
+bool countsAddUp(const FrontCacheStats& s)
+{
+    return s.lookups == s.cacheHits + s.filterRejects + s.treeHits + s.falsePositives;
+}
+
+// Random inserts, removes and lookups, all checked against std::map.
+template<class Tree>
+bool matchesMap(Tree& tree, int steps, int range)
+{
+    map<int,int> ref;
+    bool ok = true;
+    for (int step = 0; step < steps; ++step) {
+        int key = rand() % range;
+        int op = rand() % 4;
+        if (op == 0) {
+            tree.remove(key);
+            ref.erase(key);
+        }
+        else if (op == 1) {
+            tree.insert(make_pair(key, step));
+            ref[key] = step;
+        }
+        else {
+            // skew half the lookups onto a few hot keys
+            if (op == 2) key = rand() % 16;
+            typename Tree::iterator it = tree.find(key);
+            map<int,int>::iterator expect = ref.find(key);
+            if (expect == ref.end()) ok = ok && it == tree.end();
+            else ok = ok && it != tree.end() && it->first == key && it->second == expect->second;
+        }
+    }
+    return ok && countsAddUp(tree.stats());
+}
+
+int main()
+{
+    srand(40);
+    FrontCachedTree<int,int> avl;
+    check(matchesMap(avl, 50000, 5000) && avl.isBalanced(), "AVL base matches std::map");
+    check(avl.stats().cacheHits > 0 && avl.stats().filterRejects > 0, "cache and filter both answer lookups");
+
+    FrontCachedTree<int,int,BinarySearchTree<int,int> > bst(16, 8);
+    check(matchesMap(bst, 20000, 2000), "BinarySearchTree base matches std::map");
+    FrontCachedTree<int,int,WAVLTree<int,int> > wavl(64, 12);
+    check(matchesMap(wavl, 20000, 2000), "WAVLTree base matches std::map");
+    FrontCachedTree<int,int> noCache(0, 10);
+    check(matchesMap(noCache, 10000, 1000) && noCache.stats().cacheHits == 0, "cache turned off");
+    FrontCachedTree<int,int> noFilter(64, 0);
+    check(matchesMap(noFilter, 10000, 1000) && noFilter.stats().filterRejects == 0, "filter turned off");
+
+    // a removed hot key must not be served from the cache
+    FrontCachedTree<int,int> hot;
+    hot.insert(make_pair(7, 70));
+    hot[7] = 71;
+    check(hot.find(7)->second == 71 && hot.stats().cacheHits >= 1, "hot key served from the cache");
+    hot.remove(7);
+    bool threw = false;
+    try {
+        hot[7];
+    }
+    catch (const out_of_range&) {
+        threw = true;
+    }
+    check(hot.find(7) == hot.end() && threw, "remove invalidates the cached entry");
+
+    // absent keys: with 10 bits per key the filter should reject nearly all
+    FrontCachedTree<int,int> filtered;
+    for (int i = 0; i < 100000; ++i) filtered.insert(make_pair(i * 2, i));
+    filtered.resetStats();
+    bool none = true;
+    for (int i = 0; i < 100000; ++i) none = none && filtered.find(i * 2 + 1) == filtered.end();
+    const FrontCacheStats& s = filtered.stats();
+    cout << "false positive rate: " << s.falsePositiveRate() << endl;
+    check(none && s.falsePositiveRate() < 0.03, "filter false positive rate is low");
+
+    // removed keys are rebuilt out of the filter
+    for (int i = 0; i < 100000; ++i) filtered.remove(i * 2);
+    filtered.resetStats();
+    for (int i = 0; i < 1000; ++i) filtered.find(i * 2);
+    check(filtered.empty() && filtered.stats().filterRejects > 900, "filter forgets removed keys after a rebuild");
+
+    // items that leave other than by remove drop their cache entries too
+    FrontCachedTree<int,int> popped;
+    for (int i = 0; i < 100; ++i) popped.insert(make_pair(i, i));
+    popped.find(0);
+    popped.find(99);
+    popped.popMin();
+    popped.popMax();
+    check(popped.find(0) == popped.end() && popped.find(99) == popped.end() && popped.find(1)->second == 1,
+        "popMin and popMax invalidate cached entries");
+
+    // only keys that really leave count towards a rebuild, however they leave
+    FrontCachedTree<int,int> counted;
+    FrontCachedTree<int,int,BinarySearchTree<int,int> > countedBst;
+    for (int i = 0; i < 2000; ++i) {
+        counted.insert(make_pair(i, i));
+        countedBst.insert(make_pair(i, i));
+    }
+    size_t rebuilds = counted.stats().filterRebuilds;
+    size_t rebuildsBst = countedBst.stats().filterRebuilds;
+    for (int i = 0; i < 5000; ++i) {
+        counted.remove(-1 - i);
+        countedBst.remove(-1 - i);
+    }
+    bool missesFree = counted.stats().filterRebuilds == rebuilds && countedBst.stats().filterRebuilds == rebuildsBst;
+    for (int i = 0; i < 1500; ++i) counted.popMin();
+    counted.remove(-1);
+    check(missesFree && counted.stats().filterRebuilds == rebuilds + 1,
+        "removes of absent keys never rebuild, popMin removals do");
+
+    FrontCachedTree<int,int> source;
+    AVLTree<int,int> sink;
+    for (int i = 0; i < 50; ++i) source.insert(make_pair(i, i));
+    for (int i = 0; i < 50; ++i) source.find(i);
+    AVLTree<int,int>& sourceBase = source;
+    sink.merge(sourceBase);
+    bool gone = source.empty();
+    for (int i = 0; i < 50; ++i) gone = gone && source.find(i) == source.end() && sink.find(i) != sink.end();
+    check(gone, "merging out through an AVLTree& invalidates cached entries");
+
+    // node handles moving in reach the filter
+    FrontCachedTree<int,int> target;
+    FrontCachedTree<int,int> donor;
+    for (int i = 0; i < 2000; ++i) donor.insert(make_pair(i, -i));
+    target.insert(donor.extract(5));
+    target.merge(donor);
+    bool arrived = donor.empty();
+    for (int i = 0; i < 2000; ++i) arrived = arrived && target.find(i) != target.end() && target[i] == -i;
+    check(arrived, "extract, insert(NodeHandle&&) and merge keep the filter complete");
+
+    FrontCachedTree<int,int> tried;
+    bool triedOk = true;
+    for (int i = 0; i < 3000; ++i) triedOk = triedOk && tried.tryInsert(make_pair(i, i)).second;
+    for (int i = 0; i < 3000; ++i) triedOk = triedOk && tried.find(i) != tried.end() && tried[i] == i;
+    check(triedOk, "keys added by tryInsert reach the filter");
+
+    vector<pair<int,int> > sorted;
+    for (int i = 0; i < 5000; ++i) sorted.push_back(make_pair(i * 3, i));
+    FrontCachedTree<int,int> loaded;
+    loaded.insert(make_pair(1, 1));
+    loaded.find(1);
+    loaded.bulkLoad(sorted.begin(), sorted.end());
+    bool loadedOk = loaded.find(1) == loaded.end();
+    for (int i = 0; i < 5000; ++i) loadedOk = loadedOk && loaded[i * 3] == i;
+    check(loadedOk, "bulkLoad refills the filter and drops stale entries");
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,427 @@
+#ifndef FRONT_CACHE_H
+#define FRONT_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <utility>
+#include <functional>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include "bst.h"
+#include "avlbst.h"
+
+/**
+* Counters kept by FrontCachedTree. Every lookup ends in exactly one of
+* cacheHits, filterRejects, treeHits or falsePositives (the filter let an
+* absent key through and the tree walk found nothing).
+*/
+struct FrontCacheStats {
+    size_t lookups;
+    size_t cacheHits;
+    size_t filterRejects;
+    size_t treeHits;
+    size_t falsePositives;
+    size_t filterRebuilds;
+
+    FrontCacheStats() :
+        lookups(0), cacheHits(0), filterRejects(0), treeHits(0), falsePositives(0), filterRebuilds(0)
+    {
+
+    }
+
+    double hitRate() const { return lookups == 0 ? 0.0 : (double)cacheHits / lookups; }
+    // Of the lookups for absent keys, the share the filter failed to reject.
+    double falsePositiveRate() const
+    {
+        size_t absent = filterRejects + falsePositives;
+        return absent == 0 ? 0.0 : (double)falsePositives / absent;
+    }
+};
+
+/**
+* The node hooks FrontCachedTree needs from its base. An AVLTree base can
+* also lose nodes without remove (popMin, popMax, clear, extract, and merge
+* into another tree, even through an AVLTree&) and gain them without insert
+* (insert(NodeHandle&&), merge and tryInsert), so for one this layer reports every node
+* that leaves or arrives. Other bases only change through insert and remove
+* and get nothing extra.
+*/
+template <typename Key, typename Value, typename Base,
+    bool Hooked = std::is_base_of<AVLTree<Key, Value>, Base>::value>
+class FrontCacheHooks : public Base
+{
+
+};
+
+template <typename Key, typename Value, typename Base>
+class FrontCacheHooks<Key, Value, Base, true> : public Base
+{
+public:
+    // insert comes here too.
+    virtual std::pair<typename Base::iterator, bool> tryInsert(const std::pair<const Key, Value>& item)
+    {
+        std::pair<typename Base::iterator, bool> result = Base::tryInsert(item);
+        if (result.second) nodeArrived(static_cast<AVLNode<Key, Value>*>(this->nodeOf(result.first)));
+        return result;
+    }
+
+protected:
+    // n is about to leave; destroyed is false if it only moves elsewhere.
+    virtual void nodeLeaving(AVLNode<Key, Value>* n, bool destroyed) = 0;
+    // n has just been linked in.
+    virtual void nodeArrived(AVLNode<Key, Value>* n) = 0;
+
+    virtual void destroyNode(AVLNode<Key, Value>* node)
+    {
+        nodeLeaving(node, true);
+        Base::destroyNode(node);
+    }
+
+    virtual void extractNode(AVLNode<Key, Value>* n)
+    {
+        nodeLeaving(n, false);
+        Base::extractNode(n);
+    }
+
+    virtual bool insertNode(AVLNode<Key, Value>* n)
+    {
+        if (!Base::insertNode(n)) return false;
+        nodeArrived(n);
+        return true;
+    }
+};
+
+/**
+* A search tree with a front layer on find and operator[]:
+*
+*   a set-associative cache of recently found key -> item positions, so hot
+*   keys skip the tree walk; each set holds Ways entries in most-recently
+*   used order and a key can only live in the set its hash picks
+*
+*   a Bloom filter over every stored key, so most lookups for absent keys
+*   are answered without touching the tree
+*
+* Every node that leaves the tree drops its cache entry first. A Bloom filter cannot forget a key, so
+* removed keys only raise the false positive rate until the filter is
+* rebuilt, which happens after as many removes as half its capacity, or
+* when inserts fill it. Keys need a std::hash specialization.
+*
+* Base is the tree underneath (AVLTree by default; BinarySearchTree and
+* WAVLTree work too). Like the tree's own finger, the cache and counters
+* change on const lookups, so lookups must not run concurrently.
+*/
+template <typename Key, typename Value, typename Base = AVLTree<Key, Value> >
+class FrontCachedTree : public FrontCacheHooks<Key, Value, Base>
+{
+public:
+    typedef typename BinarySearchTree<Key, Value>::iterator iterator;
+    static const size_t Ways = 4;
+
+    // cacheSets is rounded up to a power of two; 0 turns the cache off.
+    // filterBitsPerKey of 0 turns the filter off.
+    explicit FrontCachedTree(size_t cacheSets = 256, size_t filterBitsPerKey = 10);
+    virtual ~FrontCachedTree();
+
+    // An AVLTree base's insert(NodeHandle&&) stays visible.
+    using FrontCacheHooks<Key, Value, Base>::insert;
+    virtual void insert(const std::pair<const Key, Value>& keyValuePair);
+    virtual void remove(const Key& key);
+    // Only for an AVLTree base; the filter is rebuilt for the loaded keys.
+    template<class InputIt>
+    void bulkLoad(InputIt first, InputIt last);
+
+    iterator find(const Key& key) const;
+    Value& operator[](const Key& key);
+    Value const & operator[](const Key& key) const;
+
+    const FrontCacheStats& stats() const;
+    void resetStats();
+
+protected:
+    static uint64_t hashOf(const Key& key);
+
+    bool filterMayContain(uint64_t h) const;
+    void filterAdd(uint64_t h);
+    void filterSet(uint64_t h);
+    void rebuildFilter(size_t capacity);
+
+    iterator* cacheSet(uint64_t h) const;
+    void cacheStore(uint64_t h, const iterator& it) const;
+    void cacheErase(const Key& key);
+    // Called by FrontCacheHooks for an AVLTree base. Every node that leaves
+    // counts as a remove for the filter.
+    void nodeLeaving(AVLNode<Key, Value>* n, bool destroyed);
+    void nodeArrived(AVLNode<Key, Value>* n);
+
+    size_t cacheMask_;                       // number of sets - 1
+    mutable std::vector<iterator> cache_;   // Ways entries per set, MRU first
+    size_t bitsPerKey_;
+    size_t hashCount_;
+    std::vector<uint64_t> filter_;
+    size_t filterCapacity_;    // keys the filter was sized for
+    size_t filterKeys_;        // keys added since the last rebuild
+    size_t removedSinceBuild_;
+    mutable FrontCacheStats stats_;
+};
+
+/*
+  -----------------------------------------------------
+  Begin implementations for the FrontCachedTree class.
+  -----------------------------------------------------
+*/
+
+template<class Key, class Value, class Base>
+FrontCachedTree<Key, Value, Base>::FrontCachedTree(size_t cacheSets, size_t filterBitsPerKey) :
+    cacheMask_(0), bitsPerKey_(filterBitsPerKey), hashCount_(0),
+    filterCapacity_(0), filterKeys_(0), removedSinceBuild_(0)
+{
+    if (cacheSets > 0) {
+        size_t sets = 1;
+        while (sets < cacheSets) sets *= 2;
+        cacheMask_ = sets - 1;
+        cache_.assign(sets * Ways, this->end());
+    }
+    // k = bits per key * ln 2 minimizes the false positive rate
+    hashCount_ = (bitsPerKey_ * 69 + 50) / 100;
+    if (hashCount_ == 0 && bitsPerKey_ > 0) hashCount_ = 1;
+    if (bitsPerKey_ > 0) rebuildFilter(1024);
+    stats_ = FrontCacheStats();
+}
+
+template<class Key, class Value, class Base>
+FrontCachedTree<Key, Value, Base>::~FrontCachedTree()
+{
+
+}
+
+/**
+* std::hash is the identity for integers on common libraries, so its result
+* is mixed (the splitmix64 finalizer) before picking sets and filter bits.
+*/
+template<class Key, class Value, class Base>
+uint64_t FrontCachedTree<Key, Value, Base>::hashOf(const Key& key)
+{
+    uint64_t h = (uint64_t)std::hash<Key>()(key);
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+/**
+* The k probe positions come from two halves of one hash (double hashing).
+*/
+template<class Key, class Value, class Base>
+bool FrontCachedTree<Key, Value, Base>::filterMayContain(uint64_t h) const
+{
+    if (filter_.empty()) return true;
+    uint64_t bits = (uint64_t)filter_.size() * 64;
+    uint64_t step = (h >> 32) | 1;
+    for (size_t i = 0; i < hashCount_; ++i) {
+        uint64_t bit = (h + i * step) % bits;
+        if ((filter_[bit / 64] & (1ULL << (bit % 64))) == 0) return false;
+    }
+    return true;
+}
+
+template<class Key, class Value, class Base>
+void FrontCachedTree<Key, Value, Base>::filterAdd(uint64_t h)
+{
+    if (filter_.empty()) return;
+    if (filterKeys_ >= filterCapacity_) {
+        rebuildFilter(filterCapacity_ * 2);
+    }
+    filterSet(h);
+    ++filterKeys_;
+}
+
+template<class Key, class Value, class Base>
+void FrontCachedTree<Key, Value, Base>::filterSet(uint64_t h)
+{
+    uint64_t bits = (uint64_t)filter_.size() * 64;
+    uint64_t step = (h >> 32) | 1;
+    for (size_t i = 0; i < hashCount_; ++i) {
+        uint64_t bit = (h + i * step) % bits;
+        filter_[bit / 64] |= 1ULL << (bit % 64);
+    }
+}
+
+/**
+* Resizes the filter for at least capacity keys, and for twice the keys in
+* the tree, then re-adds every key in the tree.
+*/
+template<class Key, class Value, class Base>
+void FrontCachedTree<Key, Value, Base>::rebuildFilter(size_t capacity)
+{
+    if (bitsPerKey_ == 0) return;
+    size_t count = 0;
+    for (iterator it = this->begin(); it != this->end(); ++it) ++count;
+    filterCapacity_ = std::max(capacity, count * 2);
+    filter_.assign((filterCapacity_ * bitsPerKey_ + 63) / 64, 0);
+    for (iterator it = this->begin(); it != this->end(); ++it) filterSet(hashOf(it->first));
+    filterKeys_ = count;
+    removedSinceBuild_ = 0;
+    ++stats_.filterRebuilds;
+}
+
+template<class Key, class Value, class Base>
+typename FrontCachedTree<Key, Value, Base>::iterator* FrontCachedTree<Key, Value, Base>::cacheSet(uint64_t h) const
+{
+    return &cache_[(size_t)(h & cacheMask_) * Ways];
+}
+
+/**
+* Moves it to the front of its set, dropping the least recently used entry.
+*/
+template<class Key, class Value, class Base>
+void FrontCachedTree<Key, Value, Base>::cacheStore(uint64_t h, const iterator& it) const
+{
+    if (cache_.empty()) return;
+    iterator* set = cacheSet(h);
+    size_t i = 0;
+    while (i < Ways - 1 && set[i] != it) ++i;
+    for (; i > 0; --i) set[i] = set[i - 1];
+    set[0] = it;
+}
+
+template<class Key, class Value, class Base>
+void FrontCachedTree<Key, Value, Base>::cacheErase(const Key& key)
+{
+    if (cache_.empty()) return;
+    iterator* set = cacheSet(hashOf(key));
+    for (size_t i = 0; i < Ways; ++i) {
+        if (set[i] != this->end() && set[i]->first == key) {
+            for (size_t j = i; j + 1 < Ways; ++j) set[j] = set[j + 1];
+            set[Ways - 1] = this->end();
+            return;
+        }
+    }
+}
+
+template<class Key, class Value, class Base>
+void FrontCachedTree<Key, Value, Base>::nodeLeaving(AVLNode<Key, Value>* n, bool destroyed)
+{
+    cacheErase(n->getKey());
+    // n is still linked, so any rebuild waits for the next remove
+    ++removedSinceBuild_;
+}
+
+template<class Key, class Value, class Base>
+void FrontCachedTree<Key, Value, Base>::nodeArrived(AVLNode<Key, Value>* n)
+{
+    filterAdd(hashOf(n->getKey()));
+}
+
+template<class Key, class Value, class Base>
+void FrontCachedTree<Key, Value, Base>::insert(const std::pair<const Key, Value>& keyValuePair)
+{
+    // an AVLTree base reports new keys to nodeArrived in the same descent
+    if (std::is_base_of<AVLTree<Key, Value>, Base>::value) {
+        Base::insert(keyValuePair);
+        return;
+    }
+    // a key the filter rejects is certainly new, so only the others pay for a lookup
+    uint64_t h = hashOf(keyValuePair.first);
+    bool present = filterMayContain(h) && BinarySearchTree<Key, Value>::find(keyValuePair.first) != this->end();
+    Base::insert(keyValuePair);
+    if (!present) filterAdd(h);
+}
+
+template<class Key, class Value, class Base>
+void FrontCachedTree<Key, Value, Base>::remove(const Key& key)
+{
+    cacheErase(key);
+    if (std::is_base_of<AVLTree<Key, Value>, Base>::value) {
+        // an AVLTree base counts the node, if there is one, in nodeLeaving
+        Base::remove(key);
+    }
+    else {
+        bool present = !filter_.empty() && filterMayContain(hashOf(key))
+            && BinarySearchTree<Key, Value>::find(key) != this->end();
+        Base::remove(key);
+        if (present) ++removedSinceBuild_;
+    }
+    if (!filter_.empty() && removedSinceBuild_ > filterCapacity_ / 2) rebuildFilter(filterCapacity_);
+}
+
+template<class Key, class Value, class Base>
+template<class InputIt>
+void FrontCachedTree<Key, Value, Base>::bulkLoad(InputIt first, InputIt last)
+{
+    Base::bulkLoad(first, last);
+    if (!filter_.empty()) rebuildFilter(1024);
+}
+
+/**
+* Cache first, so hot keys cost one hash and a few compares; then the
+* filter, so most absent keys never reach the tree; then the tree itself.
+*/
+template<class Key, class Value, class Base>
+typename FrontCachedTree<Key, Value, Base>::iterator FrontCachedTree<Key, Value, Base>::find(const Key& key) const
+{
+    ++stats_.lookups;
+    uint64_t h = hashOf(key);
+    if (!cache_.empty()) {
+        iterator* set = cacheSet(h);
+        for (size_t i = 0; i < Ways && set[i] != this->end(); ++i) {
+            if (set[i]->first == key) {
+                ++stats_.cacheHits;
+                iterator it = set[i];
+                cacheStore(h, it);
+                return it;
+            }
+        }
+    }
+    if (!filterMayContain(h)) {
+        ++stats_.filterRejects;
+        return this->end();
+    }
+    iterator it = BinarySearchTree<Key, Value>::find(key);
+    if (it == this->end()) {
+        ++stats_.falsePositives;
+        return it;
+    }
+    ++stats_.treeHits;
+    cacheStore(h, it);
+    return it;
+}
+
+template<class Key, class Value, class Base>
+Value& FrontCachedTree<Key, Value, Base>::operator[](const Key& key)
+{
+    iterator it = find(key);
+    if (it == this->end()) throw std::out_of_range("Invalid key");
+    return it->second;
+}
+
+template<class Key, class Value, class Base>
+Value const & FrontCachedTree<Key, Value, Base>::operator[](const Key& key) const
+{
+    iterator it = find(key);
+    if (it == this->end()) throw std::out_of_range("Invalid key");
+    return it->second;
+}
+
+template<class Key, class Value, class Base>
+const FrontCacheStats& FrontCachedTree<Key, Value, Base>::stats() const
+{
+    return stats_;
+}
+
+template<class Key, class Value, class Base>
+void FrontCachedTree<Key, Value, Base>::resetStats()
+{
+    stats_ = FrontCacheStats();
+}
+
+/*
+  ---------------------------------------------------
+  End implementations for the FrontCachedTree class.
+  ---------------------------------------------------
+*/
+
+#endif
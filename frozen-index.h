@@ -0,0 +1,119 @@
+#ifndef FROZEN_INDEX_H
+#define FROZEN_INDEX_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "bst.h"
+#include "simd-search.h"
+
+/**
+* A read-only snapshot of a search tree laid out as two sorted arrays. Lookups
+* binary search the upper levels of the implicit tree and finish with one
+* vectorized count over the last simd::SearchWindow keys, so the lower levels
+* cost no pointer chasing and no mispredicted branches. Rebuild it with
+* build() after the source tree changes.
+*/
+template <typename Key, typename Value>
+class FrozenIndex
+{
+public:
+    FrozenIndex();
+    explicit FrozenIndex(const BinarySearchTree<Key, Value>& tree);
+
+    void build(const BinarySearchTree<Key, Value>& tree);
+    bool empty() const;
+    size_t size() const;
+
+    // Returns the value stored for key, or NULL if key is absent.
+    const Value* find(const Key& key) const;
+    // Position of the first key not less than key; size() if there is none.
+    size_t lowerBound(const Key& key) const;
+
+    const Key& keyAt(size_t i) const;
+    const Value& valueAt(size_t i) const;
+
+protected:
+    std::vector<Key> keys_;
+    std::vector<Value> values_;
+};
+
+/*
+  -------------------------------------------------
+  Begin implementations for the FrozenIndex class.
+  -------------------------------------------------
+*/
+
+template<class Key, class Value>
+FrozenIndex<Key, Value>::FrozenIndex()
+{
+
+}
+
+template<class Key, class Value>
+FrozenIndex<Key, Value>::FrozenIndex(const BinarySearchTree<Key, Value>& tree)
+{
+    build(tree);
+}
+
+/**
+* Copies the tree's items in order; the tree iterator already yields them sorted.
+*/
+template<class Key, class Value>
+void FrozenIndex<Key, Value>::build(const BinarySearchTree<Key, Value>& tree)
+{
+    keys_.clear();
+    values_.clear();
+    if (tree.empty()) return;
+    for (typename BinarySearchTree<Key, Value>::iterator it = tree.begin(); it != tree.end(); ++it) {
+        keys_.push_back(it->first);
+        values_.push_back(it->second);
+    }
+}
+
+template<class Key, class Value>
+bool FrozenIndex<Key, Value>::empty() const
+{
+    return keys_.empty();
+}
+
+template<class Key, class Value>
+size_t FrozenIndex<Key, Value>::size() const
+{
+    return keys_.size();
+}
+
+template<class Key, class Value>
+size_t FrozenIndex<Key, Value>::lowerBound(const Key& key) const
+{
+    if (keys_.empty()) return 0;
+    return simd::lowerBound(&keys_[0], keys_.size(), key);
+}
+
+template<class Key, class Value>
+const Value* FrozenIndex<Key, Value>::find(const Key& key) const
+{
+    size_t pos = lowerBound(key);
+    if (pos == keys_.size() || key < keys_[pos]) return NULL;
+    return &values_[pos];
+}
+
+template<class Key, class Value>
+const Key& FrozenIndex<Key, Value>::keyAt(size_t i) const
+{
+    return keys_[i];
+}
+
+template<class Key, class Value>
+const Value& FrozenIndex<Key, Value>::valueAt(size_t i) const
+{
+    return values_[i];
+}
+
+/*
+  -----------------------------------------------
+  End implementations for the FrozenIndex class.
+  -----------------------------------------------
+*/
+
+#endif
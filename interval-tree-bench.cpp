@@ -0,0 +1,62 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include "interval-tree.h"
+
+using namespace std;
+
+double msSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// Overlap queries over n short random intervals (10M by default), answered
+// by the interval tree and by a linear scan of the same intervals.
+int main(int argc, char* argv[])
+{
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 10000000;
+    size_t queries = argc > 2 ? strtoul(argv[2], NULL, 10) : 200;
+    long long span = (long long)n * 100;
+
+    mt19937_64 rng(36);
+    vector<Interval<long long> > intervals(n);
+    for (size_t i = 0; i < n; ++i) {
+        long long lo = (long long)(rng() % span);
+        intervals[i] = Interval<long long>(lo, lo + (long long)(rng() % 1000));
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    IntervalTree<long long,int> tree;
+    for (size_t i = 0; i < n; ++i) tree.insert(make_pair(intervals[i], (int)i));
+    double buildMs = msSince(start);
+
+    vector<long long> starts(queries);
+    for (size_t q = 0; q < queries; ++q) starts[q] = (long long)(rng() % span);
+
+    start = chrono::steady_clock::now();
+    size_t treeHits = 0;
+    for (size_t q = 0; q < queries; ++q) {
+        tree.overlapping(starts[q], starts[q] + 5000, [&treeHits](const Interval<long long>&, const int&) { ++treeHits; });
+    }
+    double treeMs = msSince(start);
+
+    start = chrono::steady_clock::now();
+    size_t scanHits = 0;
+    for (size_t q = 0; q < queries; ++q) {
+        for (size_t i = 0; i < n; ++i) {
+            if (intervals[i].overlaps(starts[q], starts[q] + 5000)) ++scanHits;
+        }
+    }
+    double scanMs = msSince(start);
+
+    cout << n << " intervals, " << queries << " overlap queries" << endl;
+    cout << fixed << setprecision(3);
+    cout << "build:            " << buildMs << " ms" << endl;
+    cout << "interval tree:    " << treeMs / queries << " ms/query" << endl;
+    cout << "linear scan:      " << scanMs / queries << " ms/query" << endl;
+    if (treeHits != scanHits) cout << "(hit counts differ: " << treeHits << " vs " << scanHits << ")" << endl;
+    return 0;
+}
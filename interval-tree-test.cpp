@@ -0,0 +1,94 @@
+#include <iostream>
+#include <vector>
+#include <map>
+#include <cstdlib>
+#include <stdexcept>
+#include "interval-tree.h"
+#include "test-util.h"
+
+using namespace std;
+
+typedef IntervalTree<int,int>::Match Match;
+
+vector<Match> scan(const map<Interval<int>,int>& ref, int lo, int hi)
+{
+    vector<Match> matches;
+    for (map<Interval<int>,int>::const_iterator it = ref.begin(); it != ref.end(); ++it) {
+        if (it->first.overlaps(lo, hi)) matches.push_back(*it);
+    }
+    return matches;
+}
+
+bool same(const vector<Match>& a, const vector<Match>& b)
+{
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (!(a[i].first == b[i].first) || a[i].second != b[i].second) return false;
+    }
+    return true;
+}
+
+int main()
+{
+    IntervalTree<int,int> bookings;
+    bookings.insert(make_pair(Interval<int>(9, 10), 1));
+    bookings.insert(make_pair(Interval<int>(13, 15), 2));
+    bookings.insert(make_pair(Interval<int>(10, 12), 3));
+    bookings.insert(make_pair(Interval<int>(1, 30), 4));
+    vector<Match> at10 = bookings.stabbing(10);
+    check(at10.size() == 3 && at10[0].second == 4 && at10[1].second == 1 && at10[2].second == 3,
+        "stabbing finds every interval containing the point, in order");
+    check(bookings.overlapping(11, 12).size() == 2 && bookings.overlapping(31, 40).empty(), "overlapping");
+    bookings.remove(Interval<int>(1, 30));
+    check(bookings.stabbing(20).empty() && bookings.stabbing(14).size() == 1, "removed intervals stop matching");
+
+    bool threw = false;
+    try {
+        bookings.insert(make_pair(Interval<int>(5, 4), 0));
+    }
+    catch (const invalid_argument&) {
+        threw = true;
+    }
+    bool triedThrew = false;
+    try {
+        bookings.tryInsert(make_pair(Interval<int>(9, 2), 0));
+    }
+    catch (const invalid_argument&) {
+        triedThrew = true;
+    }
+    check(threw && triedThrew, "backwards intervals are rejected");
+
+    // random inserts and removes against a brute-force scan
+    IntervalTree<int,int> tree;
+    map<Interval<int>,int> ref;
+    srand(36);
+    bool agree = true;
+    for (int step = 0; step < 20000; ++step) {
+        int lo = rand() % 10000;
+        Interval<int> iv(lo, lo + rand() % (rand() % 10 == 0 ? 2000 : 50));
+        if (rand() % 4 == 0 && !ref.empty()) {
+            map<Interval<int>,int>::iterator victim = ref.lower_bound(iv);
+            if (victim == ref.end()) victim = ref.begin();
+            tree.remove(victim->first);
+            ref.erase(victim);
+        }
+        else {
+            tree.insert(make_pair(iv, step));
+            ref[iv] = step;
+        }
+        if (step % 100 == 0) {
+            int qlo = rand() % 10500;
+            int qhi = qlo + rand() % 300;
+            agree = agree && same(tree.overlapping(qlo, qhi), scan(ref, qlo, qhi))
+                && same(tree.stabbing(qlo), scan(ref, qlo, qlo));
+        }
+    }
+    check(agree, "queries match a scan under random updates");
+    check(tree.isBalanced(), "tree stays balanced");
+
+    int calls = 0;
+    tree.overlapping(0, 20000, [&calls](const Interval<int>&, const int&) { ++calls; });
+    check(calls == (int)ref.size(), "a range covering everything reports every interval");
+
+    return failures == 0 ? 0 : 1;
+}
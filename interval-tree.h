@@ -0,0 +1,152 @@
+#ifndef INTERVAL_TREE_H
+#define INTERVAL_TREE_H
+
+#include <iostream>
+#include <vector>
+#include <limits>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include "aggregate-tree.h"
+
+/**
+* A closed interval [lo, hi]. Intervals order by lo, then by hi, so the same
+* interval can only be stored once per tree.
+*/
+template <typename T>
+struct Interval {
+    T lo;
+    T hi;
+
+    Interval() : lo(), hi() { }
+    Interval(const T& lo_, const T& hi_) : lo(lo_), hi(hi_) { }
+
+    bool overlaps(const T& from, const T& to) const { return !(to < lo) && !(hi < from); }
+
+    bool operator<(const Interval& rhs) const { return lo < rhs.lo || (!(rhs.lo < lo) && hi < rhs.hi); }
+    bool operator>(const Interval& rhs) const { return rhs < *this; }
+    bool operator==(const Interval& rhs) const { return !(*this < rhs) && !(rhs < *this); }
+};
+
+template <typename T>
+std::ostream& operator<<(std::ostream& out, const Interval<T>& interval)
+{
+    return out << "[" << interval.lo << "," << interval.hi << "]";
+}
+
+/**
+* The largest endpoint in a subtree of intervals.
+*/
+template <typename T>
+struct MaxEndOf {
+    typedef T type;
+    static T identity() { return std::numeric_limits<T>::lowest(); }
+    static T combine(const T& a, const T& b) { return std::max(a, b); }
+    template<class Value>
+    static T of(const Interval<T>& key, const Value&) { return key.hi; }
+};
+
+/**
+* An AVL tree of intervals, keyed by start point, where every node also knows
+* the largest end point in its subtree. That bound lets overlap and stabbing
+* queries skip any subtree that ends before the query starts, so they cost
+* O(log n + k) for k matches instead of a scan. The bound is an
+* AggregateAVLTree aggregate, so rotations and the rebalancing in insertFix
+* and removeFix keep it up to date.
+*/
+template <typename T, typename Value>
+class IntervalTree : public AggregateAVLTree<Interval<T>, Value, MaxEndOf<T> >
+{
+public:
+    typedef std::pair<Interval<T>, Value> Match;
+    typedef typename AVLTree<Interval<T>, Value>::iterator iterator;
+
+    // insert and tryInsert throw std::invalid_argument if the interval ends
+    // before it starts.
+    virtual std::pair<iterator, bool> tryInsert(const std::pair<const Interval<T>, Value>& new_item);
+
+    // Every stored interval that shares a point with [lo, hi], in key order.
+    std::vector<Match> overlapping(const T& lo, const T& hi) const;
+    // Every stored interval that contains point, in key order.
+    std::vector<Match> stabbing(const T& point) const;
+
+    // Callback forms: f(interval, value) is called for each match in key order.
+    template<class F>
+    void overlapping(const T& lo, const T& hi, F f) const;
+    template<class F>
+    void stabbing(const T& point, F f) const;
+
+protected:
+    typedef AVLNode<Interval<T>, Value> INode;
+
+    template<class F>
+    static void overlapHelper(const INode* n, const T& lo, const T& hi, F& f);
+};
+
+/*
+  -------------------------------------------------
+  Begin implementations for the IntervalTree class.
+  -------------------------------------------------
+*/
+
+template<class T, class Value>
+std::pair<typename IntervalTree<T, Value>::iterator, bool> IntervalTree<T, Value>::tryInsert(
+    const std::pair<const Interval<T>, Value>& new_item)
+{
+    if (new_item.first.hi < new_item.first.lo) throw std::invalid_argument("Interval ends before it starts");
+    return AggregateAVLTree<Interval<T>, Value, MaxEndOf<T> >::tryInsert(new_item);
+}
+
+/**
+* Prunes a subtree whose largest end point is below lo, and everything to the
+* right of a node that starts after hi.
+*/
+template<class T, class Value>
+template<class F>
+void IntervalTree<T, Value>::overlapHelper(const INode* n, const T& lo, const T& hi, F& f)
+{
+    if (n == NULL || IntervalTree::of(n) < lo) return;
+    overlapHelper(n->getLeft(), lo, hi, f);
+    if (hi < n->getKey().lo) return;
+    if (!(n->getKey().hi < lo)) f(n->getKey(), n->getValue());
+    overlapHelper(n->getRight(), lo, hi, f);
+}
+
+template<class T, class Value>
+template<class F>
+void IntervalTree<T, Value>::overlapping(const T& lo, const T& hi, F f) const
+{
+    if (hi < lo) return;
+    overlapHelper(static_cast<const INode*>(this->root_), lo, hi, f);
+}
+
+template<class T, class Value>
+template<class F>
+void IntervalTree<T, Value>::stabbing(const T& point, F f) const
+{
+    overlapping(point, point, f);
+}
+
+template<class T, class Value>
+std::vector<typename IntervalTree<T, Value>::Match> IntervalTree<T, Value>::overlapping(const T& lo, const T& hi) const
+{
+    std::vector<Match> matches;
+    overlapping(lo, hi, [&matches](const Interval<T>& key, const Value& value) {
+        matches.push_back(std::make_pair(key, value));
+    });
+    return matches;
+}
+
+template<class T, class Value>
+std::vector<typename IntervalTree<T, Value>::Match> IntervalTree<T, Value>::stabbing(const T& point) const
+{
+    return overlapping(point, point);
+}
+
+/*
+  -----------------------------------------------
+  End implementations for the IntervalTree class.
+  -----------------------------------------------
+*/
+
+#endif
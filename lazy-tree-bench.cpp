@@ -0,0 +1,59 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include "lazy-tree.h"
+
+using namespace std;
+
+double msSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// Shifts every value in random key windows, once with applyRange and once by
+// looking up each key and updating it in place, then reads a sample back.
+int main(int argc, char* argv[])
+{
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+    int updates = argc > 2 ? atoi(argv[2]) : 2000;
+    int window = argc > 3 ? atoi(argv[3]) : n / 20;
+
+    AVLTree<int,long long> plain;
+    LazyAVLTree<int,long long,RangeAdd<long long> > lazy;
+    vector<pair<int,long long> > sorted;
+    for (int i = 0; i < n; ++i) sorted.push_back(make_pair(i, 0LL));
+    plain.bulkLoad(sorted.begin(), sorted.end());
+    lazy.bulkLoad(sorted.begin(), sorted.end());
+
+    mt19937 rng(35);
+    vector<int> los(updates);
+    for (int u = 0; u < updates; ++u) los[u] = rng() % n;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int u = 0; u < updates; ++u) {
+        for (int k = los[u]; k <= los[u] + window && k < n; ++k) plain[k] += 3;
+    }
+    double eachMs = msSince(start);
+
+    start = chrono::steady_clock::now();
+    for (int u = 0; u < updates; ++u) lazy.applyRange(los[u], los[u] + window, 3);
+    double lazyMs = msSince(start);
+
+    start = chrono::steady_clock::now();
+    long long sink = 0;
+    for (int i = 0; i < n; i += 97) sink += lazy[i];
+    double readMs = msSince(start);
+
+    bool same = true;
+    for (int i = 0; i < n; i += 97) same = same && plain[i] == lazy[i];
+
+    cout << n << " entries, " << updates << " updates of " << window << " keys" << endl;
+    cout << fixed << setprecision(1);
+    cout << "per-key updates:      " << eachMs << " ms" << endl;
+    cout << "applyRange:           " << lazyMs << " ms" << endl;
+    cout << "sampled reads after:  " << readMs << " ms" << (same ? "" : " (MISMATCH)") << endl;
+    return sink == 42 ? 1 : 0;
+}
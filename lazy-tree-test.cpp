@@ -0,0 +1,122 @@
+#include <iostream>
+#include <map>
+#include <cstdlib>
+#include "lazy-tree.h"
+#include "test-util.h"
+
+using namespace std;
+
+template<class Tree>
+bool sameContents(const Tree& tree, const map<int,long>& ref)
+{
+    if (tree.empty()) return ref.empty();
+    map<int,long>::const_iterator r = ref.begin();
+    for (typename Tree::iterator it = tree.begin(); it != tree.end(); ++it, ++r) {
+        if (r == ref.end() || it->first != r->first || it->second != r->second) return false;
+    }
+    return r == ref.end();
+}
+
+int main()
+{
+    LazyAVLTree<int,long,RangeAdd<long> > adds;
+    map<int,long> ref;
+    for (int i = 0; i < 100; ++i) {
+        adds.insert(make_pair(i, 0L));
+        ref[i] = 0;
+    }
+    adds.applyRange(10, 19, 5);
+    adds.applyRange(15, 40, 1);
+    for (int i = 10; i <= 19; ++i) ref[i] += 5;
+    for (int i = 15; i <= 40; ++i) ref[i] += 1;
+    check(adds[12] == 5 && adds[17] == 6 && adds[30] == 1 && adds[9] == 0, "overlapping adds are visible to operator[]");
+    check(adds.find(16)->second == 6, "find sees pending adds");
+    check(sameContents(adds, ref), "iteration sees pending adds");
+
+    // random mix of range updates, inserts, removes and lookups
+    srand(35);
+    bool agree = true;
+    for (int step = 0; step < 20000; ++step) {
+        int key = rand() % 1000;
+        int op = rand() % 5;
+        if (op == 0) {
+            adds.remove(key);
+            ref.erase(key);
+        }
+        else if (op == 1) {
+            adds.insert(make_pair(key, (long)key));
+            ref[key] = key;
+        }
+        else if (op == 2) {
+            int hi = key + rand() % 200;
+            long delta = rand() % 21 - 10;
+            adds.applyRange(key, hi, delta);
+            for (map<int,long>::iterator it = ref.lower_bound(key); it != ref.end() && it->first <= hi; ++it) {
+                it->second += delta;
+            }
+        }
+        else {
+            map<int,long>::iterator r = ref.find(key);
+            LazyAVLTree<int,long,RangeAdd<long> >::iterator it = adds.find(key);
+            if (r == ref.end()) agree = agree && it == adds.end();
+            else agree = agree && it != adds.end() && it->second == r->second;
+        }
+        if (step % 2000 == 0) agree = agree && sameContents(adds, ref);
+    }
+    check(agree && sameContents(adds, ref), "random adds match a std::map");
+    check(adds.isBalanced(), "tree stays balanced");
+
+    // assignment does not commute, so tags must stay in order
+    LazyAVLTree<int,long,RangeAssign<long> > sets;
+    map<int,long> setRef;
+    for (int i = 0; i < 500; ++i) {
+        sets.insert(make_pair(i, -1L));
+        setRef[i] = -1;
+    }
+    agree = true;
+    for (int step = 0; step < 5000; ++step) {
+        int lo = rand() % 500;
+        int hi = lo + rand() % 100;
+        long value = step;
+        sets.applyRange(lo, hi, value);
+        for (map<int,long>::iterator it = setRef.lower_bound(lo); it != setRef.end() && it->first <= hi; ++it) {
+            it->second = value;
+        }
+        if (step % 7 == 0) {
+            int key = rand() % 500;
+            sets.remove(key);
+            setRef.erase(key);
+            sets.insert(make_pair(key + 500, 0L));
+            setRef[key + 500] = 0;
+        }
+        if (step % 500 == 0) agree = agree && sameContents(sets, setRef);
+    }
+    check(agree && sameContents(sets, setRef), "later assignments win over earlier ones");
+
+    // code that only holds a base-class reference walks from begin(), which
+    // flushes through the virtual hook
+    LazyAVLTree<int,long,RangeAdd<long> > zeros;
+    for (int i = 0; i < 1000; ++i) zeros.insert(make_pair(i, 0L));
+    zeros.applyRange(0, 999, 1);
+    const BinarySearchTree<int,long>& base = zeros;
+    long total = 0;
+    for (BinarySearchTree<int,long>::iterator it = base.begin(); it != base.end(); ++it) total += it->second;
+    check(total == 1000, "a walk through a base-class reference sees pending adds");
+    zeros.applyRange(0, 499, 1);
+    zeros.flush();
+    const AVLTree<int,long>& avlBase = zeros;
+    check(avlBase.find(10)->second == 2 && avlBase[600] == 1, "base-class lookups are exact after flush()");
+
+    // a key added by tryInsert joins below pending tags without picking them up
+    LazyAVLTree<int,long,RangeAdd<long> > tried;
+    for (int i = 0; i < 100; i += 2) tried.insert(make_pair(i, 0L));
+    tried.applyRange(0, 100, 5);
+    bool added = tried.tryInsert(make_pair(51, 1L)).second && !tried.tryInsert(make_pair(50, 1L)).second;
+    check(added && tried[51] == 1 && tried[50] == 5 && tried[52] == 5, "tryInsert sees pending adds");
+
+    LazyAVLTree<int,long,RangeAdd<long> > empty;
+    empty.applyRange(0, 10, 1);
+    check(empty.begin() == empty.end() && empty.find(3) == empty.end(), "updates on an empty tree do nothing");
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,450 @@
+#ifndef LAZY_TREE_H
+#define LAZY_TREE_H
+
+#include <cstddef>
+#include "avlbst.h"
+
+/**
+* Range updates for LazyAVLTree. An update names its parameter type as type
+* and provides two static functions:
+*
+*   apply(value, op)         changes one value in place
+*   compose(first, second)   a single op equivalent to first then second
+*/
+template <typename T>
+struct RangeAdd {
+    typedef T type;
+    static void apply(T& value, const T& delta) { value += delta; }
+    static T compose(const T& first, const T& second) { return first + second; }
+};
+
+template <typename T>
+struct RangeAssign {
+    typedef T type;
+    static void apply(T& value, const T& assigned) { value = assigned; }
+    static T compose(const T&, const T& second) { return second; }
+};
+
+/**
+* An AVL node with a pending update for its descendants. The node's own value
+* is always current with respect to its tag; the tag still has to reach its
+* children.
+*/
+template <typename Key, typename Value, typename Update>
+class LazyNode : public AVLNode<Key, Value>
+{
+public:
+    LazyNode(const Key& key, const Value& value, AVLNode<Key, Value>* parent);
+    virtual ~LazyNode();
+
+    bool hasPending() const;
+    const typename Update::type& getPending() const;
+    // Queues op after any update already pending.
+    void addPending(const typename Update::type& op);
+    void clearPending();
+
+protected:
+    typename Update::type pending_;
+    bool hasPending_;
+};
+
+/*
+  -------------------------------------------------
+  Begin implementations for the LazyNode class.
+  -------------------------------------------------
+*/
+
+template<class Key, class Value, class Update>
+LazyNode<Key, Value, Update>::LazyNode(const Key& key, const Value& value, AVLNode<Key, Value>* parent) :
+    AVLNode<Key, Value>(key, value, parent), pending_(), hasPending_(false)
+{
+
+}
+
+template<class Key, class Value, class Update>
+LazyNode<Key, Value, Update>::~LazyNode()
+{
+
+}
+
+template<class Key, class Value, class Update>
+bool LazyNode<Key, Value, Update>::hasPending() const
+{
+    return hasPending_;
+}
+
+template<class Key, class Value, class Update>
+const typename Update::type& LazyNode<Key, Value, Update>::getPending() const
+{
+    return pending_;
+}
+
+template<class Key, class Value, class Update>
+void LazyNode<Key, Value, Update>::addPending(const typename Update::type& op)
+{
+    pending_ = hasPending_ ? Update::compose(pending_, op) : op;
+    hasPending_ = true;
+}
+
+template<class Key, class Value, class Update>
+void LazyNode<Key, Value, Update>::clearPending()
+{
+    hasPending_ = false;
+}
+
+/*
+  -----------------------------------------------
+  End implementations for the LazyNode class.
+  -----------------------------------------------
+*/
+
+/**
+* An AVLTree that can update every value in a key range in O(log n). The
+* update is applied to the O(log n) nodes on the range's boundary paths and
+* left as a pending tag on the maximal subtrees in between; tags move down
+* one level whenever a search, insert, remove or rotation passes through
+* their node.
+*
+* find, operator[], min(), max() and begin() see every update. begin()
+* flushes through a virtual hook, so whole-tree walks that only hold a
+* BinarySearchTree& or AVLTree& (partition, parallelReduce, MappedTree::save,
+* FrozenIndex) see them too. The other lookups are not virtual: called
+* through a base-class reference they skip the pending tags, so call flush()
+* before handing the tree to such code. An iterator returned by find is
+* exact for its own item, but to walk onwards from it after an applyRange,
+* call flush() (or start from begin()) first.
+*
+* The const lookups push tags down as they pass, so they write to nodes and
+* must not run concurrently with each other or with anything else. Once
+* flush() has run, no tags are left until the next applyRange, and const
+* lookups only read.
+*/
+template <typename Key, typename Value, typename Update>
+class LazyAVLTree : public AVLTree<Key, Value>
+{
+public:
+    typedef typename BinarySearchTree<Key, Value>::iterator iterator;
+
+    LazyAVLTree();
+    virtual ~LazyAVLTree();
+
+    virtual std::pair<iterator, bool> tryInsert(const std::pair<const Key, Value>& new_item);
+    virtual void remove(const Key& key);
+
+    // Applies op to the value of every item with lo <= key <= hi.
+    void applyRange(const Key& lo, const Key& hi, const typename Update::type& op);
+    // Pushes every pending update all the way down.
+    void flush() const;
+
+    // The ends push the tags above them first, like find.
+    iterator min() const;
+    iterator max() const;
+    void popMin();
+    void popMax();
+    iterator find(const Key& key) const;
+    // Tags above the finger may still be pending, so these push the path from
+    // the root first; they are correct but no faster than find.
+    iterator find(const Key& key, const iterator& hint) const;
+    iterator findNear(const Key& key) const;
+    Value& operator[](const Key& key);
+    Value const & operator[](const Key& key) const;
+
+protected:
+    typedef LazyNode<Key, Value, Update> LNode;
+
+    virtual AVLNode<Key, Value>* createNode(const Key& key, const Value& value, AVLNode<Key, Value>* parent);
+    virtual void rotateRight(AVLNode<Key, Value>* node);
+    virtual void rotateLeft(AVLNode<Key, Value>* node);
+    virtual void extractNode(AVLNode<Key, Value>* n);
+    virtual bool insertNode(AVLNode<Key, Value>* n);
+    virtual void prepareScan() const;
+
+    static void push(Node<Key, Value>* n);
+    static void tag(Node<Key, Value>* n, const typename Update::type& op);
+    void pushPath(const Key& key) const;
+    static void flushHelper(Node<Key, Value>* n);
+    static void applyHelper(Node<Key, Value>* n, const Key& lo, const Key& hi, const typename Update::type& op,
+        bool coverLo, bool coverHi);
+
+    // true once a tag may be left anywhere below the search paths
+    mutable bool dirty_;
+};
+
+/*
+  -------------------------------------------------
+  Begin implementations for the LazyAVLTree class.
+  -------------------------------------------------
+*/
+
+template<class Key, class Value, class Update>
+LazyAVLTree<Key, Value, Update>::LazyAVLTree() :
+    dirty_(false)
+{
+
+}
+
+template<class Key, class Value, class Update>
+LazyAVLTree<Key, Value, Update>::~LazyAVLTree()
+{
+
+}
+
+template<class Key, class Value, class Update>
+AVLNode<Key, Value>* LazyAVLTree<Key, Value, Update>::createNode(const Key& key, const Value& value, AVLNode<Key, Value>* parent)
+{
+    return new LNode(key, value, parent);
+}
+
+/**
+* Applies op to n's value and queues it for n's descendants.
+*/
+template<class Key, class Value, class Update>
+void LazyAVLTree<Key, Value, Update>::tag(Node<Key, Value>* n, const typename Update::type& op)
+{
+    Update::apply(n->getValue(), op);
+    static_cast<LNode*>(n)->addPending(op);
+}
+
+/**
+* Moves n's pending update one level down, to its children.
+*/
+template<class Key, class Value, class Update>
+void LazyAVLTree<Key, Value, Update>::push(Node<Key, Value>* n)
+{
+    LNode* node = static_cast<LNode*>(n);
+    if (!node->hasPending()) return;
+    if (n->getLeft() != NULL) tag(n->getLeft(), node->getPending());
+    if (n->getRight() != NULL) tag(n->getRight(), node->getPending());
+    node->clearPending();
+}
+
+/**
+* Pushes every tag on the search path for key, so the values on that path
+* are current and nothing pending sits above the spot where key belongs.
+*/
+template<class Key, class Value, class Update>
+void LazyAVLTree<Key, Value, Update>::pushPath(const Key& key) const
+{
+    Node<Key, Value>* temp = this->root_;
+    while (temp != NULL) {
+        push(temp);
+        if (key < temp->getKey()) temp = temp->getLeft();
+        else if (temp->getKey() < key) temp = temp->getRight();
+        else return;
+    }
+}
+
+template<class Key, class Value, class Update>
+void LazyAVLTree<Key, Value, Update>::flushHelper(Node<Key, Value>* n)
+{
+    if (n == NULL) return;
+    push(n);
+    flushHelper(n->getLeft());
+    flushHelper(n->getRight());
+}
+
+template<class Key, class Value, class Update>
+void LazyAVLTree<Key, Value, Update>::flush() const
+{
+    if (!dirty_) return;
+    flushHelper(this->root_);
+    dirty_ = false;
+}
+
+/**
+* insert comes here too, so an overwritten value is current before it is
+* replaced and a new leaf joins below no tags.
+*/
+template<class Key, class Value, class Update>
+std::pair<typename LazyAVLTree<Key, Value, Update>::iterator, bool> LazyAVLTree<Key, Value, Update>::tryInsert(
+    const std::pair<const Key, Value>& new_item)
+{
+    pushPath(new_item.first);
+    return AVLTree<Key, Value>::tryInsert(new_item);
+}
+
+/*
+ * Besides the path to key, the path on to the predecessor that may be
+ * swapped into its place has to be clean.
+ */
+template<class Key, class Value, class Update>
+void LazyAVLTree<Key, Value, Update>::remove(const Key& key)
+{
+    pushPath(key);
+    Node<Key, Value>* n = this->internalFind(key);
+    if (n != NULL && n->getLeft() != NULL && n->getRight() != NULL) {
+        Node<Key, Value>* temp = n->getLeft();
+        while (temp != NULL) {
+            push(temp);
+            temp = temp->getRight();
+        }
+    }
+    AVLTree<Key, Value>::remove(key);
+}
+
+/**
+* Node handles need the same clean paths as remove and insert: a node leaves
+* with its value current and no tag of its own, and joins below no tags.
+*/
+template<class Key, class Value, class Update>
+void LazyAVLTree<Key, Value, Update>::extractNode(AVLNode<Key, Value>* n)
+{
+    pushPath(n->getKey());
+    if (n->getLeft() != NULL && n->getRight() != NULL) {
+        Node<Key, Value>* temp = n->getLeft();
+        while (temp != NULL) {
+            push(temp);
+            temp = temp->getRight();
+        }
+    }
+    AVLTree<Key, Value>::extractNode(n);
+}
+
+template<class Key, class Value, class Update>
+bool LazyAVLTree<Key, Value, Update>::insertNode(AVLNode<Key, Value>* n)
+{
+    pushPath(n->getKey());
+    return AVLTree<Key, Value>::insertNode(n);
+}
+
+/**
+* A rotation changes which subtrees node and its child cover, so both hand
+* their tags down before the links move.
+*/
+template<class Key, class Value, class Update>
+void LazyAVLTree<Key, Value, Update>::rotateRight(AVLNode<Key, Value>* node)
+{
+    push(node);
+    push(node->getLeft());
+    AVLTree<Key, Value>::rotateRight(node);
+}
+
+template<class Key, class Value, class Update>
+void LazyAVLTree<Key, Value, Update>::rotateLeft(AVLNode<Key, Value>* node)
+{
+    push(node);
+    push(node->getRight());
+    AVLTree<Key, Value>::rotateLeft(node);
+}
+
+/**
+* coverLo/coverHi record that every key below n is already known to be
+* >= lo / <= hi. Once both hold, the whole subtree is in range and takes a
+* tag; otherwise only one child can straddle each bound, so the walk follows
+* at most two paths.
+*/
+template<class Key, class Value, class Update>
+void LazyAVLTree<Key, Value, Update>::applyHelper(Node<Key, Value>* n, const Key& lo, const Key& hi,
+    const typename Update::type& op, bool coverLo, bool coverHi)
+{
+    if (n == NULL) return;
+    if (coverLo && coverHi) {
+        tag(n, op);
+        return;
+    }
+    //older updates must reach the children before op does
+    push(n);
+    bool aboveLo = !(n->getKey() < lo);
+    bool belowHi = !(hi < n->getKey());
+    if (aboveLo && belowHi) Update::apply(n->getValue(), op);
+    if (aboveLo) applyHelper(n->getLeft(), lo, hi, op, coverLo, coverHi || belowHi);
+    if (belowHi) applyHelper(n->getRight(), lo, hi, op, coverLo || aboveLo, coverHi);
+}
+
+template<class Key, class Value, class Update>
+void LazyAVLTree<Key, Value, Update>::applyRange(const Key& lo, const Key& hi, const typename Update::type& op)
+{
+    if (hi < lo) return;
+    applyHelper(this->root_, lo, hi, op, false, false);
+    dirty_ = true;
+}
+
+/**
+* A walk from begin() reads values without going through push, so every tag
+* goes down first.
+*/
+template<class Key, class Value, class Update>
+void LazyAVLTree<Key, Value, Update>::prepareScan() const
+{
+    flush();
+}
+
+template<class Key, class Value, class Update>
+typename LazyAVLTree<Key, Value, Update>::iterator LazyAVLTree<Key, Value, Update>::min() const
+{
+    if (this->empty()) return this->end();
+    pushPath(this->leftmost_->getKey());
+    return BinarySearchTree<Key, Value>::min();
+}
+
+template<class Key, class Value, class Update>
+typename LazyAVLTree<Key, Value, Update>::iterator LazyAVLTree<Key, Value, Update>::max() const
+{
+    if (this->empty()) return this->end();
+    pushPath(this->rightmost_->getKey());
+    return BinarySearchTree<Key, Value>::max();
+}
+
+/*
+ * The end node has at most one child, so it is never swapped and only the
+ * path down to it needs to be clean.
+ */
+template<class Key, class Value, class Update>
+void LazyAVLTree<Key, Value, Update>::popMin()
+{
+    if (this->empty()) return;
+    pushPath(this->leftmost_->getKey());
+    AVLTree<Key, Value>::popMin();
+}
+
+template<class Key, class Value, class Update>
+void LazyAVLTree<Key, Value, Update>::popMax()
+{
+    if (this->empty()) return;
+    pushPath(this->rightmost_->getKey());
+    AVLTree<Key, Value>::popMax();
+}
+
+template<class Key, class Value, class Update>
+typename LazyAVLTree<Key, Value, Update>::iterator LazyAVLTree<Key, Value, Update>::find(const Key& key) const
+{
+    pushPath(key);
+    return BinarySearchTree<Key, Value>::find(key);
+}
+
+template<class Key, class Value, class Update>
+typename LazyAVLTree<Key, Value, Update>::iterator LazyAVLTree<Key, Value, Update>::find(const Key& key,
+    const iterator& hint) const
+{
+    pushPath(key);
+    return BinarySearchTree<Key, Value>::find(key, hint);
+}
+
+template<class Key, class Value, class Update>
+typename LazyAVLTree<Key, Value, Update>::iterator LazyAVLTree<Key, Value, Update>::findNear(const Key& key) const
+{
+    pushPath(key);
+    return BinarySearchTree<Key, Value>::findNear(key);
+}
+
+template<class Key, class Value, class Update>
+Value& LazyAVLTree<Key, Value, Update>::operator[](const Key& key)
+{
+    pushPath(key);
+    return BinarySearchTree<Key, Value>::operator[](key);
+}
+
+template<class Key, class Value, class Update>
+Value const & LazyAVLTree<Key, Value, Update>::operator[](const Key& key) const
+{
+    pushPath(key);
+    return BinarySearchTree<Key, Value>::operator[](key);
+}
+
+/*
+  -----------------------------------------------
+  End implementations for the LazyAVLTree class.
+  -----------------------------------------------
+*/
+
+#endif
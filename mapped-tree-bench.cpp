@@ -0,0 +1,58 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include "avlbst.h"
+#include "mapped-tree.h"
+
+using namespace std;
+
+double msSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// Compares a restart that rebuilds the index with n inserts against one that
+// maps a saved copy, then checks both answer lookups.
+int main(int argc, char* argv[])
+{
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 2000000;
+    string path = argc > 2 ? argv[2] : "/tmp/mapped-tree-bench." + to_string(getpid());
+
+    mt19937_64 rng(21);
+    vector<long long> keys(n);
+    for (size_t i = 0; i < n; ++i) keys[i] = (long long)(rng() >> 1);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    AVLTree<long long,long long> tree;
+    for (size_t i = 0; i < n; ++i) tree.insert(make_pair(keys[i], (long long)i));
+    double rebuildMs = msSince(start);
+
+    start = chrono::steady_clock::now();
+    MappedTree<long long,long long>::save(tree, path);
+    double saveMs = msSince(start);
+
+    start = chrono::steady_clock::now();
+    MappedTree<long long,long long> mapped(path);
+    double openMs = msSince(start);
+
+    start = chrono::steady_clock::now();
+    long long sink = 0;
+    for (size_t i = 0; i < n; i += 7) sink += mapped.find(keys[i])->second;
+    double findNs = msSince(start) * 1e6 / ((n + 6) / 7);
+
+    cout << n << " entries" << endl;
+    cout << fixed << setprecision(3);
+    cout << setw(26) << "rebuild by insert (ms)" << setw(14) << rebuildMs << endl;
+    cout << setw(26) << "save (ms)" << setw(14) << saveMs << endl;
+    cout << setw(26) << "openMapped (ms)" << setw(14) << openMs << endl;
+    cout << setw(26) << "mapped find (ns)" << setw(14) << findNs << endl;
+    if (sink == 42) cout << "";
+    remove(path.c_str());
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include <iostream>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstddef>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "avlbst.h"
+#include "mapped-tree.h"
+#include "test-util.h"
+
+using namespace std;
+
+int main()
+{
+    string path = "/tmp/mapped-tree-test." + to_string(getpid());
+
+    AVLTree<int,double> tree;
+    for (int i = 0; i < 1000; ++i) tree.insert(make_pair(i * 2, i * 0.5));
+    MappedTree<int,double>::save(tree, path);
+
+    MappedTree<int,double> mapped(path);
+    check(mapped.size() == 1000, "record count survives the round trip");
+
+    bool found = true;
+    for (int i = 0; i < 2000; ++i) {
+        MappedTree<int,double>::iterator it = mapped.find(i);
+        if (i % 2 == 0) found = found && it != mapped.end() && it->second == (i / 2) * 0.5;
+        else found = found && it == mapped.end();
+    }
+    check(found, "find answers from the mapping");
+
+    bool ordered = true;
+    int expect = 0;
+    for (MappedTree<int,double>::iterator it = mapped.begin(); it != mapped.end(); ++it, expect += 2) {
+        ordered = ordered && it->first == expect;
+    }
+    check(ordered && expect == 2000, "iteration yields keys in order");
+
+    pair<MappedTree<int,double>::iterator, MappedTree<int,double>::iterator> r = mapped.range(11, 20);
+    int inRange = 0;
+    for (MappedTree<int,double>::iterator it = r.first; it != r.second; ++it) ++inRange;
+    check(r.first->first == 12 && inRange == 5, "range covers [11, 20]");
+    check(mapped[1998] == 999 * 0.5, "operator[] reads a value");
+
+    // a second process maps the same file and sees the same data
+    pid_t child = fork();
+    if (child == 0) {
+        MappedTree<int,double> other(path);
+        _exit(other.size() == 1000 && other.find(500) != other.end() ? 0 : 1);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    check(WIFEXITED(status) && WEXITSTATUS(status) == 0, "another process opens the same file");
+
+    bool threw = false;
+    try {
+        MappedTree<long long,double> wrong(path);
+    }
+    catch (const runtime_error&) {
+        threw = true;
+    }
+    check(threw, "opening with mismatched types is rejected");
+
+    // saving over a mapped file replaces it; the old mapping keeps its data
+    AVLTree<int,double> emptyTree;
+    MappedTree<int,double>::save(emptyTree, path);
+    bool oldIntact = mapped.size() == 1000;
+    for (int i = 0; i < 2000; i += 2) oldIntact = oldIntact && mapped.find(i) != mapped.end();
+    check(oldIntact, "a save leaves an existing mapping readable");
+    check(access((path + ".tmp").c_str(), F_OK) != 0, "save leaves no temporary file behind");
+    mapped.openMapped(path);
+    check(mapped.empty() && mapped.begin() == mapped.end() && mapped.find(3) == mapped.end(), "empty tree round trip");
+
+    // a corrupt left link of the root record, out of range and then a cycle,
+    // is reported rather than followed
+    MappedTree<int,double>::save(tree, path);
+    typedef MappedTree<int,double>::Record Record;
+    uint64_t badLinks[] = { 5000, 500 };
+    bool rejected = true;
+    for (int i = 0; i < 2; ++i) {
+        FILE* f = fopen(path.c_str(), "r+b");
+        fseek(f, MappedTree<int,double>::RecordsOffset + 500 * sizeof(Record) + offsetof(Record, left), SEEK_SET);
+        fwrite(&badLinks[i], sizeof(uint64_t), 1, f);
+        fclose(f);
+        MappedTree<int,double> corrupt(path);
+        bool caught = false;
+        try {
+            corrupt.find(0);
+        }
+        catch (const runtime_error&) {
+            caught = true;
+        }
+        rejected = rejected && caught && corrupt.find(1998) != corrupt.end();
+    }
+    check(rejected, "corrupt links are rejected");
+
+    remove(path.c_str());
+    return failures == 0 ? 0 : 1;
+}
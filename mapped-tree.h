@@ -0,0 +1,489 @@
+#ifndef MAPPED_TREE_H
+#define MAPPED_TREE_H
+
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <stdexcept>
+#include <type_traits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "bst.h"
+
+/**
+* A read-only search tree that lives in a file and is queried in place through
+* mmap. Nothing is deserialized on open, so opening a large index costs one
+* mmap call, and every process that maps the same file shares its pages
+* through the OS page cache.
+*
+* File layout: a fixed 64-byte header followed by one Record per item, in key
+* order. Records link to their children by record index rather than by
+* pointer, so the file is valid at any mapping address. The links form a
+* perfectly balanced tree over the sorted records (the root is the middle
+* record), which makes iteration and range scans a sequential walk.
+*
+* Key and Value must be trivially copyable; the file stores their bytes as-is,
+* so it is only portable between builds with the same type layout.
+*/
+template <typename Key, typename Value>
+class MappedTree
+{
+public:
+    static const uint64_t Nil = ~(uint64_t)0;
+
+    struct Record {
+        Key first;
+        Value second;
+        uint64_t left;      // record index of the left child, or Nil
+        uint64_t right;     // record index of the right child, or Nil
+    };
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t keySize;
+        uint32_t valueSize;
+        uint32_t recordSize;
+        uint64_t count;
+        uint64_t root;
+    };
+
+    static const size_t RecordsOffset = 64;
+
+    /**
+    * An iterator over the records in key order.
+    */
+    class iterator
+    {
+    public:
+        iterator();
+
+        const Record& operator*() const;
+        const Record* operator->() const;
+
+        bool operator==(const iterator& rhs) const;
+        bool operator!=(const iterator& rhs) const;
+
+        iterator& operator++();
+
+    protected:
+        friend class MappedTree<Key, Value>;
+        explicit iterator(const Record* ptr);
+        const Record* current_;
+    };
+
+    MappedTree();
+    explicit MappedTree(const std::string& path);
+    ~MappedTree();
+
+    // Writes tree to path in a single sequential pass. The file is written
+    // beside path as path + ".tmp", synced and renamed over path, so readers
+    // that mapped the old file keep it intact and a crash leaves either the
+    // old file or the new one. Throws std::runtime_error on I/O failure.
+    static void save(const BinarySearchTree<Key, Value>& tree, const std::string& path);
+    // Makes a rename inside dir durable.
+    static void syncDirectory(const std::string& dir);
+
+    // Maps the file at path, replacing any mapping already open. Throws
+    // std::runtime_error if the file cannot be mapped or was written for other types.
+    void openMapped(const std::string& path);
+    void close();
+
+    bool empty() const;
+    size_t size() const;
+
+    iterator begin() const;
+    iterator end() const;
+    iterator find(const Key& key) const;
+    // First record whose key is not less than key.
+    iterator lowerBound(const Key& key) const;
+    // First record whose key is greater than key.
+    iterator upperBound(const Key& key) const;
+    // Records with lo <= key <= hi, as a [first, last) pair.
+    std::pair<iterator, iterator> range(const Key& lo, const Key& hi) const;
+    Value const & operator[](const Key& key) const;
+
+protected:
+    static void writeFile(const BinarySearchTree<Key, Value>& tree, const std::string& path);
+    static void writeRange(FILE* out, typename BinarySearchTree<Key, Value>::iterator& it, uint64_t lo, uint64_t hi);
+    static uint64_t middle(uint64_t lo, uint64_t hi);
+    static void fillHeader(Header& header, uint64_t count);
+    // The record a stored link at the given depth points to. Throws the same
+    // std::runtime_error as openMapped for a link outside the records, or one
+    // deeper than a balanced tree can be, so a corrupt file cannot send a
+    // lookup out of the mapping or around a cycle.
+    const Record& follow(uint64_t index, size_t depth) const;
+
+    void* base_;
+    size_t length_;
+    const Header* header_;
+    const Record* records_;
+    std::string path_;
+
+private:
+    MappedTree(const MappedTree&);
+    MappedTree& operator=(const MappedTree&);
+
+    static_assert(std::is_trivially_copyable<Key>::value, "MappedTree keys must be trivially copyable");
+    static_assert(std::is_trivially_copyable<Value>::value, "MappedTree values must be trivially copyable");
+};
+
+/*
+  ------------------------------------------------------
+  Begin implementations for the MappedTree::iterator class.
+  ------------------------------------------------------
+*/
+
+template<class Key, class Value>
+MappedTree<Key, Value>::iterator::iterator() :
+    current_(NULL)
+{
+
+}
+
+template<class Key, class Value>
+MappedTree<Key, Value>::iterator::iterator(const Record* ptr) :
+    current_(ptr)
+{
+
+}
+
+template<class Key, class Value>
+const typename MappedTree<Key, Value>::Record& MappedTree<Key, Value>::iterator::operator*() const
+{
+    return *current_;
+}
+
+template<class Key, class Value>
+const typename MappedTree<Key, Value>::Record* MappedTree<Key, Value>::iterator::operator->() const
+{
+    return current_;
+}
+
+template<class Key, class Value>
+bool MappedTree<Key, Value>::iterator::operator==(const iterator& rhs) const
+{
+    return current_ == rhs.current_;
+}
+
+template<class Key, class Value>
+bool MappedTree<Key, Value>::iterator::operator!=(const iterator& rhs) const
+{
+    return current_ != rhs.current_;
+}
+
+/**
+* Records are stored in key order, so the successor is the next record.
+*/
+template<class Key, class Value>
+typename MappedTree<Key, Value>::iterator& MappedTree<Key, Value>::iterator::operator++()
+{
+    ++current_;
+    return *this;
+}
+
+/*
+  ---------------------------------------------
+  Begin implementations for the MappedTree class.
+  ---------------------------------------------
+*/
+
+template<class Key, class Value>
+MappedTree<Key, Value>::MappedTree() :
+    base_(NULL), length_(0), header_(NULL), records_(NULL)
+{
+
+}
+
+template<class Key, class Value>
+MappedTree<Key, Value>::MappedTree(const std::string& path) :
+    base_(NULL), length_(0), header_(NULL), records_(NULL)
+{
+    openMapped(path);
+}
+
+template<class Key, class Value>
+MappedTree<Key, Value>::~MappedTree()
+{
+    close();
+}
+
+/**
+* Index of the root of the balanced subtree over records [lo, hi).
+*/
+template<class Key, class Value>
+uint64_t MappedTree<Key, Value>::middle(uint64_t lo, uint64_t hi)
+{
+    return lo < hi ? lo + (hi - lo) / 2 : Nil;
+}
+
+template<class Key, class Value>
+void MappedTree<Key, Value>::fillHeader(Header& header, uint64_t count)
+{
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, "AVLMAP1", 8);
+    header.version = 1;
+    header.keySize = sizeof(Key);
+    header.valueSize = sizeof(Value);
+    header.recordSize = sizeof(Record);
+    header.count = count;
+    header.root = middle(0, count);
+}
+
+/**
+* Emits records [lo, hi) by walking the implicit balanced tree in order, which
+* is the same order the source iterator yields items in. Children's indices
+* follow from the ranges alone, so no record is ever revisited.
+*/
+template<class Key, class Value>
+void MappedTree<Key, Value>::writeRange(FILE* out, typename BinarySearchTree<Key, Value>::iterator& it, uint64_t lo, uint64_t hi)
+{
+    if (lo >= hi) return;
+    uint64_t mid = middle(lo, hi);
+    writeRange(out, it, lo, mid);
+
+    Record record;
+    std::memset(&record, 0, sizeof(record));
+    record.first = it->first;
+    record.second = it->second;
+    record.left = middle(lo, mid);
+    record.right = middle(mid + 1, hi);
+    if (std::fwrite(&record, sizeof(record), 1, out) != 1) {
+        throw std::runtime_error("MappedTree: write failed");
+    }
+    ++it;
+
+    writeRange(out, it, mid + 1, hi);
+}
+
+/**
+* Truncating path in place would pull the pages out from under a reader that
+* has it mapped (SIGBUS), and a crash mid-write would leave no index at all.
+*/
+template<class Key, class Value>
+void MappedTree<Key, Value>::save(const BinarySearchTree<Key, Value>& tree, const std::string& path)
+{
+    std::string tmp = path + ".tmp";
+    try {
+        writeFile(tree, tmp);
+    }
+    catch (...) {
+        unlink(tmp.c_str());
+        throw;
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        unlink(tmp.c_str());
+        throw std::runtime_error("MappedTree: cannot rename " + tmp);
+    }
+    size_t slash = path.rfind('/');
+    syncDirectory(slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash));
+}
+
+template<class Key, class Value>
+void MappedTree<Key, Value>::syncDirectory(const std::string& dir)
+{
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) throw std::runtime_error("MappedTree: cannot open " + dir);
+    bool ok = fsync(fd) == 0;
+    ::close(fd);
+    if (!ok) throw std::runtime_error("MappedTree: cannot sync " + dir);
+}
+
+template<class Key, class Value>
+void MappedTree<Key, Value>::writeFile(const BinarySearchTree<Key, Value>& tree, const std::string& path)
+{
+    uint64_t count = 0;
+    if (!tree.empty()) {
+        for (typename BinarySearchTree<Key, Value>::iterator it = tree.begin(); it != tree.end(); ++it) ++count;
+    }
+
+    FILE* out = std::fopen(path.c_str(), "wb");
+    if (out == NULL) throw std::runtime_error("MappedTree: cannot create " + path);
+
+    char head[RecordsOffset];
+    std::memset(head, 0, sizeof(head));
+    Header header;
+    fillHeader(header, count);
+    std::memcpy(head, &header, sizeof(header));
+
+    bool ok = std::fwrite(head, sizeof(head), 1, out) == 1;
+    if (ok && count > 0) {
+        typename BinarySearchTree<Key, Value>::iterator it = tree.begin();
+        try {
+            writeRange(out, it, 0, count);
+        }
+        catch (...) {
+            std::fclose(out);
+            throw;
+        }
+    }
+    ok = ok && std::fflush(out) == 0 && fsync(fileno(out)) == 0;
+    ok = (std::fclose(out) == 0) && ok;
+    if (!ok) throw std::runtime_error("MappedTree: write failed for " + path);
+}
+
+template<class Key, class Value>
+void MappedTree<Key, Value>::openMapped(const std::string& path)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("MappedTree: cannot open " + path);
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < RecordsOffset) {
+        ::close(fd);
+        throw std::runtime_error("MappedTree: " + path + " is too short");
+    }
+
+    void* base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) throw std::runtime_error("MappedTree: cannot map " + path);
+
+    const Header* header = static_cast<const Header*>(base);
+    Header expect;
+    fillHeader(expect, header->count);
+    bool valid = std::memcmp(header->magic, expect.magic, 8) == 0
+        && header->version == expect.version
+        && header->keySize == expect.keySize
+        && header->valueSize == expect.valueSize
+        && header->recordSize == expect.recordSize
+        && header->root == expect.root
+        && header->count <= ((size_t)st.st_size - RecordsOffset) / sizeof(Record);
+    if (!valid) {
+        munmap(base, st.st_size);
+        throw std::runtime_error("MappedTree: " + path + " is not a tree of this type");
+    }
+
+    base_ = base;
+    length_ = st.st_size;
+    header_ = header;
+    records_ = reinterpret_cast<const Record*>(static_cast<const char*>(base) + RecordsOffset);
+    path_ = path;
+}
+
+template<class Key, class Value>
+void MappedTree<Key, Value>::close()
+{
+    if (base_ != NULL) munmap(base_, length_);
+    base_ = NULL;
+    length_ = 0;
+    header_ = NULL;
+    records_ = NULL;
+    path_.clear();
+}
+
+template<class Key, class Value>
+bool MappedTree<Key, Value>::empty() const
+{
+    return header_ == NULL || header_->count == 0;
+}
+
+template<class Key, class Value>
+size_t MappedTree<Key, Value>::size() const
+{
+    return header_ == NULL ? 0 : header_->count;
+}
+
+template<class Key, class Value>
+typename MappedTree<Key, Value>::iterator MappedTree<Key, Value>::begin() const
+{
+    return empty() ? end() : iterator(records_);
+}
+
+template<class Key, class Value>
+typename MappedTree<Key, Value>::iterator MappedTree<Key, Value>::end() const
+{
+    return empty() ? iterator() : iterator(records_ + header_->count);
+}
+
+template<class Key, class Value>
+const typename MappedTree<Key, Value>::Record& MappedTree<Key, Value>::follow(uint64_t index, size_t depth) const
+{
+    if (index >= header_->count || depth >= 64) {
+        throw std::runtime_error("MappedTree: " + path_ + " is not a tree of this type");
+    }
+    return records_[index];
+}
+
+/**
+* Follows the stored links from the root record.
+*/
+template<class Key, class Value>
+typename MappedTree<Key, Value>::iterator MappedTree<Key, Value>::find(const Key& key) const
+{
+    uint64_t temp = header_ == NULL ? Nil : header_->root;
+    for (size_t depth = 0; temp != Nil; ++depth) {
+        const Record& r = follow(temp, depth);
+        if (key < r.first) temp = r.left;
+        else if (r.first < key) temp = r.right;
+        else return iterator(&r);
+    }
+    return end();
+}
+
+template<class Key, class Value>
+typename MappedTree<Key, Value>::iterator MappedTree<Key, Value>::lowerBound(const Key& key) const
+{
+    uint64_t temp = header_ == NULL ? Nil : header_->root;
+    const Record* best = end().current_;
+    for (size_t depth = 0; temp != Nil; ++depth) {
+        const Record& r = follow(temp, depth);
+        if (r.first < key) temp = r.right;
+        else {
+            best = &r;
+            temp = r.left;
+        }
+    }
+    return iterator(best);
+}
+
+template<class Key, class Value>
+typename MappedTree<Key, Value>::iterator MappedTree<Key, Value>::upperBound(const Key& key) const
+{
+    uint64_t temp = header_ == NULL ? Nil : header_->root;
+    const Record* best = end().current_;
+    for (size_t depth = 0; temp != Nil; ++depth) {
+        const Record& r = follow(temp, depth);
+        if (key < r.first) {
+            best = &r;
+            temp = r.left;
+        }
+        else temp = r.right;
+    }
+    return iterator(best);
+}
+
+template<class Key, class Value>
+std::pair<typename MappedTree<Key, Value>::iterator, typename MappedTree<Key, Value>::iterator>
+MappedTree<Key, Value>::range(const Key& lo, const Key& hi) const
+{
+    iterator first = lowerBound(lo);
+    iterator last = upperBound(hi);
+    if (hi < lo) last = first;
+    return std::make_pair(first, last);
+}
+
+/**
+ * @precondition The key exists in the map
+ * Returns the value associated with the key
+ */
+template<class Key, class Value>
+Value const & MappedTree<Key, Value>::operator[](const Key& key) const
+{
+    iterator it = find(key);
+    if (it == end()) throw std::out_of_range("Invalid key");
+    return it->second;
+}
+
+/*
+  -------------------------------------------
+  End implementations for the MappedTree class.
+  -------------------------------------------
+*/
+
+#endif
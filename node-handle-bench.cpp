@@ -0,0 +1,59 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <utility>
+#include "avlbst.h"
+
+using namespace std;
+
+double msSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// Moving n entries from one tree to another, as a shard rebalance would:
+// remove + insert (a delete and a new per entry), extract + insert of the
+// node handle, and one merge of the whole tree.
+int main(int argc, char* argv[])
+{
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+
+    mt19937_64 rng(41);
+    vector<long long> keys(n);
+    for (size_t i = 0; i < n; ++i) keys[i] = (long long)(rng() >> 1);
+
+    AVLTree<long long,long long> src;
+    AVLTree<long long,long long> dst;
+    for (size_t i = 0; i < n; ++i) src.insert(make_pair(keys[i], (long long)i));
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t i = 0; i < n; ++i) {
+        AVLTree<long long,long long>::iterator it = src.find(keys[i]);
+        if (it == src.end()) continue;
+        pair<long long,long long> item = *it;
+        src.remove(item.first);
+        dst.insert(item);
+    }
+    double copyMs = msSince(start);
+
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < n; ++i) {
+        AVLTree<long long,long long>::NodeHandle nh = dst.extract(keys[i]);
+        if (!nh.empty()) src.insert(std::move(nh));
+    }
+    double handleMs = msSince(start);
+
+    start = chrono::steady_clock::now();
+    dst.merge(src);
+    double mergeMs = msSince(start);
+
+    cout << n << " entries moved" << endl;
+    cout << fixed << setprecision(1);
+    cout << "remove + insert:           " << copyMs << " ms" << endl;
+    cout << "extract + insert(handle):  " << handleMs << " ms" << endl;
+    cout << "merge:                     " << mergeMs << " ms" << (src.empty() ? "" : " (source not empty)") << endl;
+    return 0;
+}
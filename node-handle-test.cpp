@@ -0,0 +1,140 @@
+#include <iostream>
+#include <map>
+#include <cstdlib>
+#include <utility>
+#include "avlbst.h"
+#include "aggregate-tree.h"
+#include "lazy-tree.h"
+#include "sharded-map.h"
+#include "test-util.h"
+
+using namespace std;
+
+// An AVLTree that counts node allocations, to show that moves make none.
+class CountingTree : public AVLTree<int,int>
+{
+public:
+    static int created;
+    static int destroyed;
+    virtual ~CountingTree() { clear(); }
+protected:
+    virtual AVLNode<int,int>* createNode(const int& key, const int& value, AVLNode<int,int>* parent)
+    {
+        ++created;
+        return AVLTree<int,int>::createNode(key, value, parent);
+    }
+    virtual void destroyNode(AVLNode<int,int>* node)
+    {
+        ++destroyed;
+        AVLTree<int,int>::destroyNode(node);
+    }
+};
+int CountingTree::created = 0;
+int CountingTree::destroyed = 0;
+
+template<class Tree>
+bool sameContents(const Tree& tree, const map<int,int>& ref)
+{
+    map<int,int>::const_iterator r = ref.begin();
+    for (typename Tree::iterator it = tree.begin(); it != tree.end(); ++it, ++r) {
+        if (r == ref.end() || it->first != r->first || it->second != r->second) return false;
+    }
+    return r == ref.end();
+}
+
+int main()
+{
+    CountingTree a;
+    CountingTree b;
+    for (int i = 0; i < 100; ++i) a.insert(make_pair(i, i * 10));
+    int created = CountingTree::created;
+
+    AVLTree<int,int>::NodeHandle nh = a.extract(42);
+    check(!nh.empty() && nh.key() == 42 && nh.value() == 420 && a.find(42) == a.end() && a.isBalanced(),
+        "extract(key) unlinks and rebalances");
+    check(a.extract(1000).empty() && a.extract(a.end()).empty(), "extracting nothing gives an empty handle");
+
+    nh.value() = 421;
+    AVLTree<int,int>::iterator it = b.insert(std::move(nh));
+    check(nh.empty() && it != b.end() && it->first == 42 && b[42] == 421, "insert(handle) relinks the node");
+
+    nh = a.extract(a.begin());
+    check(!nh.empty() && nh.key() == 0 && a.min()->first == 1, "extract(iterator)");
+    b.insert(make_pair(0, -1));
+    it = b.insert(std::move(nh));
+    check(!nh.empty() && it->second == -1, "insert(handle) of a present key keeps the handle");
+    int destroyed = CountingTree::destroyed;
+    nh = AVLTree<int,int>::NodeHandle();
+    check(CountingTree::destroyed == destroyed + 1, "a dropped handle gives its node back");
+    check(b.insert(AVLTree<int,int>::NodeHandle()) == b.end(), "inserting an empty handle");
+
+    // merge moves every key b lacks and leaves the conflicts behind
+    srand(41);
+    map<int,int> refA, refB;
+    CountingTree c, d;
+    for (int i = 0; i < 3000; ++i) {
+        int key = rand() % 5000;
+        c.insert(make_pair(key, i));
+        refA[key] = i;
+        key = rand() % 5000;
+        d.insert(make_pair(key, -i));
+        refB[key] = -i;
+    }
+    created = CountingTree::created;
+    c.merge(d);
+    map<int,int> left;
+    for (map<int,int>::iterator r = refB.begin(); r != refB.end(); ++r) {
+        if (!refA.insert(*r).second) left.insert(*r);
+    }
+    check(sameContents(c, refA) && sameContents(d, left) && c.isBalanced() && d.isBalanced(),
+        "merge matches std::map::merge");
+    check(CountingTree::created == created, "merge allocates nothing");
+
+    // a plain tree and a counting tree allocate differently, so nodes are copied
+    AVLTree<int,int> plain;
+    plain.insert(make_pair(5, 50));
+    created = CountingTree::created;
+    CountingTree e;
+    e.insert(plain.extract(5));
+    check(e[5] == 50 && plain.empty() && CountingTree::created == created + 1, "handles between unlike trees copy");
+
+    // pooled trees each own a pool, so their merges copy too
+    PooledAVLTree<int,int> p1, p2;
+    map<int,int> refP;
+    for (int i = 0; i < 1000; ++i) {
+        p1.insert(make_pair(i * 2, i));
+        p2.insert(make_pair(i * 3, i));
+        refP[i * 2] = i;
+    }
+    for (int i = 0; i < 1000; ++i) refP.insert(make_pair(i * 3, i));
+    p1.merge(p2);
+    check(sameContents(p1, refP) && p1.isBalanced(), "merging pooled trees");
+
+    // aggregates are rebuilt where a node leaves and where it lands
+    AggregateAVLTree<int,int,SumOf<int> > s1, s2;
+    for (int i = 1; i <= 100; ++i) s1.insert(make_pair(i, i));
+    for (int i = 1; i <= 100; i += 2) s2.insert(s1.extract(i));
+    check(s1.total() == 2550 && s2.total() == 2500 && s2.aggregate(1, 9) == 25, "aggregates follow moved nodes");
+
+    // lazy tags are pushed before a node leaves or lands
+    LazyAVLTree<int,int,RangeAdd<int> > l1, l2;
+    for (int i = 0; i < 100; ++i) {
+        l1.insert(make_pair(i * 2, 0));
+        l2.insert(make_pair(i * 2 + 1, 0));
+    }
+    l1.applyRange(0, 200, 7);
+    l2.applyRange(0, 200, 100);
+    l2.merge(l1);
+    bool lazyOk = l1.empty() && l2.isBalanced();
+    for (int i = 0; i < 200; ++i) lazyOk = lazyOk && l2[i] == (i % 2 == 0 ? 7 : 100);
+    check(lazyOk, "lazy trees merge with pending updates");
+
+    // tryInsert reports whether the key was new and never overwrites
+    AVLTree<int,int> tried;
+    pair<AVLTree<int,int>::iterator, bool> first = tried.tryInsert(make_pair(3, 30));
+    pair<AVLTree<int,int>::iterator, bool> again = tried.tryInsert(make_pair(3, 31));
+    check(first.second && !again.second && first.first == again.first && tried[3] == 30,
+        "tryInsert inserts once and keeps the stored value");
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,77 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+#include "parallel-tree.h"
+#include "avlbst.h"
+
+using namespace std;
+
+double msSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// A read-only pass with a little arithmetic per item, as an analytics
+// query would do; pure pointer chasing is bound by memory bandwidth instead.
+double score(const pair<const int, double>& item)
+{
+    return sqrt(item.second * item.second + item.first) * 0.5;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 2000000;
+    unsigned maxThreads = argc > 2 ? strtoul(argv[2], NULL, 10) : 2 * thread::hardware_concurrency();
+    if (maxThreads == 0) maxThreads = 1;
+
+    mt19937 rng(42);
+    uniform_real_distribution<double> dist(0, 1000);
+    AVLTree<int, double> tree;
+    for (size_t i = 0; i < n; ++i) tree.insert(make_pair((int)(rng() >> 1), dist(rng)));
+    cout << "items: " << n << "  hardware threads: " << thread::hardware_concurrency() << endl;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    double expect = 0;
+    for (AVLTree<int, double>::iterator it = tree.begin(); it != tree.end(); ++it) expect += score(*it);
+    double sequentialMs = msSince(start);
+    cout << "sequential iterator pass: " << fixed << setprecision(1) << sequentialMs << " ms" << endl;
+
+    start = chrono::steady_clock::now();
+    vector<pair<AVLTree<int, double>::iterator, AVLTree<int, double>::iterator> > ranges = tree.partition(256);
+    cout << "partition(256): " << setprecision(3) << msSince(start) << " ms, " << ranges.size() << " ranges" << endl;
+
+    // every reduce runs before any for_each, which rewrites the values
+    vector<unsigned> counts;
+    vector<double> reduceMs;
+    bool matches = true;
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        start = chrono::steady_clock::now();
+        double total = parallelReduce(tree, 0.0, [](double acc, pair<const int, double>& item) {
+            return acc + score(item);
+        }, [](double a, double b) { return a + b; }, threads);
+        counts.push_back(threads);
+        reduceMs.push_back(msSince(start));
+        matches = matches && fabs(total - expect) <= 1e-6 * fabs(expect);
+    }
+    if (!matches) cout << "parallelReduce disagrees with the sequential pass" << endl;
+
+    cout << setw(8) << "threads" << setw(14) << "reduce ms" << setw(10) << "speedup"
+         << setw(16) << "for_each ms" << setw(10) << "speedup" << endl;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        start = chrono::steady_clock::now();
+        parallelForEach(tree, [](pair<const int, double>& item) {
+            item.second = score(item);
+        }, counts[i]);
+        double forEachMs = msSince(start);
+        cout << setw(8) << counts[i] << setw(14) << setprecision(1) << reduceMs[i]
+             << setw(10) << setprecision(2) << sequentialMs / reduceMs[i]
+             << setw(16) << setprecision(1) << forEachMs
+             << setw(10) << setprecision(2) << sequentialMs / forEachMs << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,182 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdlib>
+#include <stdexcept>
+#include "parallel-tree.h"
+#include "avlbst.h"
+#include "wavlbst.h"
+#include "aggregate-tree.h"
+#include "lazy-tree.h"
+#include "test-util.h"
+
+using namespace std;
+
+// The ranges are non-empty, follow each other with no gap and cover the
+// tree from begin() to end(). Their sizes go to sizes.
+template<class Tree>
+bool coversInOrder(const Tree& tree, const vector<pair<typename Tree::iterator, typename Tree::iterator> >& ranges,
+    vector<size_t>& sizes)
+{
+    sizes.clear();
+    typename Tree::iterator expect = tree.begin();
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        if (ranges[i].first != expect || ranges[i].first == ranges[i].second) return false;
+        size_t n = 0;
+        typename Tree::iterator it = ranges[i].first;
+        for (; it != ranges[i].second; ++it) {
+            if (it == tree.end()) return false;
+            ++n;
+        }
+        sizes.push_back(n);
+        expect = ranges[i].second;
+    }
+    return expect == tree.end();
+}
+
+size_t largest(const vector<size_t>& sizes)
+{
+    size_t m = 0;
+    for (size_t i = 0; i < sizes.size(); ++i) m = max(m, sizes[i]);
+    return m;
+}
+
+size_t smallest(const vector<size_t>& sizes)
+{
+    size_t m = sizes.empty() ? 0 : sizes[0];
+    for (size_t i = 0; i < sizes.size(); ++i) m = min(m, sizes[i]);
+    return m;
+}
+
+int main()
+{
+    vector<size_t> sizes;
+
+    AVLTree<int, int> empty;
+    check(empty.partition(4).empty(), "an empty tree has no ranges");
+    check(parallelReduce(empty, 7, [](int acc, pair<const int, int>&) { return acc + 1; },
+        [](int a, int b) { return a + b; }, 4) == 7, "reduce over an empty tree returns init");
+
+    AVLTree<int, int> avl;
+    for (int i = 0; i < 10000; ++i) avl.insert(make_pair((i * 7919) % 10000, i));
+    bool covered = true, counted = true, balanced = true;
+    size_t ks[] = { 0, 1, 2, 3, 7, 32, 256, 20000 };
+    for (size_t i = 0; i < sizeof(ks) / sizeof(ks[0]); ++i) {
+        size_t k = ks[i];
+        vector<pair<AVLTree<int, int>::iterator, AVLTree<int, int>::iterator> > ranges = avl.partition(k);
+        covered = covered && coversInOrder(avl, ranges, sizes);
+        counted = counted && ranges.size() == min<size_t>(max<size_t>(k, 1), 10000);
+        if (k >= 2 && k <= 256) balanced = balanced && largest(sizes) <= 3 * 10000 / (2 * k) + 1;
+    }
+    check(covered, "AVL ranges are disjoint and cover the tree in order");
+    check(counted, "AVL gives min(k, size) ranges");
+    check(balanced, "AVL ranges are within half again of the even share");
+
+    WAVLTree<int, int> wavl;
+    for (int i = 0; i < 4000; ++i) wavl.insert(make_pair(rand(), i));
+    for (int i = 0; i < 2000; ++i) wavl.remove(rand());
+    vector<pair<WAVLTree<int, int>::iterator, WAVLTree<int, int>::iterator> > wavlRanges = wavl.partition(16);
+    check(coversInOrder(wavl, wavlRanges, sizes) && wavlRanges.size() == 16, "WAVL ranges cover the tree");
+
+    AVLTree<int, int> few;
+    for (int i = 0; i < 5; ++i) few.insert(make_pair(i, i));
+    vector<pair<AVLTree<int, int>::iterator, AVLTree<int, int>::iterator> > fewRanges = few.partition(16);
+    check(coversInOrder(few, fewRanges, sizes) && fewRanges.size() == 5 && largest(sizes) == 1,
+        "a tree smaller than k gives one range per item");
+
+    BinarySearchTree<int, int> chain;
+    for (int i = 0; i < 300; ++i) chain.insert(make_pair(i, i));
+    vector<pair<BinarySearchTree<int, int>::iterator, BinarySearchTree<int, int>::iterator> > chainRanges = chain.partition(4);
+    check(coversInOrder(chain, chainRanges, sizes) && chainRanges.size() == 4,
+        "an unbalanced tree is still covered");
+
+    AggregateAVLTree<int, int, CountOf> counted1;
+    for (int i = 0; i < 1000; ++i) counted1.insert(make_pair((i * 37) % 1000, i));
+    bool exact = true;
+    for (size_t k = 1; k <= 40; ++k) {
+        vector<pair<AVLTree<int, int>::iterator, AVLTree<int, int>::iterator> > ranges = counted1.partition(k);
+        exact = exact && coversInOrder(counted1, ranges, sizes) && ranges.size() == k
+            && largest(sizes) - smallest(sizes) <= 1;
+    }
+    check(exact, "a counted tree splits by rank to within one item");
+
+    AggregateAVLTree<int, int, SumOf<int> > summed;
+    for (int i = 0; i < 1000; ++i) summed.insert(make_pair(i, i));
+    vector<pair<AVLTree<int, int>::iterator, AVLTree<int, int>::iterator> > summedRanges = summed.partition(8);
+    check(coversInOrder(summed, summedRanges, sizes) && summedRanges.size() == 8,
+        "other aggregates fall back to subtree boundaries");
+
+    unsigned threadCounts[] = { 1, 2, 4, 9 };
+    bool visitsAll = true, sums = true, ordered = true;
+    for (size_t t = 0; t < sizeof(threadCounts) / sizeof(threadCounts[0]); ++t) {
+        unsigned threads = threadCounts[t];
+        AVLTree<int, int> tree;
+        for (int i = 0; i < 5000; ++i) tree.insert(make_pair(i, 0));
+        atomic<int> calls(0);
+        parallelForEach(tree, [&calls](pair<const int, int>& item) {
+            item.second = item.first * 2;
+            ++calls;
+        }, threads);
+        bool doubled = calls.load() == 5000;
+        for (AVLTree<int, int>::iterator it = tree.begin(); it != tree.end(); ++it) {
+            doubled = doubled && it->second == it->first * 2;
+        }
+        visitsAll = visitsAll && doubled;
+
+        long long sum = parallelReduce(tree, 0LL, [](long long acc, pair<const int, int>& item) {
+            return acc + item.second;
+        }, [](long long a, long long b) { return a + b; }, threads);
+        sums = sums && sum == 2LL * (4999LL * 5000 / 2);
+
+        // concatenation is not commutative, so this fails if chunks combine out of order
+        string expect;
+        for (int i = 0; i < 5000; ++i) expect += (char)('a' + i % 26);
+        string joined = parallelReduce(tree, string(), [](const string& acc, pair<const int, int>& item) {
+            return acc + (char)('a' + item.first % 26);
+        }, [](const string& a, const string& b) { return a + b; }, threads);
+        ordered = ordered && joined == expect;
+    }
+    check(visitsAll, "parallelForEach visits every item once and may change values");
+    check(sums, "parallelReduce sums match a sequential pass");
+    check(ordered, "parallelReduce combines chunks in key order");
+
+    // pending range updates reach the values before the chunks are read
+    LazyAVLTree<int, int, RangeAdd<int> > lazy;
+    for (int i = 0; i < 1000; ++i) lazy.insert(make_pair(i, 0));
+    lazy.applyRange(0, 999, 1);
+    int lazySum = parallelReduce(lazy, 0, [](int acc, pair<const int, int>& item) {
+        return acc + item.second;
+    }, [](int a, int b) { return a + b; }, 4);
+    lazy.applyRange(500, 999, 2);
+    atomic<int> lazyTotal(0);
+    parallelForEach(lazy, [&lazyTotal](pair<const int, int>& item) { lazyTotal += item.second; }, 4);
+    check(lazySum == 1000 && lazyTotal.load() == 2000, "parallelReduce and parallelForEach see pending range updates");
+
+    bool allPositive = parallelReduce(avl, true, [](bool acc, pair<const int, int>& item) {
+        return acc && item.first >= 0;
+    }, [](bool a, bool b) { return a && b; }, 4);
+    check(allPositive, "reduce to bool");
+
+    bool threw = false;
+    try {
+        parallelForEach(avl, [](pair<const int, int>& item) {
+            if (item.first == 5000) throw runtime_error("bad item");
+        }, 4);
+    }
+    catch (const runtime_error&) {
+        threw = true;
+    }
+    check(threw && avl.isBalanced() && avl.find(5000) != avl.end(), "an exception from f reaches the caller");
+
+    WorkStealingPool pool(3);
+    vector<int> ran(100, 0);
+    auto mark = [&ran](size_t i) { ++ran[i]; };
+    pool.run(ran.size(), mark);
+    bool once = true;
+    for (size_t i = 0; i < ran.size(); ++i) once = once && ran[i] == 1;
+    pool.run(0, mark);
+    check(once && pool.threads() == 3, "the pool runs every task exactly once and can be reused");
+
+    return failures == 0 ? 0 : 1;
+}
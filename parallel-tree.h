@@ -0,0 +1,216 @@
+#ifndef PARALLEL_TREE_H
+#define PARALLEL_TREE_H
+
+#include <cstddef>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <exception>
+#include "bst.h"
+
+/**
+* Runs a batch of numbered tasks on a set of threads started for the batch.
+* Each thread begins with a contiguous share of the task numbers in a deque
+* of its own and works from the front of it; a thread that runs dry steals
+* from the back of another's, so a few slow tasks do not leave the rest of
+* the threads idle. The calling thread works as one of them.
+*
+* If a task throws, no further tasks are started and run rethrows the first
+* exception once every thread has stopped.
+*/
+class WorkStealingPool
+{
+public:
+    // 0 threads means one per hardware thread.
+    explicit WorkStealingPool(unsigned threads = 0);
+    ~WorkStealingPool();
+
+    unsigned threads() const;
+    // Calls task(i) once for every i in [0, tasks) and returns when all are done.
+    template<typename Task>
+    void run(size_t tasks, Task& task);
+
+private:
+    WorkStealingPool(const WorkStealingPool&);
+    WorkStealingPool& operator=(const WorkStealingPool&);
+
+    struct Queue {
+        std::mutex lock;
+        std::deque<size_t> tasks;
+    };
+
+    // Takes the next task for thread self, stealing if its own queue is empty.
+    bool next(size_t self, size_t& task);
+    template<typename Task>
+    void work(size_t self, Task& task);
+
+    std::vector<Queue*> queues_;
+    std::atomic<bool> failed_;
+    std::exception_ptr error_;
+    std::mutex errorLock_;
+};
+
+/**
+* Calls f on every item of tree, split into chunks with partition and run on
+* a WorkStealingPool; chunks outnumber threads so that stealing can even out
+* chunks of unequal cost. f takes a std::pair<const Key, Value>& and may
+* change the value, but nothing may change the tree's shape until the call
+* returns. One copy of f is called from every thread at once. Items are
+* visited in key order within a chunk only.
+*/
+template<typename Key, typename Value, typename Function>
+void parallelForEach(const BinarySearchTree<Key, Value>& tree, Function f, unsigned threads = 0);
+
+/**
+* Folds every item of tree: each chunk starts from init and folds its items
+* in key order with acc = f(acc, item), and the chunk results are then
+* folded left to right with combine(a, b). combine must be associative with
+* init as its identity; it need not be commutative. f is shared between
+* threads as in parallelForEach; combine runs on the calling thread only.
+*/
+template<typename Key, typename Value, typename T, typename Function, typename Combine>
+T parallelReduce(const BinarySearchTree<Key, Value>& tree, const T& init, Function f, Combine combine,
+    unsigned threads = 0);
+
+// Chunks per pool thread for parallelForEach and parallelReduce.
+static const unsigned ChunksPerThread = 8;
+
+/*
+  ---------------------------------------------------
+  Begin implementations for the WorkStealingPool class.
+  ---------------------------------------------------
+*/
+
+inline WorkStealingPool::WorkStealingPool(unsigned threads) :
+    failed_(false)
+{
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    for (unsigned i = 0; i < threads; ++i) queues_.push_back(new Queue);
+}
+
+inline WorkStealingPool::~WorkStealingPool()
+{
+    for (size_t i = 0; i < queues_.size(); ++i) delete queues_[i];
+}
+
+inline unsigned WorkStealingPool::threads() const
+{
+    return (unsigned)queues_.size();
+}
+
+/**
+* Tasks are only ever removed, so once every queue has been found empty
+* there is nothing left to wait for.
+*/
+inline bool WorkStealingPool::next(size_t self, size_t& task)
+{
+    if (failed_.load()) return false;
+    {
+        std::lock_guard<std::mutex> guard(queues_[self]->lock);
+        if (!queues_[self]->tasks.empty()) {
+            task = queues_[self]->tasks.front();
+            queues_[self]->tasks.pop_front();
+            return true;
+        }
+    }
+    for (size_t i = 1; i < queues_.size(); ++i) {
+        Queue* victim = queues_[(self + i) % queues_.size()];
+        std::lock_guard<std::mutex> guard(victim->lock);
+        if (!victim->tasks.empty()) {
+            task = victim->tasks.back();
+            victim->tasks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+template<typename Task>
+void WorkStealingPool::work(size_t self, Task& task)
+{
+    size_t i;
+    while (next(self, i)) {
+        try {
+            task(i);
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> guard(errorLock_);
+            if (!failed_.load()) error_ = std::current_exception();
+            failed_.store(true);
+        }
+    }
+}
+
+template<typename Task>
+void WorkStealingPool::run(size_t tasks, Task& task)
+{
+    size_t n = queues_.size();
+    for (size_t q = 0; q < n; ++q) {
+        for (size_t i = tasks * q / n; i < tasks * (q + 1) / n; ++i) queues_[q]->tasks.push_back(i);
+    }
+    failed_.store(false);
+    error_ = std::exception_ptr();
+
+    std::vector<std::thread> workers;
+    size_t helpers = std::min(n, tasks) > 0 ? std::min(n, tasks) - 1 : 0;
+    try {
+        for (size_t q = 1; q <= helpers; ++q) {
+            workers.push_back(std::thread(&WorkStealingPool::work<Task>, this, q, std::ref(task)));
+        }
+    }
+    catch (...) {
+        //the threads already started, and this one, still drain every queue
+    }
+    work(0, task);
+    for (size_t i = 0; i < workers.size(); ++i) workers[i].join();
+
+    for (size_t q = 0; q < n; ++q) queues_[q]->tasks.clear();
+    if (failed_.load()) std::rethrow_exception(error_);
+}
+
+/*
+  -------------------------------------------------
+  End implementations for the WorkStealingPool class.
+  -------------------------------------------------
+*/
+
+template<typename Key, typename Value, typename Function>
+void parallelForEach(const BinarySearchTree<Key, Value>& tree, Function f, unsigned threads)
+{
+    typedef typename BinarySearchTree<Key, Value>::iterator iterator;
+    WorkStealingPool pool(threads);
+    std::vector<std::pair<iterator, iterator> > chunks = tree.partition(pool.threads() * ChunksPerThread);
+    auto task = [&chunks, &f](size_t i) {
+        for (iterator it = chunks[i].first; it != chunks[i].second; ++it) f(*it);
+    };
+    pool.run(chunks.size(), task);
+}
+
+template<typename Key, typename Value, typename T, typename Function, typename Combine>
+T parallelReduce(const BinarySearchTree<Key, Value>& tree, const T& init, Function f, Combine combine,
+    unsigned threads)
+{
+    typedef typename BinarySearchTree<Key, Value>::iterator iterator;
+    WorkStealingPool pool(threads);
+    std::vector<std::pair<iterator, iterator> > chunks = tree.partition(pool.threads() * ChunksPerThread);
+    //not a vector: vector<bool> packs its elements, so writes to neighbours would race
+    std::deque<T> results(chunks.size(), init);
+    auto task = [&chunks, &results, &f](size_t i) {
+        T acc = results[i];
+        for (iterator it = chunks[i].first; it != chunks[i].second; ++it) acc = f(acc, *it);
+        results[i] = acc;
+    };
+    pool.run(chunks.size(), task);
+
+    T acc = init;
+    for (size_t i = 0; i < results.size(); ++i) acc = combine(acc, results[i]);
+    return acc;
+}
+
+#endif
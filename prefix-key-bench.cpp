@@ -0,0 +1,73 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include "avlbst.h"
+#include "prefix-key.h"
+
+using namespace std;
+
+double msSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// A path of three random lowercase segments, long enough to live on the heap.
+string randomPath(mt19937_64& rng, const string& root)
+{
+    string s = root;
+    for (int seg = 0; seg < 3; ++seg) {
+        if (seg > 0) s += '/';
+        size_t len = 6 + rng() % 8;
+        for (size_t i = 0; i < len; ++i) s += (char)('a' + rng() % 26);
+    }
+    return s;
+}
+
+// Builds the tree from keys, then looks up probes (prebuilt, so neither side
+// pays for making its key type during the timing).
+template<class KeyType>
+void run(const char* name, const vector<string>& keys, const vector<string>& probeText)
+{
+    vector<KeyType> probes(probeText.begin(), probeText.end());
+    AVLTree<KeyType, int> tree;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t i = 0; i < keys.size(); ++i) tree.insert(make_pair(KeyType(keys[i]), (int)i));
+    double insertMs = msSince(start);
+
+    start = chrono::steady_clock::now();
+    size_t hits = 0;
+    for (size_t i = 0; i < probes.size(); ++i) hits += tree.find(probes[i]) != tree.end();
+    double findMs = msSince(start);
+
+    cout << fixed << setprecision(1);
+    cout << name << "insert " << insertMs << " ms, find " << findMs << " ms (" << hits << " hits)" << endl;
+}
+
+void workload(const char* title, const string& root, size_t n, size_t lookups)
+{
+    mt19937_64 rng(46);
+    vector<string> keys(n);
+    for (size_t i = 0; i < n; ++i) keys[i] = randomPath(rng, root);
+    vector<string> probes(lookups);
+    for (size_t i = 0; i < lookups; ++i) probes[i] = rng() % 2 == 0 ? keys[rng() % n] : randomPath(rng, root);
+
+    cout << title << endl;
+    run<string>("  AVLTree<string>:   ", keys, probes);
+    run<PrefixedString>("  StringAVLTree:     ", keys, probes);
+}
+
+int main(int argc, char* argv[])
+{
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 500000;
+    size_t lookups = argc > 2 ? strtoul(argv[2], NULL, 10) : 1000000;
+
+    cout << n << " keys, " << lookups << " lookups (half present)" << endl;
+    workload("keys that differ early (seg/seg/seg):", "", n, lookups);
+    // the prefix is the same for every key, so every compare is a tie
+    workload("keys under a shared root (https://www.seg/seg/seg):", "https://www.", n, lookups);
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include "prefix-key.h"
+#include "front-cache.h"
+#include "test-util.h"
+
+using namespace std;
+
+// Short strings over a tiny alphabet, with NULs and high bytes, so prefixes
+// collide often and padding cases come up.
+string randomKey()
+{
+    static const char alphabet[] = { 'a', 'b', '\0', '\xff' };
+    string s;
+    size_t len = rand() % 14;
+    for (size_t i = 0; i < len; ++i) s += alphabet[rand() % 4];
+    return s;
+}
+
+int main()
+{
+    srand(46);
+    vector<string> keys;
+    for (int i = 0; i < 400; ++i) keys.push_back(randomKey());
+    keys.push_back(string());
+    keys.push_back(string("ab"));
+    keys.push_back(string("ab\0", 3));
+
+    bool ordered = true;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        for (size_t j = 0; j < keys.size(); ++j) {
+            PrefixedString a(keys[i]), b(keys[j]);
+            ordered = ordered && (a < b) == (keys[i] < keys[j]) && (a == b) == (keys[i] == keys[j])
+                && (a > b) == (keys[i] > keys[j]) && (a <= b) == (keys[i] <= keys[j]);
+        }
+    }
+    check(ordered, "compares exactly like std::string");
+    check(PrefixedString("ab") < PrefixedString(string("ab\0", 3)), "padding does not hide a trailing NUL");
+    check(PrefixedString("\xff") > PrefixedString("a"), "bytes compare as unsigned");
+    check(PrefixedString("abcdefgh").prefix() == PrefixedString("abcdefghXYZ").prefix(), "prefix is the first 8 bytes");
+
+    StringAVLTree<int> tree;
+    map<string, int> ref;
+    bool agree = true;
+    for (int step = 0; step < 20000; ++step) {
+        string key = randomKey();
+        if (rand() % 3 == 0) {
+            tree.remove(key);
+            ref.erase(key);
+        }
+        else {
+            tree.insert(make_pair(PrefixedString(key), step));
+            ref[key] = step;
+        }
+    }
+    map<string, int>::iterator r = ref.begin();
+    for (StringAVLTree<int>::iterator it = tree.begin(); it != tree.end(); ++it, ++r) {
+        agree = agree && r != ref.end() && it->first.str() == r->first && it->second == r->second;
+    }
+    check(agree && r == ref.end() && tree.isBalanced(), "StringAVLTree matches std::map<string>");
+    check(tree.find("zzz") == tree.end() && (ref.count("ab") == 0 || tree["ab"] == ref["ab"]),
+        "lookups by string literal");
+
+    // hashable, so it works under the front cache
+    FrontCachedTree<PrefixedString, int> cached;
+    cached.insert(make_pair(PrefixedString("/usr/local/lib"), 1));
+    cached.insert(make_pair(PrefixedString("/usr/local/bin"), 2));
+    check(cached["/usr/local/bin"] == 2 && cached.find("/usr/local") == cached.end(), "works with FrontCachedTree");
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,179 @@
+#ifndef PREFIX_KEY_H
+#define PREFIX_KEY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+#include "avlbst.h"
+
+/**
+* A string key that carries its first 8 bytes as a big-endian integer,
+* zero-padded for shorter strings. Stored in a tree, the prefix sits inside
+* the node next to the links, so a compare whose prefixes differ is one
+* integer compare and never reads the string's heap buffer. Only keys with
+* equal prefixes compare the rest, starting after the bytes the prefix has
+* already settled. The length needs no copy: std::string keeps its size in
+* the node already.
+*
+* The order is exactly std::string's (bytes compared as unsigned char), so
+* a tree over PrefixedString iterates like one over std::string. Keys that
+* share their first 8 bytes gain nothing: strip a common scheme or root
+* ("https://", "/home/") before inserting where the index allows it.
+*/
+class PrefixedString
+{
+public:
+    PrefixedString();
+    PrefixedString(const std::string& str);
+    PrefixedString(const char* str);
+
+    const std::string& str() const;
+    uint64_t prefix() const;
+
+    bool operator==(const PrefixedString& rhs) const;
+    bool operator!=(const PrefixedString& rhs) const;
+    bool operator<(const PrefixedString& rhs) const;
+    bool operator>(const PrefixedString& rhs) const;
+    bool operator<=(const PrefixedString& rhs) const;
+    bool operator>=(const PrefixedString& rhs) const;
+
+    static uint64_t prefixOf(const std::string& str);
+
+private:
+    // Compares past the prefix, for two keys whose prefixes are equal.
+    int compareTail(const PrefixedString& rhs) const;
+
+    uint64_t prefix_;
+    std::string str_;
+};
+
+std::ostream& operator<<(std::ostream& out, const PrefixedString& key);
+
+namespace std {
+template <>
+struct hash<PrefixedString> {
+    size_t operator()(const PrefixedString& key) const
+    {
+        return hash<string>()(key.str());
+    }
+};
+}
+
+/**
+* An AVLTree over string keys with cached prefixes.
+*/
+template <typename Value>
+using StringAVLTree = AVLTree<PrefixedString, Value>;
+
+/*
+  -------------------------------------------------
+  Begin implementations for the PrefixedString class.
+  -------------------------------------------------
+*/
+
+inline PrefixedString::PrefixedString() :
+    prefix_(0)
+{
+
+}
+
+inline PrefixedString::PrefixedString(const std::string& str) :
+    prefix_(prefixOf(str)), str_(str)
+{
+
+}
+
+inline PrefixedString::PrefixedString(const char* str) :
+    str_(str)
+{
+    prefix_ = prefixOf(str_);
+}
+
+inline const std::string& PrefixedString::str() const
+{
+    return str_;
+}
+
+inline uint64_t PrefixedString::prefix() const
+{
+    return prefix_;
+}
+
+/**
+* Big-endian, so comparing two prefixes as integers compares their bytes
+* in order.
+*/
+inline uint64_t PrefixedString::prefixOf(const std::string& str)
+{
+    uint64_t p = 0;
+    size_t n = std::min<size_t>(str.size(), 8);
+    for (size_t i = 0; i < n; ++i) {
+        p |= (uint64_t)(unsigned char)str[i] << (56 - 8 * i);
+    }
+    return p;
+}
+
+/**
+* Equal prefixes mean the first min(8, shorter length) bytes are equal, so
+* the comparison picks up from there. The padding hides the difference
+* between "ab" and "ab\0", which the lengths settle.
+*/
+inline int PrefixedString::compareTail(const PrefixedString& rhs) const
+{
+    size_t shorter = std::min(str_.size(), rhs.str_.size());
+    size_t skip = std::min<size_t>(shorter, 8);
+    if (shorter > skip) {
+        int c = std::memcmp(str_.data() + skip, rhs.str_.data() + skip, shorter - skip);
+        if (c != 0) return c;
+    }
+    if (str_.size() == rhs.str_.size()) return 0;
+    return str_.size() < rhs.str_.size() ? -1 : 1;
+}
+
+inline bool PrefixedString::operator==(const PrefixedString& rhs) const
+{
+    return prefix_ == rhs.prefix_ && str_ == rhs.str_;
+}
+
+inline bool PrefixedString::operator!=(const PrefixedString& rhs) const
+{
+    return !(*this == rhs);
+}
+
+inline bool PrefixedString::operator<(const PrefixedString& rhs) const
+{
+    if (prefix_ != rhs.prefix_) return prefix_ < rhs.prefix_;
+    return compareTail(rhs) < 0;
+}
+
+inline bool PrefixedString::operator>(const PrefixedString& rhs) const
+{
+    return rhs < *this;
+}
+
+inline bool PrefixedString::operator<=(const PrefixedString& rhs) const
+{
+    return !(rhs < *this);
+}
+
+inline bool PrefixedString::operator>=(const PrefixedString& rhs) const
+{
+    return !(*this < rhs);
+}
+
+inline std::ostream& operator<<(std::ostream& out, const PrefixedString& key)
+{
+    return out << key.str();
+}
+
+/*
+  -----------------------------------------------
+  End implementations for the PrefixedString class.
+  -----------------------------------------------
+*/
+
+#endif
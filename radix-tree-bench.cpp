@@ -0,0 +1,71 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include "avlbst.h"
+#include "radix-tree.h"
+
+using namespace std;
+
+double msSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+template<class Tree>
+void run(const char* name, Tree& tree, const vector<long long>& keys, const vector<long long>& probes)
+{
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t i = 0; i < keys.size(); ++i) tree.insert(make_pair(keys[i], (int)i));
+    double insertMs = msSince(start);
+
+    start = chrono::steady_clock::now();
+    size_t hits = 0;
+    for (size_t i = 0; i < probes.size(); ++i) hits += tree.find(probes[i]) != tree.end();
+    double findMs = msSince(start);
+
+    start = chrono::steady_clock::now();
+    long long sum = 0;
+    for (typename Tree::iterator it = tree.begin(); it != tree.end(); ++it) sum += it->second;
+    double scanMs = msSince(start);
+
+    cout << fixed << setprecision(1);
+    cout << name << "insert " << insertMs << " ms, find " << findMs << " ms (" << hits
+         << " hits), scan " << scanMs << " ms" << endl;
+}
+
+void workload(const char* title, const vector<long long>& keys, size_t lookups)
+{
+    mt19937_64 rng(48);
+    vector<long long> probes(lookups);
+    for (size_t i = 0; i < lookups; ++i) probes[i] = keys[rng() % keys.size()] + (long long)(rng() % 2);
+
+    cout << title << endl;
+    AVLTree<long long, int> tree;
+    run("  AVLTree:       ", tree, keys, probes);
+    RadixAVLTree<long long, int> radix;
+    run("  RadixAVLTree:  ", radix, keys, probes);
+    cout << "  (k = " << radix.bits() << ")" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    size_t lookups = argc > 2 ? strtoul(argv[2], NULL, 10) : 2000000;
+    mt19937_64 rng(4848);
+
+    cout << n << " keys, " << lookups << " lookups (most present)" << endl;
+    // IDs handed out densely with a few gaps, inserted in random order
+    vector<long long> ids(n);
+    for (size_t i = 0; i < n; ++i) ids[i] = (long long)(i * 2 + rng() % 2) + 1000000;
+    shuffle(ids.begin(), ids.end(), rng);
+    workload("dense ids:", ids, lookups);
+
+    vector<long long> random(n);
+    for (size_t i = 0; i < n; ++i) random[i] = (long long)(rng() >> 1);
+    workload("uniform 63-bit keys:", random, lookups);
+    return 0;
+}
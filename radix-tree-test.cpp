@@ -0,0 +1,109 @@
+#include <iostream>
+#include <map>
+#include <climits>
+#include <cstdlib>
+#include <stdexcept>
+#include "radix-tree.h"
+#include "test-util.h"
+
+using namespace std;
+
+template<class Key>
+bool sameContents(const RadixAVLTree<Key, int>& tree, const map<Key, int>& ref)
+{
+    if (tree.size() != ref.size()) return false;
+    typename RadixAVLTree<Key, int>::iterator it = tree.begin();
+    for (typename map<Key, int>::const_iterator r = ref.begin(); r != ref.end(); ++r, ++it) {
+        if (it == tree.end() || it->first != r->first || it->second != r->second) return false;
+    }
+    return it == tree.end();
+}
+
+// Random inserts, removes and finds against std::map; keys come from pick.
+template<class Key, class Pick>
+bool randomOps(RadixAVLTree<Key, int>& tree, map<Key, int>& ref, int steps, Pick pick)
+{
+    bool ok = true;
+    for (int step = 0; step < steps; ++step) {
+        Key key = pick();
+        int op = rand() % 5;
+        if (op == 0) {
+            tree.remove(key);
+            ref.erase(key);
+        }
+        else if (op == 1) {
+            typename RadixAVLTree<Key, int>::iterator it = tree.find(key);
+            ok = ok && (it != tree.end()) == (ref.count(key) == 1);
+            if (it != tree.end()) ok = ok && it->second == ref[key];
+        }
+        else {
+            tree.insert(make_pair(key, step));
+            ref[key] = step;
+        }
+    }
+    return ok && sameContents(tree, ref) && tree.isBalanced();
+}
+
+long long denseId() { return rand() % 50000; }
+long long signedWide() { return ((long long)rand() << 33) ^ ((long long)rand() << 2) ^ (rand() % 2 == 0 ? LLONG_MIN : 0); }
+unsigned unsignedWide() { return (unsigned)rand() * 2654435761u; }
+// two clusters far apart: most of the range is empty
+long long clustered() { return (rand() % 2 == 0 ? 0 : 1LL << 50) + rand() % 5000; }
+
+int main()
+{
+    RadixAVLTree<long long, int> empty;
+    check(empty.empty() && empty.begin() == empty.end() && empty.min() == empty.end()
+        && empty.max() == empty.end() && empty.find(3) == empty.end(), "empty map");
+    bool threw = false;
+    try {
+        empty[3];
+    }
+    catch (const out_of_range&) {
+        threw = true;
+    }
+    check(threw, "operator[] throws for a missing key");
+
+    srand(48);
+    RadixAVLTree<long long, int> dense;
+    map<long long, int> denseRef;
+    check(randomOps(dense, denseRef, 100000, denseId), "dense ids match std::map");
+    check(dense.bits() >= 8, "dense ids get a large table");
+    check(dense.min()->first == denseRef.begin()->first && dense.max()->first == denseRef.rbegin()->first,
+        "min and max");
+
+    RadixAVLTree<long long, int> wide;
+    map<long long, int> wideRef;
+    check(randomOps(wide, wideRef, 50000, signedWide), "negative and positive 64-bit keys keep their order");
+    wide.insert(make_pair(LLONG_MIN, 1));
+    wide.insert(make_pair(LLONG_MAX, 2));
+    wideRef[LLONG_MIN] = 1;
+    wideRef[LLONG_MAX] = 2;
+    check(sameContents(wide, wideRef) && wide[LLONG_MIN] == 1 && wide[LLONG_MAX] == 2, "keys at the type's limits");
+
+    RadixAVLTree<unsigned, int> unsignedTree;
+    map<unsigned, int> unsignedRef;
+    check(randomOps(unsignedTree, unsignedRef, 50000, unsignedWide), "unsigned keys");
+
+    RadixAVLTree<long long, int> sparse;
+    map<long long, int> sparseRef;
+    check(randomOps(sparse, sparseRef, 30000, clustered), "clustered keys");
+    check(sparse.bits() <= 3, "clustered keys do not get a mostly empty table");
+
+    // keys past the tuned range land in the end slices until the next retune
+    RadixAVLTree<int, int> growing;
+    map<int, int> growingRef;
+    bool grows = true;
+    for (int i = 0; i < 20000; ++i) {
+        growing.insert(make_pair(i, i));
+        growingRef[i] = i;
+        if (i % 997 == 0) grows = grows && sameContents(growing, growingRef);
+    }
+    check(grows && growing.find(19999) != growing.end() && growing.isBalanced(), "ascending inserts past the range");
+    for (int i = 0; i < 19900; ++i) growing.remove(i);
+    check(growing.size() == 100 && growing.bits() <= 5 && growing.begin()->first == 19900, "shrinks its table");
+    growing.clear();
+    check(growing.empty() && growing.begin() == growing.end() && growing.bits() == 0, "clear");
+
+    return failures == 0 ? 0 : 1;
+}
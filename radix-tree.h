@@ -0,0 +1,427 @@
+#ifndef RADIX_TREE_H
+#define RADIX_TREE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <stdexcept>
+#include <type_traits>
+#include <iostream>
+#include "avlbst.h"
+
+/**
+* An ordered map over integer keys whose top levels are a table instead of
+* tree nodes. The keys' range is cut into 2^k equal slices by the top k bits
+* of (key - smallest key); each slice is a small AVLTree. A lookup indexes
+* the table with one shift and then searches only its slice's tree, skipping
+* the first k levels a single tree would walk.
+*
+* k follows the keys: retune() takes the range from the smallest and largest
+* key and aims for about targetBucketSize keys per slice, backing off while
+* fewer than a quarter of the slices would hold anything, so clustered keys
+* do not leave a mostly empty table. The map retunes itself when it has
+* doubled, or shrunk to a quarter, since the last time. Keys outside the
+* tuned range go to the first or last slice until then.
+*
+* The slices are in key order, so iteration is in key order. Iterators are
+* invalidated by an insert or remove that triggers a retune.
+*/
+template <typename Key, typename Value>
+class RadixAVLTree
+{
+    static_assert(std::is_integral<Key>::value, "RadixAVLTree needs an integer key");
+
+public:
+    typedef AVLTree<Key, Value> Tree;
+
+    explicit RadixAVLTree(size_t targetBucketSize = 8, unsigned maxBits = 20);
+    ~RadixAVLTree();
+
+    void insert(const std::pair<const Key, Value>& keyValuePair);
+    void remove(const Key& key);
+    void clear();
+    bool empty() const;
+    size_t size() const;
+    bool isBalanced() const;
+    void print() const;
+
+    // Picks k and the range for the keys stored now and redistributes them.
+    void retune();
+    // The current k; the table has 2^k slices.
+    unsigned bits() const;
+
+    /**
+    * An in-order iterator that runs across the slices.
+    */
+    class iterator
+    {
+    public:
+        iterator();
+
+        std::pair<const Key, Value>& operator*() const;
+        std::pair<const Key, Value>* operator->() const;
+
+        bool operator==(const iterator& rhs) const;
+        bool operator!=(const iterator& rhs) const;
+
+        iterator& operator++();
+
+    protected:
+        friend class RadixAVLTree<Key, Value>;
+        iterator(const RadixAVLTree<Key, Value>* map, size_t bucket, typename Tree::iterator current);
+        void skipEmpty();
+
+        const RadixAVLTree<Key, Value>* map_;
+        size_t bucket_;
+        typename Tree::iterator current_;
+    };
+
+    iterator begin() const;
+    iterator end() const;
+    iterator find(const Key& key) const;
+    iterator min() const;
+    iterator max() const;
+    Value& operator[](const Key& key);
+    Value const & operator[](const Key& key) const;
+
+protected:
+    // Maps keys to unsigned integers in the same order.
+    static uint64_t ordinal(const Key& key);
+    size_t bucketOf(const Key& key) const;
+    // Number of distinct slices the sorted ordinals fall into at k bits.
+    static size_t occupied(const std::vector<uint64_t>& sorted, unsigned spanBits, unsigned k);
+    void destroyBuckets();
+
+    std::vector<Tree*> buckets_;    // NULL for a slice that never held a key
+    uint64_t lo_;                   // ordinal of the smallest key at the last retune
+    unsigned bits_;
+    unsigned shift_;
+    size_t size_;
+    size_t tunedSize_;
+    size_t targetBucketSize_;
+    unsigned maxBits_;
+
+private:
+    RadixAVLTree(const RadixAVLTree&);
+    RadixAVLTree& operator=(const RadixAVLTree&);
+};
+
+/*
+  -----------------------------------------------------------
+  Begin implementations for the RadixAVLTree::iterator class.
+  -----------------------------------------------------------
+*/
+
+template<class Key, class Value>
+RadixAVLTree<Key, Value>::iterator::iterator() :
+    map_(NULL), bucket_(0), current_()
+{
+
+}
+
+template<class Key, class Value>
+RadixAVLTree<Key, Value>::iterator::iterator(const RadixAVLTree<Key, Value>* map, size_t bucket,
+    typename Tree::iterator current) :
+    map_(map), bucket_(bucket), current_(current)
+{
+
+}
+
+/**
+* Moves forward to the next slice with an item if the current one is used up.
+*/
+template<class Key, class Value>
+void RadixAVLTree<Key, Value>::iterator::skipEmpty()
+{
+    const std::vector<Tree*>& buckets = map_->buckets_;
+    while (bucket_ < buckets.size() && (buckets[bucket_] == NULL || current_ == buckets[bucket_]->end())) {
+        ++bucket_;
+        if (bucket_ < buckets.size() && buckets[bucket_] != NULL) {
+            current_ = buckets[bucket_]->begin();
+        }
+    }
+    if (bucket_ >= buckets.size()) {
+        bucket_ = buckets.size();
+        current_ = typename Tree::iterator();
+    }
+}
+
+template<class Key, class Value>
+std::pair<const Key, Value>& RadixAVLTree<Key, Value>::iterator::operator*() const
+{
+    return *current_;
+}
+
+template<class Key, class Value>
+std::pair<const Key, Value>* RadixAVLTree<Key, Value>::iterator::operator->() const
+{
+    return &(*current_);
+}
+
+template<class Key, class Value>
+bool RadixAVLTree<Key, Value>::iterator::operator==(const iterator& rhs) const
+{
+    return bucket_ == rhs.bucket_ && current_ == rhs.current_;
+}
+
+template<class Key, class Value>
+bool RadixAVLTree<Key, Value>::iterator::operator!=(const iterator& rhs) const
+{
+    return !(*this == rhs);
+}
+
+template<class Key, class Value>
+typename RadixAVLTree<Key, Value>::iterator& RadixAVLTree<Key, Value>::iterator::operator++()
+{
+    ++current_;
+    skipEmpty();
+    return *this;
+}
+
+/*
+  ---------------------------------------------------------
+  End implementations for the RadixAVLTree::iterator class.
+  ---------------------------------------------------------
+*/
+
+/*
+  -------------------------------------------------
+  Begin implementations for the RadixAVLTree class.
+  -------------------------------------------------
+*/
+
+template<class Key, class Value>
+RadixAVLTree<Key, Value>::RadixAVLTree(size_t targetBucketSize, unsigned maxBits) :
+    buckets_(1, (Tree*)NULL), lo_(0), bits_(0), shift_(0), size_(0), tunedSize_(0),
+    targetBucketSize_(targetBucketSize == 0 ? 1 : targetBucketSize),
+    maxBits_(maxBits > 30 ? 30 : maxBits)
+{
+
+}
+
+template<class Key, class Value>
+RadixAVLTree<Key, Value>::~RadixAVLTree()
+{
+    destroyBuckets();
+}
+
+template<class Key, class Value>
+uint64_t RadixAVLTree<Key, Value>::ordinal(const Key& key)
+{
+    //flipping the sign bit puts negative keys below positive ones
+    if (std::is_signed<Key>::value) return (uint64_t)(int64_t)key ^ (1ULL << 63);
+    return (uint64_t)key;
+}
+
+template<class Key, class Value>
+size_t RadixAVLTree<Key, Value>::bucketOf(const Key& key) const
+{
+    if (bits_ == 0) return 0;
+    uint64_t u = ordinal(key);
+    if (u <= lo_) return 0;
+    uint64_t b = (u - lo_) >> shift_;
+    return b >= buckets_.size() ? buckets_.size() - 1 : (size_t)b;
+}
+
+template<class Key, class Value>
+size_t RadixAVLTree<Key, Value>::occupied(const std::vector<uint64_t>& sorted, unsigned spanBits, unsigned k)
+{
+    size_t count = 0;
+    uint64_t last = 0;
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        uint64_t b = (sorted[i] - sorted[0]) >> (spanBits - k);
+        if (i == 0 || b != last) ++count;
+        last = b;
+    }
+    return count;
+}
+
+template<class Key, class Value>
+void RadixAVLTree<Key, Value>::destroyBuckets()
+{
+    for (size_t i = 0; i < buckets_.size(); ++i) {
+        delete buckets_[i];
+    }
+    buckets_.assign(1, (Tree*)NULL);
+}
+
+/**
+* Copies the items out in order, chooses k from their ordinals and loads each
+* slice's run of items with bulkLoad, so a retune is O(n) plus the choice.
+*/
+template<class Key, class Value>
+void RadixAVLTree<Key, Value>::retune()
+{
+    std::vector<std::pair<Key, Value> > items;
+    items.reserve(size_);
+    for (iterator it = begin(); it != end(); ++it) items.push_back(std::make_pair(it->first, it->second));
+    std::vector<uint64_t> ordinals(items.size());
+    for (size_t i = 0; i < items.size(); ++i) ordinals[i] = ordinal(items[i].first);
+
+    destroyBuckets();
+    bits_ = 0;
+    shift_ = 0;
+    lo_ = ordinals.empty() ? 0 : ordinals.front();
+    if (ordinals.size() > targetBucketSize_) {
+        uint64_t span = ordinals.back() - ordinals.front();
+        unsigned spanBits = 0;
+        while (spanBits < 64 && (span >> spanBits) != 0) ++spanBits;
+        unsigned k = 0;
+        while (k < maxBits_ && k < spanBits && ((size_t)targetBucketSize_ << (k + 1)) <= ordinals.size()) ++k;
+        while (k > 0 && occupied(ordinals, spanBits, k) * 4 < ((size_t)1 << k)) --k;
+        bits_ = k;
+        shift_ = spanBits - k;
+    }
+
+    buckets_.assign((size_t)1 << bits_, (Tree*)NULL);
+    size_t i = 0;
+    while (i < items.size()) {
+        size_t b = bucketOf(items[i].first);
+        size_t j = i + 1;
+        while (j < items.size() && bucketOf(items[j].first) == b) ++j;
+        buckets_[b] = new Tree;
+        buckets_[b]->bulkLoad(items.begin() + i, items.begin() + j);
+        i = j;
+    }
+    tunedSize_ = size_;
+}
+
+template<class Key, class Value>
+unsigned RadixAVLTree<Key, Value>::bits() const
+{
+    return bits_;
+}
+
+template<class Key, class Value>
+void RadixAVLTree<Key, Value>::insert(const std::pair<const Key, Value>& keyValuePair)
+{
+    size_t b = bucketOf(keyValuePair.first);
+    if (buckets_[b] == NULL) buckets_[b] = new Tree;
+    std::pair<typename Tree::iterator, bool> result = buckets_[b]->tryInsert(keyValuePair);
+    if (!result.second) {
+        result.first->second = keyValuePair.second;
+        return;
+    }
+    ++size_;
+    if (size_ > 2 * tunedSize_ && size_ > targetBucketSize_ * 8) retune();
+}
+
+template<class Key, class Value>
+void RadixAVLTree<Key, Value>::remove(const Key& key)
+{
+    Tree* tree = buckets_[bucketOf(key)];
+    if (tree == NULL) return;
+    typename Tree::iterator it = tree->find(key);
+    if (it == tree->end()) return;
+    tree->extract(it);
+    --size_;
+    if (size_ * 4 < tunedSize_) retune();
+}
+
+template<class Key, class Value>
+void RadixAVLTree<Key, Value>::clear()
+{
+    destroyBuckets();
+    lo_ = 0;
+    bits_ = 0;
+    shift_ = 0;
+    size_ = 0;
+    tunedSize_ = 0;
+}
+
+template<class Key, class Value>
+bool RadixAVLTree<Key, Value>::empty() const
+{
+    return size_ == 0;
+}
+
+template<class Key, class Value>
+size_t RadixAVLTree<Key, Value>::size() const
+{
+    return size_;
+}
+
+template<class Key, class Value>
+bool RadixAVLTree<Key, Value>::isBalanced() const
+{
+    for (size_t i = 0; i < buckets_.size(); ++i) {
+        if (buckets_[i] != NULL && !buckets_[i]->isBalanced()) return false;
+    }
+    return true;
+}
+
+template<class Key, class Value>
+void RadixAVLTree<Key, Value>::print() const
+{
+    for (size_t i = 0; i < buckets_.size(); ++i) {
+        if (buckets_[i] == NULL || buckets_[i]->empty()) continue;
+        std::cout << "slice " << i << ":" << std::endl;
+        buckets_[i]->print();
+    }
+}
+
+template<class Key, class Value>
+typename RadixAVLTree<Key, Value>::iterator RadixAVLTree<Key, Value>::begin() const
+{
+    iterator it(this, 0, buckets_[0] != NULL ? buckets_[0]->begin() : typename Tree::iterator());
+    it.skipEmpty();
+    return it;
+}
+
+template<class Key, class Value>
+typename RadixAVLTree<Key, Value>::iterator RadixAVLTree<Key, Value>::end() const
+{
+    return iterator(this, buckets_.size(), typename Tree::iterator());
+}
+
+template<class Key, class Value>
+typename RadixAVLTree<Key, Value>::iterator RadixAVLTree<Key, Value>::find(const Key& key) const
+{
+    size_t b = bucketOf(key);
+    Tree* tree = buckets_[b];
+    if (tree == NULL) return end();
+    typename Tree::iterator it = tree->find(key);
+    if (it == tree->end()) return end();
+    return iterator(this, b, it);
+}
+
+template<class Key, class Value>
+typename RadixAVLTree<Key, Value>::iterator RadixAVLTree<Key, Value>::min() const
+{
+    return begin();
+}
+
+template<class Key, class Value>
+typename RadixAVLTree<Key, Value>::iterator RadixAVLTree<Key, Value>::max() const
+{
+    for (size_t b = buckets_.size(); b > 0; --b) {
+        Tree* tree = buckets_[b - 1];
+        if (tree != NULL && !tree->empty()) return iterator(this, b - 1, tree->max());
+    }
+    return end();
+}
+
+template<class Key, class Value>
+Value& RadixAVLTree<Key, Value>::operator[](const Key& key)
+{
+    iterator it = find(key);
+    if (it == end()) throw std::out_of_range("Invalid key");
+    return it->second;
+}
+
+template<class Key, class Value>
+Value const & RadixAVLTree<Key, Value>::operator[](const Key& key) const
+{
+    iterator it = find(key);
+    if (it == end()) throw std::out_of_range("Invalid key");
+    return it->second;
+}
+
+/*
+  -----------------------------------------------
+  End implementations for the RadixAVLTree class.
+  -----------------------------------------------
+*/
+
+#endif
@@ -0,0 +1,49 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include "sharded-map.h"
+
+using namespace std;
+
+// Each thread inserts opsPerThread uniformly random keys; the map has one
+// shard per thread with evenly spaced splits, so throughput should scale
+// with the shard count up to the number of cores.
+double writeThroughput(size_t shards, size_t opsPerThread)
+{
+    const int keySpace = 1 << 30;
+    vector<int> splits;
+    for (size_t i = 1; i < shards; ++i) splits.push_back((int)((long long)keySpace * i / shards));
+    ShardedMap<int,int> sm(shards, splits);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (size_t t = 0; t < shards; ++t) {
+        workers.push_back(thread([&sm, t, opsPerThread, keySpace]() {
+            mt19937 rng(1234 + t);
+            uniform_int_distribution<int> dist(0, keySpace - 1);
+            for (size_t i = 0; i < opsPerThread; ++i) sm.insert(make_pair(dist(rng), (int)i));
+        }));
+    }
+    for (size_t t = 0; t < workers.size(); ++t) workers[t].join();
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return (shards * opsPerThread) / secs;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t ops = argc > 1 ? strtoul(argv[1], NULL, 10) : 200000;
+    cout << "hardware threads: " << thread::hardware_concurrency() << endl;
+    cout << setw(8) << "shards" << setw(16) << "inserts/sec" << setw(10) << "speedup" << endl;
+    double base = 0;
+    for (size_t shards = 1; shards <= 16; shards *= 2) {
+        double rate = writeThroughput(shards, ops);
+        if (shards == 1) base = rate;
+        cout << setw(8) << shards << setw(16) << (long long)rate
+             << setw(10) << fixed << setprecision(2) << rate / base << endl;
+    }
+    return 0;
+}
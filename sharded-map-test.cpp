@@ -0,0 +1,135 @@
+#include <iostream>
+#include <map>
+#include <vector>
+#include <thread>
+#include <cstdlib>
+#include "sharded-map.h"
+#include "test-util.h"
+
+using namespace std;
+
+// compares the map against a reference std::map, including key order
+bool sameContents(const ShardedMap<int,int>& sm, const map<int,int>& ref)
+{
+    if (sm.size() != ref.size()) return false;
+    map<int,int>::const_iterator r = ref.begin();
+    for (ShardedMap<int,int>::iterator it = sm.begin(); it != sm.end(); ++it, ++r) {
+        if (r == ref.end() || it->first != r->first || it->second != r->second) return false;
+    }
+    return r == ref.end();
+}
+
+// exposes the bounds a rebalance has replaced but not yet freed
+class InspectedMap : public ShardedMap<int,int>
+{
+public:
+    explicit InspectedMap(size_t shards) : ShardedMap<int,int>(shards) { }
+    size_t retired() const { return retired_.size(); }
+};
+
+void basicTest()
+{
+    vector<int> splits;
+    splits.push_back(100);
+    splits.push_back(200);
+    splits.push_back(300);
+    ShardedMap<int,int> sm(4, splits);
+    map<int,int> ref;
+
+    for (int i = 0; i < 400; i += 3) {
+        sm.insert(make_pair(i, i * 2));
+        ref[i] = i * 2;
+    }
+    sm.insert(make_pair(99, 7));
+    ref[99] = 7;
+    check(sameContents(sm, ref), "insert routes to shards and iterates in order");
+
+    int value = 0;
+    check(sm.find(99, value) && value == 7, "find returns overwritten value");
+    check(!sm.find(100, value), "find misses absent key");
+    check(sm.shardSize(0) > 0 && sm.shardSize(3) > 0, "entries spread over shards");
+
+    for (int i = 0; i < 400; i += 6) {
+        sm.remove(i);
+        ref.erase(i);
+    }
+    check(sameContents(sm, ref), "remove routes to shards");
+}
+
+void rebalanceTest()
+{
+    InspectedMap sm(4);
+    map<int,int> ref;
+    for (int i = 0; i < 1000; ++i) {
+        sm.insert(make_pair(i, i));
+        ref[i] = i;
+    }
+    check(sm.shardSize(0) == 1000, "unsplit map keeps everything in shard 0");
+
+    // moved entries keep their nodes, so their addresses do not change
+    map<int, const pair<const int,int>*> where;
+    for (ShardedMap<int,int>::iterator it = sm.begin(); it != sm.end(); ++it) where[it->first] = &*it;
+
+    check(sm.rebalance(), "rebalance moves boundaries on skewed data");
+    bool even = true;
+    for (size_t i = 0; i < sm.shardCount(); ++i) {
+        if (sm.shardSize(i) > 300) even = false;
+    }
+    check(even, "rebalance evens out shard sizes");
+    check(sm.splits().size() == 3, "rebalance carves out every shard");
+    check(sameContents(sm, ref), "rebalance keeps contents and order");
+    check(!sm.rebalance(), "rebalance is a no-op once balanced");
+    check(sm.retired() == 0, "rebalance frees the bounds it replaced");
+    bool relinked = true;
+    for (ShardedMap<int,int>::iterator it = sm.begin(); it != sm.end(); ++it) {
+        relinked = relinked && where[it->first] == &*it;
+    }
+    check(relinked, "rebalance relinks nodes instead of copying them");
+
+    vector<int> sample;
+    for (int i = 0; i < 1000; i += 10) sample.push_back(i);
+    sm.sampleSplits(sample);
+    check(sameContents(sm, ref), "sampleSplits keeps contents and order");
+    check(sm.retired() == 0, "sampleSplits frees the bounds it replaced");
+    relinked = true;
+    for (ShardedMap<int,int>::iterator it = sm.begin(); it != sm.end(); ++it) {
+        relinked = relinked && where[it->first] == &*it;
+    }
+    check(relinked, "sampleSplits relinks nodes instead of copying them");
+}
+
+void concurrentTest()
+{
+    InspectedMap sm(4);
+    vector<thread> workers;
+    for (int t = 0; t < 4; ++t) {
+        workers.push_back(thread([&sm, t]() {
+            for (int i = 0; i < 2000; ++i) sm.insert(make_pair(t * 2000 + i, i));
+        }));
+    }
+    workers.push_back(thread([&sm]() {
+        for (int i = 0; i < 20; ++i) sm.rebalance(0.1);
+    }));
+    for (size_t i = 0; i < workers.size(); ++i) workers[i].join();
+
+    bool all = (sm.size() == 8000);
+    for (int k = 0; k < 8000 && all; ++k) all = sm.contains(k);
+    check(all, "concurrent inserts with rebalance lose nothing");
+    check(sm.retired() == 0, "bounds retired under concurrent readers are freed");
+
+    int prev = -1;
+    bool ordered = true;
+    sm.forEach([&prev, &ordered](const pair<const int,int>& item) {
+        if (item.first <= prev) ordered = false;
+        prev = item.first;
+    });
+    check(ordered, "forEach visits keys in order");
+}
+
+int main()
+{
+    basicTest();
+    rebalanceTest();
+    concurrentTest();
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,804 @@
+#ifndef SHARDED_MAP_H
+#define SHARDED_MAP_H
+
+#include <iostream>
+#include <cstdlib>
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <new>
+#include <type_traits>
+#include "avlbst.h"
+
+/**
+* A free-list pool of AVL nodes. Nodes are carved out of fixed-size slabs and
+* recycled on release, so a tree that owns a pool never returns node memory to
+* the global heap (or contends on its lock) until the pool itself is destroyed.
+*/
+template <typename Key, typename Value>
+class AVLNodePool
+{
+public:
+    explicit AVLNodePool(size_t slabNodes = 256);
+    ~AVLNodePool();
+
+    void* allocate();
+    void release(void* slot);
+
+private:
+    AVLNodePool(const AVLNodePool&);
+    AVLNodePool& operator=(const AVLNodePool&);
+
+    union Slot {
+        Slot* next;
+        typename std::aligned_storage<sizeof(AVLNode<Key, Value>),
+                                      alignof(AVLNode<Key, Value>)>::type storage;
+    };
+
+    std::vector<Slot*> slabs_;
+    Slot* free_;
+    size_t slabNodes_;
+};
+
+/**
+* An AVLNodePool that several trees on different threads can draw from. Slots
+* move in batches, so a tree takes the lock about once per Batch nodes.
+*/
+template <typename Key, typename Value>
+class SharedNodePool
+{
+public:
+    static const size_t Batch = 64;
+
+    explicit SharedNodePool(size_t slabNodes = 256);
+
+    // Appends n free slots to slots.
+    void take(std::vector<void*>& slots, size_t n);
+    // Releases the last n slots of slots and removes them from it.
+    void give(std::vector<void*>& slots, size_t n);
+
+private:
+    SharedNodePool(const SharedNodePool&);
+    SharedNodePool& operator=(const SharedNodePool&);
+
+    std::mutex lock_;
+    AVLNodePool<Key, Value> pool_;
+};
+
+/**
+* An AVLTree whose nodes come from its own AVLNodePool, or from a
+* SharedNodePool it was given. Trees on the same shared pool trade nodes
+* through extract, insert(NodeHandle&&) and merge without copying; a tree
+* with its own pool only does so with itself. A shared pool must outlive
+* every tree using it.
+*/
+template <typename Key, typename Value>
+class PooledAVLTree : public AVLTree<Key, Value>
+{
+public:
+    PooledAVLTree();
+    explicit PooledAVLTree(SharedNodePool<Key, Value>& shared);
+    virtual ~PooledAVLTree();
+
+protected:
+    virtual AVLNode<Key, Value>* createNode(const Key& key, const Value& value, AVLNode<Key, Value>* parent);
+    virtual void destroyNode(AVLNode<Key, Value>* node);
+    virtual const void* nodeSource() const;
+
+    AVLNodePool<Key, Value> pool_;
+    SharedNodePool<Key, Value>* shared_;   // NULL when pool_ is used
+    std::vector<void*> spare_;             // slots taken from shared_ but not in use
+};
+
+/**
+* An ordered map whose key space is split into a fixed number of shards, each
+* an independent PooledAVLTree behind its own mutex. All shards draw nodes
+* from one SharedNodePool, so rebalancing relinks nodes instead of copying. Shard i holds the keys k
+* with splits[i-1] <= k < splits[i]; shards past the last split are unused.
+*
+* Split points may be given up front, derived from a sample with sampleSplits(),
+* or left empty, in which case every key starts in shard 0 and rebalance()
+* carves out the remaining shards from the data it sees.
+*
+* insert/remove/find are safe to call concurrently with each other and with
+* rebalance(). The iterator is NOT synchronized; use forEach() for an ordered
+* pass that runs alongside writers.
+*/
+template <typename Key, typename Value>
+class ShardedMap
+{
+public:
+    explicit ShardedMap(size_t shardCount);
+    ShardedMap(size_t shardCount, const std::vector<Key>& splits);
+    ~ShardedMap();
+
+    void insert(const std::pair<const Key, Value>& keyValuePair);
+    void remove(const Key& key);
+    bool find(const Key& key, Value& value) const;
+    bool contains(const Key& key) const;
+
+    size_t size() const;
+    size_t shardCount() const;
+    size_t shardSize(size_t shard) const;
+    std::vector<Key> splits() const;
+
+    // Replaces the split points with evenly spaced quantiles of sample,
+    // redistributing any entries already stored.
+    void sampleSplits(std::vector<Key> sample);
+
+    // Moves entries between neighbouring shards until no shard holds more than
+    // (1 + tolerance) times its fair share. Only two shards are locked at a
+    // time. Returns true if any boundary moved.
+    bool rebalance(double tolerance = 0.25);
+
+    // Calls f on every entry in key order, locking one shard at a time.
+    template <typename F>
+    void forEach(F f) const;
+
+    /**
+    * An in-order iterator that runs across shards.
+    */
+    class iterator
+    {
+    public:
+        iterator();
+
+        std::pair<const Key, Value>& operator*() const;
+        std::pair<const Key, Value>* operator->() const;
+
+        bool operator==(const iterator& rhs) const;
+        bool operator!=(const iterator& rhs) const;
+
+        iterator& operator++();
+
+    protected:
+        friend class ShardedMap<Key, Value>;
+        iterator(const ShardedMap<Key, Value>* map, size_t shard);
+        void skipEmpty();
+
+        const ShardedMap<Key, Value>* map_;
+        size_t shard_;
+        typename AVLTree<Key, Value>::iterator current_;
+    };
+
+    iterator begin() const;
+    iterator end() const;
+
+protected:
+    struct Bounds {
+        std::vector<Key> splits;
+        size_t route(const Key& key) const;
+    };
+
+    struct Shard {
+        std::mutex lock;
+        PooledAVLTree<Key, Value> tree;
+        std::atomic<size_t> count;
+        explicit Shard(SharedNodePool<Key, Value>& pool) : tree(pool), count(0) { }
+    };
+
+    size_t lockShardFor(const Key& key) const;
+    // Brackets a read of bounds_; enterRead returns what leaveRead takes.
+    size_t enterRead() const;
+    void leaveRead(size_t parity) const;
+    void publish(const Bounds* bounds);
+    // Frees the retired bounds once no reader can still hold them. Callers
+    // hold rebalanceLock_ and no shard lock, since readers may be waiting
+    // for one.
+    void reclaim();
+    void moveTail(size_t from, size_t to, size_t n);
+    void moveHead(size_t from, size_t to, size_t n);
+    const Key& smallestKey(size_t shard) const;
+
+    SharedNodePool<Key, Value> pool_;   // declared first: the shards give their nodes back to it
+    std::vector<Shard*> shards_;
+    std::atomic<const Bounds*> bounds_;
+    std::vector<const Bounds*> retired_;   // replaced bounds, freed by reclaim
+    mutable std::atomic<size_t> epoch_;
+    mutable std::atomic<size_t> readers_[2];   // readers that entered at an even or odd epoch
+    mutable std::mutex rebalanceLock_;
+
+private:
+    ShardedMap(const ShardedMap&);
+    ShardedMap& operator=(const ShardedMap&);
+};
+
+/*
+  ---------------------------------------------
+  Begin implementations for the AVLNodePool class.
+  ---------------------------------------------
+*/
+
+template<class Key, class Value>
+AVLNodePool<Key, Value>::AVLNodePool(size_t slabNodes) :
+    free_(NULL),
+    slabNodes_(slabNodes == 0 ? 1 : slabNodes)
+{
+
+}
+
+template<class Key, class Value>
+AVLNodePool<Key, Value>::~AVLNodePool()
+{
+    for (size_t i = 0; i < slabs_.size(); ++i) {
+        delete [] slabs_[i];
+    }
+}
+
+/**
+* Returns uninitialized storage for one AVLNode, growing by a slab when empty.
+*/
+template<class Key, class Value>
+void* AVLNodePool<Key, Value>::allocate()
+{
+    if (free_ == NULL) {
+        Slot* slab = new Slot[slabNodes_];
+        slabs_.push_back(slab);
+        //thread the new slab onto the free list back to front so it hands out in address order
+        for (size_t i = slabNodes_; i > 0; --i) {
+            slab[i - 1].next = free_;
+            free_ = &slab[i - 1];
+        }
+    }
+    Slot* slot = free_;
+    free_ = slot->next;
+    return slot;
+}
+
+/**
+* Returns storage obtained from allocate() to the free list.
+*/
+template<class Key, class Value>
+void AVLNodePool<Key, Value>::release(void* slot)
+{
+    Slot* s = static_cast<Slot*>(slot);
+    s->next = free_;
+    free_ = s;
+}
+
+/*
+  --------------------------------------------------
+  Begin implementations for the SharedNodePool class.
+  --------------------------------------------------
+*/
+
+template<class Key, class Value>
+SharedNodePool<Key, Value>::SharedNodePool(size_t slabNodes) :
+    pool_(slabNodes)
+{
+
+}
+
+template<class Key, class Value>
+void SharedNodePool<Key, Value>::take(std::vector<void*>& slots, size_t n)
+{
+    std::lock_guard<std::mutex> guard(lock_);
+    for (size_t i = 0; i < n; ++i) slots.push_back(pool_.allocate());
+}
+
+template<class Key, class Value>
+void SharedNodePool<Key, Value>::give(std::vector<void*>& slots, size_t n)
+{
+    if (n > slots.size()) n = slots.size();
+    std::lock_guard<std::mutex> guard(lock_);
+    for (size_t i = 0; i < n; ++i) {
+        pool_.release(slots.back());
+        slots.pop_back();
+    }
+}
+
+/*
+  -------------------------------------------------
+  Begin implementations for the PooledAVLTree class.
+  -------------------------------------------------
+*/
+
+template<class Key, class Value>
+PooledAVLTree<Key, Value>::PooledAVLTree() :
+    shared_(NULL)
+{
+
+}
+
+template<class Key, class Value>
+PooledAVLTree<Key, Value>::PooledAVLTree(SharedNodePool<Key, Value>& shared) :
+    pool_(1), shared_(&shared)
+{
+
+}
+
+template<class Key, class Value>
+PooledAVLTree<Key, Value>::~PooledAVLTree()
+{
+    //must run before pool_ goes away
+    this->clear();
+    if (shared_ != NULL) shared_->give(spare_, spare_.size());
+}
+
+/**
+* With a shared pool, slots come from spare_, refilled a batch at a time.
+*/
+template<class Key, class Value>
+AVLNode<Key, Value>* PooledAVLTree<Key, Value>::createNode(const Key& key, const Value& value, AVLNode<Key, Value>* parent)
+{
+    if (shared_ == NULL) return new (pool_.allocate()) AVLNode<Key, Value>(key, value, parent);
+    if (spare_.empty()) shared_->take(spare_, SharedNodePool<Key, Value>::Batch);
+    AVLNode<Key, Value>* n = new (spare_.back()) AVLNode<Key, Value>(key, value, parent);
+    spare_.pop_back();
+    return n;
+}
+
+/**
+* A node may have been made by another tree on the same shared pool, so
+* spare_ keeps at most two batches and hands the rest back.
+*/
+template<class Key, class Value>
+void PooledAVLTree<Key, Value>::destroyNode(AVLNode<Key, Value>* node)
+{
+    node->~AVLNode<Key, Value>();
+    if (shared_ == NULL) {
+        pool_.release(node);
+        return;
+    }
+    spare_.push_back(node);
+    if (spare_.size() > 2 * SharedNodePool<Key, Value>::Batch) {
+        shared_->give(spare_, SharedNodePool<Key, Value>::Batch);
+    }
+}
+
+/**
+* A tree with its own pool only moves nodes without copying within itself;
+* trees on one shared pool move them between each other too.
+*/
+template<class Key, class Value>
+const void* PooledAVLTree<Key, Value>::nodeSource() const
+{
+    if (shared_ != NULL) return shared_;
+    return &pool_;
+}
+
+/*
+  ------------------------------------------------------
+  Begin implementations for the ShardedMap::iterator class.
+  ------------------------------------------------------
+*/
+
+template<class Key, class Value>
+ShardedMap<Key, Value>::iterator::iterator() :
+    map_(NULL), shard_(0)
+{
+
+}
+
+template<class Key, class Value>
+ShardedMap<Key, Value>::iterator::iterator(const ShardedMap<Key, Value>* map, size_t shard) :
+    map_(map), shard_(shard)
+{
+    if (shard_ < map_->shards_.size()) {
+        current_ = map_->shards_[shard_]->tree.begin();
+        skipEmpty();
+    }
+}
+
+/**
+* Moves forward to the next shard that still has entries, or to end().
+*/
+template<class Key, class Value>
+void ShardedMap<Key, Value>::iterator::skipEmpty()
+{
+    while (shard_ < map_->shards_.size() && current_ == map_->shards_[shard_]->tree.end()) {
+        ++shard_;
+        if (shard_ < map_->shards_.size()) {
+            current_ = map_->shards_[shard_]->tree.begin();
+        }
+    }
+    if (shard_ >= map_->shards_.size()) {
+        shard_ = map_->shards_.size();
+        current_ = typename AVLTree<Key, Value>::iterator();
+    }
+}
+
+template<class Key, class Value>
+std::pair<const Key, Value>& ShardedMap<Key, Value>::iterator::operator*() const
+{
+    return *current_;
+}
+
+template<class Key, class Value>
+std::pair<const Key, Value>* ShardedMap<Key, Value>::iterator::operator->() const
+{
+    return &(*current_);
+}
+
+template<class Key, class Value>
+bool ShardedMap<Key, Value>::iterator::operator==(const iterator& rhs) const
+{
+    return shard_ == rhs.shard_ && current_ == rhs.current_;
+}
+
+template<class Key, class Value>
+bool ShardedMap<Key, Value>::iterator::operator!=(const iterator& rhs) const
+{
+    return !(*this == rhs);
+}
+
+template<class Key, class Value>
+typename ShardedMap<Key, Value>::iterator& ShardedMap<Key, Value>::iterator::operator++()
+{
+    ++current_;
+    skipEmpty();
+    return *this;
+}
+
+/*
+  -----------------------------------------------
+  Begin implementations for the ShardedMap class.
+  -----------------------------------------------
+*/
+
+/**
+* Index of the shard responsible for key under these bounds.
+*/
+template<class Key, class Value>
+size_t ShardedMap<Key, Value>::Bounds::route(const Key& key) const
+{
+    return std::upper_bound(splits.begin(), splits.end(), key) - splits.begin();
+}
+
+/**
+* Creates shardCount empty shards with no split points; all keys go to shard 0
+* until sampleSplits() or rebalance() spreads them out.
+*/
+template<class Key, class Value>
+ShardedMap<Key, Value>::ShardedMap(size_t shardCount) :
+    bounds_(new Bounds()), epoch_(0)
+{
+    readers_[0].store(0);
+    readers_[1].store(0);
+    if (shardCount == 0) shardCount = 1;
+    for (size_t i = 0; i < shardCount; ++i) {
+        shards_.push_back(new Shard(pool_));
+    }
+}
+
+/**
+* Creates shardCount empty shards with the given sorted split points. Any
+* splits beyond shardCount - 1 are ignored.
+*/
+template<class Key, class Value>
+ShardedMap<Key, Value>::ShardedMap(size_t shardCount, const std::vector<Key>& splits) :
+    bounds_(NULL), epoch_(0)
+{
+    readers_[0].store(0);
+    readers_[1].store(0);
+    if (shardCount == 0) shardCount = 1;
+    for (size_t i = 0; i < shardCount; ++i) {
+        shards_.push_back(new Shard(pool_));
+    }
+    Bounds* b = new Bounds();
+    b->splits = splits;
+    std::sort(b->splits.begin(), b->splits.end());
+    if (b->splits.size() > shardCount - 1) b->splits.resize(shardCount - 1);
+    bounds_.store(b);
+}
+
+template<class Key, class Value>
+ShardedMap<Key, Value>::~ShardedMap()
+{
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        delete shards_[i];
+    }
+    delete bounds_.load();
+    for (size_t i = 0; i < retired_.size(); ++i) {
+        delete retired_[i];
+    }
+}
+
+/**
+* Locks and returns the shard that owns key. The bounds are re-read after the
+* lock is taken; if a rebalance published new ones in between, the lookup is
+* retried so the caller never works on a stale shard.
+*/
+template<class Key, class Value>
+size_t ShardedMap<Key, Value>::lockShardFor(const Key& key) const
+{
+    while (true) {
+        size_t parity = enterRead();
+        const Bounds* b = bounds_.load();
+        size_t shard = b->route(key);
+        shards_[shard]->lock.lock();
+        bool current = bounds_.load() == b;
+        leaveRead(parity);
+        if (current) return shard;
+        shards_[shard]->lock.unlock();
+    }
+}
+
+/**
+* A reader registers under the parity of the epoch it saw before it loads
+* bounds_. Both are sequentially consistent, so once reclaim has seen each
+* parity drain after a publish, every reader of older bounds has left.
+*/
+template<class Key, class Value>
+size_t ShardedMap<Key, Value>::enterRead() const
+{
+    size_t parity = epoch_.load() & 1;
+    readers_[parity].fetch_add(1);
+    return parity;
+}
+
+template<class Key, class Value>
+void ShardedMap<Key, Value>::leaveRead(size_t parity) const
+{
+    readers_[parity].fetch_sub(1);
+}
+
+/**
+* Installs new bounds. Callers hold the locks of every shard whose range changes.
+*/
+template<class Key, class Value>
+void ShardedMap<Key, Value>::publish(const Bounds* bounds)
+{
+    retired_.push_back(bounds_.load());
+    bounds_.store(bounds);
+}
+
+/**
+* Flips the epoch twice, waiting each time for the readers registered under
+* the old parity; new readers go to the other counter, so the wait ends.
+* A reader holds bounds only long enough to route a key and take a shard
+* lock, and no shard lock is held here, so the waits are short.
+*/
+template<class Key, class Value>
+void ShardedMap<Key, Value>::reclaim()
+{
+    if (retired_.empty()) return;
+    for (int flip = 0; flip < 2; ++flip) {
+        size_t old = epoch_.fetch_add(1) & 1;
+        while (readers_[old].load() != 0) std::this_thread::yield();
+    }
+    for (size_t i = 0; i < retired_.size(); ++i) delete retired_[i];
+    retired_.clear();
+}
+
+template<class Key, class Value>
+void ShardedMap<Key, Value>::insert(const std::pair<const Key, Value>& keyValuePair)
+{
+    size_t shard = lockShardFor(keyValuePair.first);
+    Shard* s = shards_[shard];
+    std::pair<typename AVLTree<Key, Value>::iterator, bool> result = s->tree.tryInsert(keyValuePair);
+    if (result.second) s->count.fetch_add(1, std::memory_order_relaxed);
+    else result.first->second = keyValuePair.second;
+    s->lock.unlock();
+}
+
+template<class Key, class Value>
+void ShardedMap<Key, Value>::remove(const Key& key)
+{
+    size_t shard = lockShardFor(key);
+    Shard* s = shards_[shard];
+    //a full handle frees its node at the end of the statement, still under the lock
+    if (!s->tree.extract(key).empty()) s->count.fetch_sub(1, std::memory_order_relaxed);
+    s->lock.unlock();
+}
+
+/**
+* Copies the value for key into value and returns true, or returns false if
+* key is absent. A copy is returned because the entry may move shards as soon
+* as the lock is dropped.
+*/
+template<class Key, class Value>
+bool ShardedMap<Key, Value>::find(const Key& key, Value& value) const
+{
+    size_t shard = lockShardFor(key);
+    Shard* s = shards_[shard];
+    typename AVLTree<Key, Value>::iterator it = s->tree.find(key);
+    bool found = (it != s->tree.end());
+    if (found) value = it->second;
+    s->lock.unlock();
+    return found;
+}
+
+template<class Key, class Value>
+bool ShardedMap<Key, Value>::contains(const Key& key) const
+{
+    size_t shard = lockShardFor(key);
+    Shard* s = shards_[shard];
+    bool found = (s->tree.find(key) != s->tree.end());
+    s->lock.unlock();
+    return found;
+}
+
+template<class Key, class Value>
+size_t ShardedMap<Key, Value>::size() const
+{
+    size_t total = 0;
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        total += shards_[i]->count.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+template<class Key, class Value>
+size_t ShardedMap<Key, Value>::shardCount() const
+{
+    return shards_.size();
+}
+
+template<class Key, class Value>
+size_t ShardedMap<Key, Value>::shardSize(size_t shard) const
+{
+    return shards_[shard]->count.load(std::memory_order_relaxed);
+}
+
+template<class Key, class Value>
+std::vector<Key> ShardedMap<Key, Value>::splits() const
+{
+    size_t parity = enterRead();
+    std::vector<Key> splits = bounds_.load()->splits;
+    leaveRead(parity);
+    return splits;
+}
+
+template<class Key, class Value>
+typename ShardedMap<Key, Value>::iterator ShardedMap<Key, Value>::begin() const
+{
+    return iterator(this, 0);
+}
+
+template<class Key, class Value>
+typename ShardedMap<Key, Value>::iterator ShardedMap<Key, Value>::end() const
+{
+    return iterator(this, shards_.size());
+}
+
+template<class Key, class Value>
+template<typename F>
+void ShardedMap<Key, Value>::forEach(F f) const
+{
+    //holding rebalanceLock_ keeps entries from migrating into a shard we already visited
+    std::lock_guard<std::mutex> guard(rebalanceLock_);
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        std::lock_guard<std::mutex> shardGuard(shards_[i]->lock);
+        for (typename AVLTree<Key, Value>::iterator it = shards_[i]->tree.begin(); it != shards_[i]->tree.end(); ++it) {
+            f(*it);
+        }
+    }
+}
+
+template<class Key, class Value>
+void ShardedMap<Key, Value>::sampleSplits(std::vector<Key> sample)
+{
+    std::lock_guard<std::mutex> guard(rebalanceLock_);
+    for (size_t i = 0; i < shards_.size(); ++i) shards_[i]->lock.lock();
+
+    std::sort(sample.begin(), sample.end());
+    sample.erase(std::unique(sample.begin(), sample.end()), sample.end());
+    Bounds* b = new Bounds();
+    for (size_t i = 1; i < shards_.size() && !sample.empty(); ++i) {
+        const Key& split = sample[(sample.size() * i) / shards_.size()];
+        if (b->splits.empty() || b->splits.back() < split) b->splits.push_back(split);
+    }
+
+    //relink every entry that the new bounds route elsewhere; one that lands in
+    //a later shard is looked at again there, but then stays
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        PooledAVLTree<Key, Value>& tree = shards_[i]->tree;
+        typename AVLTree<Key, Value>::iterator it = tree.begin();
+        while (it != tree.end()) {
+            typename AVLTree<Key, Value>::iterator next = it;
+            ++next;
+            size_t to = b->route(it->first);
+            if (to != i) {
+                shards_[to]->tree.insert(tree.extract(it));
+                shards_[i]->count.fetch_sub(1, std::memory_order_relaxed);
+                shards_[to]->count.fetch_add(1, std::memory_order_relaxed);
+            }
+            it = next;
+        }
+    }
+    publish(b);
+
+    for (size_t i = shards_.size(); i > 0; --i) shards_[i - 1]->lock.unlock();
+    reclaim();
+}
+
+/**
+* Moves the n largest entries of shard from into shard to (from < to). Each
+* one is taken from max(), so nothing steps over the entries that stay, and
+* the shards share a pool, so the nodes are relinked rather than copied.
+*/
+template<class Key, class Value>
+void ShardedMap<Key, Value>::moveTail(size_t from, size_t to, size_t n)
+{
+    PooledAVLTree<Key, Value>& src = shards_[from]->tree;
+    size_t moved = 0;
+    for (; moved < n && !src.empty(); ++moved) shards_[to]->tree.insert(src.extract(src.max()));
+    shards_[from]->count.fetch_sub(moved, std::memory_order_relaxed);
+    shards_[to]->count.fetch_add(moved, std::memory_order_relaxed);
+}
+
+/**
+* Moves the n smallest entries of shard from into shard to (to < from).
+*/
+template<class Key, class Value>
+void ShardedMap<Key, Value>::moveHead(size_t from, size_t to, size_t n)
+{
+    PooledAVLTree<Key, Value>& src = shards_[from]->tree;
+    size_t moved = 0;
+    for (; moved < n && !src.empty(); ++moved) shards_[to]->tree.insert(src.extract(src.min()));
+    shards_[from]->count.fetch_sub(moved, std::memory_order_relaxed);
+    shards_[to]->count.fetch_add(moved, std::memory_order_relaxed);
+}
+
+/**
+* @precondition shard is non-empty and locked
+*/
+template<class Key, class Value>
+const Key& ShardedMap<Key, Value>::smallestKey(size_t shard) const
+{
+    return shards_[shard]->tree.begin()->first;
+}
+
+template<class Key, class Value>
+bool ShardedMap<Key, Value>::rebalance(double tolerance)
+{
+    std::lock_guard<std::mutex> guard(rebalanceLock_);
+    size_t n = shards_.size();
+    size_t total = size();
+    if (n < 2 || total == 0) return false;
+
+    size_t fair = (total + n - 1) / n;
+    size_t largest = 0;
+    for (size_t i = 0; i < n; ++i) largest = std::max(largest, shardSize(i));
+    if (largest <= fair + (size_t)(fair * tolerance)) return false;
+
+    bool moved = false;
+    //each pass settles boundaries left to right; entries that must travel
+    //further than one shard per pass take a few passes to arrive
+    for (size_t pass = 0; pass < n; ++pass) {
+        bool passMoved = false;
+        size_t prefix = 0;
+        for (size_t i = 0; i + 1 < n; ++i) {
+            std::lock_guard<std::mutex> left(shards_[i]->lock);
+            std::lock_guard<std::mutex> right(shards_[i + 1]->lock);
+            const Bounds* old = bounds_.load(std::memory_order_relaxed);
+
+            total = size();
+            size_t want = std::min(total, (total * (i + 1) + n - 1) / n);
+            prefix += shardSize(i);
+            if (i > old->splits.size()) break;   //shard i is unused, and so is everything after it
+
+            Bounds* b = NULL;
+            if (prefix > want && shardSize(i) > 0) {
+                moveTail(i, i + 1, prefix - want);
+                b = new Bounds(*old);
+                if (i == b->splits.size()) b->splits.push_back(smallestKey(i + 1));
+                else b->splits[i] = smallestKey(i + 1);
+            }
+            else if (prefix < want && i < old->splits.size() && shardSize(i + 1) > 0) {
+                moveHead(i + 1, i, want - prefix);
+                b = new Bounds(*old);
+                if (shardSize(i + 1) > 0) b->splits[i] = smallestKey(i + 1);
+                else if (i + 1 < b->splits.size()) b->splits[i] = b->splits[i + 1];
+                else b->splits.resize(i);
+            }
+            if (b != NULL) {
+                publish(b);
+                passMoved = true;
+                prefix = 0;
+                for (size_t j = 0; j <= i; ++j) prefix += shardSize(j);
+            }
+        }
+        if (!passMoved) break;
+        moved = true;
+    }
+    reclaim();
+    return moved;
+}
+
+#endif
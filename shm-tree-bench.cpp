@@ -0,0 +1,95 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "avlbst.h"
+#include "shm-tree.h"
+
+using namespace std;
+
+double msSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// Reads from worker processes that share one SharedAVLTree segment, against
+// workers that each hold a private AVLTree copy, optionally with a writer
+// process updating the shared tree. Reports lookups per second and the
+// memory each layout needs.
+int main(int argc, char* argv[])
+{
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    int workers = argc > 2 ? atoi(argv[2]) : 4;
+    size_t probes = argc > 3 ? strtoul(argv[3], NULL, 10) : 1000000;
+    string name = "/shm-tree-bench." + to_string(getpid());
+
+    mt19937_64 rng(33);
+    vector<long long> keys(n);
+    for (size_t i = 0; i < n; ++i) keys[i] = (long long)(rng() >> 1);
+
+    SharedAVLTree<long long,long long>::unlink(name);
+    SharedAVLTree<long long,long long> shared;
+    shared.create(name, n + 1024);
+    AVLTree<long long,long long> local;
+    for (size_t i = 0; i < n; ++i) {
+        shared.insert(make_pair(keys[i], (long long)i));
+        local.insert(make_pair(keys[i], (long long)i));
+    }
+
+    cout << n << " entries, " << workers << " workers, " << probes << " lookups each" << endl;
+    cout << fixed << setprecision(1);
+    cout << "shared segment:  " << (256 + (n + 1024) * sizeof(SharedAVLTree<long long,long long>::Record)) / 1048576.0
+         << " MiB once" << endl;
+    cout << "private copies:  " << n * sizeof(AVLNode<long long,long long>) / 1048576.0
+         << " MiB per worker (node payload only)" << endl;
+
+    for (int mode = 0; mode < 3; ++mode) {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        pid_t writer = -1;
+        if (mode == 2) {
+            writer = fork();
+            if (writer == 0) {
+                SharedAVLTree<long long,long long> w;
+                w.attach(name);
+                for (size_t i = 0; i < probes / 10; ++i) w.insert(make_pair(keys[i % n], (long long)i));
+                _exit(0);
+            }
+        }
+        vector<pid_t> pids;
+        for (int w = 0; w < workers; ++w) {
+            pid_t pid = fork();
+            if (pid == 0) {
+                long long sink = 0;
+                if (mode == 0) {
+                    for (size_t i = 0; i < probes; ++i) sink += local.find(keys[(i * 7919 + w) % n])->second;
+                }
+                else {
+                    SharedAVLTree<long long,long long> reader;
+                    reader.attach(name);
+                    long long value = 0;
+                    for (size_t i = 0; i < probes; ++i) {
+                        if (reader.find(keys[(i * 7919 + w) % n], value)) sink += value;
+                    }
+                }
+                _exit(sink == 42 ? 1 : 0);
+            }
+            pids.push_back(pid);
+        }
+        for (size_t i = 0; i < pids.size(); ++i) waitpid(pids[i], NULL, 0);
+        if (writer > 0) waitpid(writer, NULL, 0);
+        double ms = msSince(start);
+
+        const char* label = mode == 0 ? "private AVLTree:" : mode == 1 ? "shared, no writer:" : "shared, with writer:";
+        cout << left << setw(22) << label << right << setw(12)
+             << (long long)(workers * probes / (ms / 1000)) << " lookups/s" << endl;
+    }
+
+    shared.close();
+    SharedAVLTree<long long,long long>::unlink(name);
+    return 0;
+}
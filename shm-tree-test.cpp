@@ -0,0 +1,105 @@
+#include <iostream>
+#include <string>
+#include <map>
+#include <stdexcept>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "shm-tree.h"
+#include "test-util.h"
+
+using namespace std;
+
+int main()
+{
+    string name = "/shm-tree-test." + to_string(getpid());
+    SharedAVLTree<int,long>::unlink(name);
+
+    SharedAVLTree<int,long> tree;
+    tree.create(name, 2000);
+    map<int,long> expect;
+    for (int i = 0; i < 1000; ++i) {
+        tree.insert(make_pair((i * 37) % 1000, (long)i));
+        expect[(i * 37) % 1000] = i;
+    }
+    for (int i = 0; i < 1000; i += 4) {
+        tree.remove(i);
+        expect.erase(i);
+    }
+    tree.insert(make_pair(1, -1L));
+    expect[1] = -1;
+    check(tree.size() == expect.size() && tree.isBalanced(), "inserts and removes keep the tree balanced");
+
+    map<int,long> seen;
+    tree.forEach([&seen](const int& k, const long& v) { seen[k] = v; });
+    check(seen == expect, "forEach yields every entry in order");
+    long v = 0;
+    check(tree.find(1, v) && v == -1 && !tree.contains(4), "find and contains");
+
+    // freed records are reused, so churn does not exhaust the segment
+    for (int round = 0; round < 10; ++round) {
+        for (int i = 5000; i < 5900; ++i) tree.insert(make_pair(i, (long)i));
+        for (int i = 5000; i < 5900; ++i) tree.remove(i);
+    }
+    check(tree.size() == expect.size() && tree.isBalanced(), "released records are recycled");
+
+    bool threw = false;
+    try {
+        for (int i = 10000; i < 12000; ++i) tree.insert(make_pair(i, 0L));
+    }
+    catch (const runtime_error&) {
+        threw = true;
+    }
+    check(threw && tree.size() == 2000, "a full segment rejects new keys");
+    for (int i = 10000; i < 12000; ++i) tree.remove(i);
+
+    // another process maps the segment at its own address and sees the same tree
+    pid_t child = fork();
+    if (child == 0) {
+        SharedAVLTree<int,long> other;
+        other.attach(name);
+        long value = 0;
+        bool ok = other.size() == expect.size() && other.find(1, value) && value == -1;
+        other.insert(make_pair(-5, 55L));
+        _exit(ok ? 0 : 1);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    check(WIFEXITED(status) && WEXITSTATUS(status) == 0, "another process attaches and reads");
+    check(tree.find(-5, v) && v == 55, "writes from another process are visible");
+
+    // readers racing a writer only ever see complete updates: every value
+    // written is key * generation, so a torn read would break the ratio
+    for (int i = 0; i < 500; ++i) tree.insert(make_pair(i + 1, (long)(i + 1)));
+    child = fork();
+    if (child == 0) {
+        SharedAVLTree<int,long> writer;
+        writer.attach(name);
+        for (long gen = 2; gen < 200; ++gen) {
+            for (int i = 1; i <= 500; i += 7) writer.insert(make_pair(i, i * gen));
+            writer.remove(1000 + (int)gen);
+            writer.insert(make_pair(1000 + (int)gen + 1, 0L));
+        }
+        _exit(0);
+    }
+    bool consistent = true;
+    for (int round = 0; round < 20000; ++round) {
+        int k = 1 + round % 500;
+        long value = 0;
+        consistent = consistent && tree.find(k, value) && value % k == 0;
+    }
+    waitpid(child, &status, 0);
+    check(consistent && WIFEXITED(status) && tree.isBalanced(), "lock-free reads stay consistent under writes");
+
+    tree.close();
+    SharedAVLTree<int,long>::unlink(name);
+    threw = false;
+    try {
+        tree.attach(name);
+    }
+    catch (const runtime_error&) {
+        threw = true;
+    }
+    check(threw, "unlinked segments cannot be attached");
+
+    return failures == 0 ? 0 : 1;
+}
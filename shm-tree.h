@@ -0,0 +1,613 @@
+#ifndef SHM_TREE_H
+#define SHM_TREE_H
+
+#include <cstring>
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <utility>
+#include <atomic>
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <pthread.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+* An AVL tree whose nodes live in a named POSIX shared-memory segment, so any
+* number of processes can map one copy instead of each building its own.
+*
+* Nodes link to their children by record index rather than by pointer, so the
+* segment can be mapped at a different address in every process. The segment
+* has a fixed capacity chosen when it is created; removed records go on a
+* free list and are reused.
+*
+* Writers serialize on a process-shared mutex in the segment header. Readers
+* never lock: a sequence counter is made odd while a write is in progress and
+* even again after it, and a reader that sees it odd or changed retries. A
+* reader therefore never blocks a writer, and always returns the result of
+* one complete state of the tree. Reads that race a write may follow
+* half-updated links, so every index is range-checked and every walk is
+* bounded before its result is validated.
+*
+* If a writer process dies while holding the lock the segment must be
+* rebuilt; the lock is not robust. Key and Value must be trivially copyable.
+*/
+template <typename Key, typename Value>
+class SharedAVLTree
+{
+public:
+    static const uint64_t Nil = ~(uint64_t)0;
+
+    struct Record {
+        Key first;
+        Value second;
+        uint64_t left;      // record index of the left child, or Nil
+        uint64_t right;     // record index of the right child, or Nil
+        int8_t height;      // a leaf has height 1
+    };
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t keySize;
+        uint32_t valueSize;
+        uint32_t recordSize;
+        uint64_t capacity;
+        uint64_t count;
+        uint64_t root;
+        uint64_t used;          // records ever handed out, from the front
+        uint64_t freeList;      // released records, linked through left
+        std::atomic<uint64_t> seq;
+        pthread_mutex_t writeLock;
+    };
+
+    static const size_t RecordsOffset = 256;
+
+    SharedAVLTree();
+    ~SharedAVLTree();
+
+    // Creates and maps a new segment called name (e.g. "/prices") with room
+    // for capacity entries. Throws std::runtime_error if it already exists.
+    void create(const std::string& name, size_t capacity);
+    // Maps an existing segment. Throws std::runtime_error if it is missing or
+    // was created for other types.
+    void attach(const std::string& name);
+    // Unmaps the segment. The segment itself lives on until unlinked.
+    void close();
+    static void unlink(const std::string& name);
+
+    // Writer operations. insert throws std::runtime_error if the segment is full.
+    void insert(const std::pair<const Key, Value>& item);
+    void remove(const Key& key);
+
+    // Reader operations; these never take the lock.
+    bool find(const Key& key, Value& value) const;
+    bool contains(const Key& key) const;
+    // Calls f(key, value) for every entry of one consistent snapshot, in key order.
+    template<class F>
+    void forEach(F f) const;
+
+    size_t size() const;
+    size_t capacity() const;
+    // Takes the write lock and checks heights and ordering.
+    bool isBalanced() const;
+
+protected:
+    static const int MaxDepth = 128;
+
+    void map(int fd, size_t length);
+    void lock() const;
+    void unlock() const;
+    void beginWrite();
+    void endWrite();
+
+    uint64_t allocate(const Key& key, const Value& value);
+    void release(uint64_t n);
+
+    int height(uint64_t n) const;
+    void updateHeight(uint64_t n);
+    uint64_t rotateLeft(uint64_t n);
+    uint64_t rotateRight(uint64_t n);
+    uint64_t rebalance(uint64_t n);
+    uint64_t insertAt(uint64_t n, const Key& key, const Value& value);
+    uint64_t removeAt(uint64_t n, const Key& key, bool& removed);
+    uint64_t removeMin(uint64_t n, uint64_t& min);
+    bool findLocked(const Key& key) const;
+    int checkHelper(uint64_t n, const Key* lo, const Key* hi) const;
+
+    void* base_;
+    size_t length_;
+    Header* header_;
+    Record* records_;
+
+private:
+    SharedAVLTree(const SharedAVLTree&);
+    SharedAVLTree& operator=(const SharedAVLTree&);
+
+    static_assert(std::is_trivially_copyable<Key>::value, "SharedAVLTree keys must be trivially copyable");
+    static_assert(std::is_trivially_copyable<Value>::value, "SharedAVLTree values must be trivially copyable");
+    static_assert(sizeof(Header) <= RecordsOffset, "SharedAVLTree header does not fit");
+};
+
+/*
+  -------------------------------------------------
+  Begin implementations for the SharedAVLTree class.
+  -------------------------------------------------
+*/
+
+template<class Key, class Value>
+SharedAVLTree<Key, Value>::SharedAVLTree() :
+    base_(NULL), length_(0), header_(NULL), records_(NULL)
+{
+
+}
+
+template<class Key, class Value>
+SharedAVLTree<Key, Value>::~SharedAVLTree()
+{
+    close();
+}
+
+template<class Key, class Value>
+void SharedAVLTree<Key, Value>::map(int fd, size_t length)
+{
+    void* base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) throw std::runtime_error("SharedAVLTree: cannot map segment");
+    base_ = base;
+    length_ = length;
+    header_ = static_cast<Header*>(base);
+    records_ = reinterpret_cast<Record*>(static_cast<char*>(base) + RecordsOffset);
+}
+
+template<class Key, class Value>
+void SharedAVLTree<Key, Value>::create(const std::string& name, size_t capacity)
+{
+    close();
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) throw std::runtime_error("SharedAVLTree: cannot create " + name);
+    size_t length = RecordsOffset + capacity * sizeof(Record);
+    if (ftruncate(fd, length) != 0) {
+        ::close(fd);
+        shm_unlink(name.c_str());
+        throw std::runtime_error("SharedAVLTree: cannot size " + name);
+    }
+    try {
+        map(fd, length);
+    }
+    catch (...) {
+        ::close(fd);
+        shm_unlink(name.c_str());
+        throw;
+    }
+    ::close(fd);
+
+    Header* h = header_;
+    h->version = 1;
+    h->keySize = sizeof(Key);
+    h->valueSize = sizeof(Value);
+    h->recordSize = sizeof(Record);
+    h->capacity = capacity;
+    h->count = 0;
+    h->root = Nil;
+    h->used = 0;
+    h->freeList = Nil;
+    new (&h->seq) std::atomic<uint64_t>(0);
+
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutex_init(&h->writeLock, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    //the magic goes in last, so a half-created segment never validates
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(h->magic, "AVLSHM1", 8);
+}
+
+template<class Key, class Value>
+void SharedAVLTree<Key, Value>::attach(const std::string& name)
+{
+    close();
+
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) throw std::runtime_error("SharedAVLTree: cannot open " + name);
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < RecordsOffset) {
+        ::close(fd);
+        throw std::runtime_error("SharedAVLTree: " + name + " is too short");
+    }
+    try {
+        map(fd, st.st_size);
+    }
+    catch (...) {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+
+    const Header* h = header_;
+    bool valid = std::memcmp(h->magic, "AVLSHM1", 8) == 0
+        && h->version == 1
+        && h->keySize == sizeof(Key)
+        && h->valueSize == sizeof(Value)
+        && h->recordSize == sizeof(Record)
+        && h->capacity <= (length_ - RecordsOffset) / sizeof(Record);
+    if (!valid) {
+        close();
+        throw std::runtime_error("SharedAVLTree: " + name + " is not a tree of this type");
+    }
+}
+
+template<class Key, class Value>
+void SharedAVLTree<Key, Value>::close()
+{
+    if (base_ != NULL) munmap(base_, length_);
+    base_ = NULL;
+    length_ = 0;
+    header_ = NULL;
+    records_ = NULL;
+}
+
+template<class Key, class Value>
+void SharedAVLTree<Key, Value>::unlink(const std::string& name)
+{
+    shm_unlink(name.c_str());
+}
+
+template<class Key, class Value>
+void SharedAVLTree<Key, Value>::lock() const
+{
+    pthread_mutex_lock(&header_->writeLock);
+}
+
+template<class Key, class Value>
+void SharedAVLTree<Key, Value>::unlock() const
+{
+    pthread_mutex_unlock(&header_->writeLock);
+}
+
+/**
+* Makes the sequence counter odd before any record changes become visible.
+*/
+template<class Key, class Value>
+void SharedAVLTree<Key, Value>::beginWrite()
+{
+    header_->seq.store(header_->seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+template<class Key, class Value>
+void SharedAVLTree<Key, Value>::endWrite()
+{
+    header_->seq.store(header_->seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+template<class Key, class Value>
+uint64_t SharedAVLTree<Key, Value>::allocate(const Key& key, const Value& value)
+{
+    uint64_t n = header_->freeList;
+    if (n != Nil) header_->freeList = records_[n].left;
+    else n = header_->used++;
+
+    Record& r = records_[n];
+    std::memcpy(&r.first, &key, sizeof(Key));
+    std::memcpy(&r.second, &value, sizeof(Value));
+    r.left = Nil;
+    r.right = Nil;
+    r.height = 1;
+    ++header_->count;
+    return n;
+}
+
+template<class Key, class Value>
+void SharedAVLTree<Key, Value>::release(uint64_t n)
+{
+    records_[n].left = header_->freeList;
+    records_[n].right = Nil;
+    header_->freeList = n;
+    --header_->count;
+}
+
+template<class Key, class Value>
+int SharedAVLTree<Key, Value>::height(uint64_t n) const
+{
+    return n == Nil ? 0 : records_[n].height;
+}
+
+template<class Key, class Value>
+void SharedAVLTree<Key, Value>::updateHeight(uint64_t n)
+{
+    Record& r = records_[n];
+    r.height = std::max(height(r.left), height(r.right)) + 1;
+}
+
+//n's right child takes its place; returns the new subtree root
+template<class Key, class Value>
+uint64_t SharedAVLTree<Key, Value>::rotateLeft(uint64_t n)
+{
+    uint64_t right = records_[n].right;
+    records_[n].right = records_[right].left;
+    records_[right].left = n;
+    updateHeight(n);
+    updateHeight(right);
+    return right;
+}
+
+//n's left child takes its place; returns the new subtree root
+template<class Key, class Value>
+uint64_t SharedAVLTree<Key, Value>::rotateRight(uint64_t n)
+{
+    uint64_t left = records_[n].left;
+    records_[n].left = records_[left].right;
+    records_[left].right = n;
+    updateHeight(n);
+    updateHeight(left);
+    return left;
+}
+
+/**
+* Restores the AVL property at n, whose subtrees are balanced and differ in
+* height by at most two, and returns the root of the rebalanced subtree.
+*/
+template<class Key, class Value>
+uint64_t SharedAVLTree<Key, Value>::rebalance(uint64_t n)
+{
+    updateHeight(n);
+    Record& r = records_[n];
+    int balance = height(r.right) - height(r.left);
+    if (balance < -1) {
+        const Record& l = records_[r.left];
+        if (height(l.right) > height(l.left)) r.left = rotateLeft(r.left);
+        return rotateRight(n);
+    }
+    if (balance > 1) {
+        const Record& rr = records_[r.right];
+        if (height(rr.left) > height(rr.right)) r.right = rotateRight(r.right);
+        return rotateLeft(n);
+    }
+    return n;
+}
+
+template<class Key, class Value>
+uint64_t SharedAVLTree<Key, Value>::insertAt(uint64_t n, const Key& key, const Value& value)
+{
+    if (n == Nil) return allocate(key, value);
+    Record& r = records_[n];
+    if (key < r.first) r.left = insertAt(r.left, key, value);
+    else if (r.first < key) r.right = insertAt(r.right, key, value);
+    else {
+        std::memcpy(&r.second, &value, sizeof(Value));
+        return n;
+    }
+    return rebalance(n);
+}
+
+/**
+* Unlinks the smallest record below n into min and returns the new root.
+*/
+template<class Key, class Value>
+uint64_t SharedAVLTree<Key, Value>::removeMin(uint64_t n, uint64_t& min)
+{
+    Record& r = records_[n];
+    if (r.left == Nil) {
+        min = n;
+        return r.right;
+    }
+    r.left = removeMin(r.left, min);
+    return rebalance(n);
+}
+
+/*
+ * A record with two children is replaced by its successor, which is moved
+ * rather than copied so a reader never sees a key change in place.
+ */
+template<class Key, class Value>
+uint64_t SharedAVLTree<Key, Value>::removeAt(uint64_t n, const Key& key, bool& removed)
+{
+    if (n == Nil) return Nil;
+    Record& r = records_[n];
+    if (key < r.first) r.left = removeAt(r.left, key, removed);
+    else if (r.first < key) r.right = removeAt(r.right, key, removed);
+    else {
+        removed = true;
+        if (r.left == Nil || r.right == Nil) {
+            uint64_t child = r.left != Nil ? r.left : r.right;
+            release(n);
+            return child;
+        }
+        uint64_t min = Nil;
+        uint64_t right = removeMin(r.right, min);
+        records_[min].left = r.left;
+        records_[min].right = right;
+        release(n);
+        return rebalance(min);
+    }
+    return rebalance(n);
+}
+
+template<class Key, class Value>
+bool SharedAVLTree<Key, Value>::findLocked(const Key& key) const
+{
+    uint64_t temp = header_->root;
+    while (temp != Nil) {
+        const Record& r = records_[temp];
+        if (key < r.first) temp = r.left;
+        else if (r.first < key) temp = r.right;
+        else return true;
+    }
+    return false;
+}
+
+template<class Key, class Value>
+void SharedAVLTree<Key, Value>::insert(const std::pair<const Key, Value>& item)
+{
+    lock();
+    if (header_->freeList == Nil && header_->used == header_->capacity && !findLocked(item.first)) {
+        unlock();
+        throw std::runtime_error("SharedAVLTree: segment is full");
+    }
+    beginWrite();
+    header_->root = insertAt(header_->root, item.first, item.second);
+    endWrite();
+    unlock();
+}
+
+template<class Key, class Value>
+void SharedAVLTree<Key, Value>::remove(const Key& key)
+{
+    lock();
+    if (findLocked(key)) {
+        bool removed = false;
+        beginWrite();
+        header_->root = removeAt(header_->root, key, removed);
+        endWrite();
+    }
+    unlock();
+}
+
+/**
+* Walks the tree between two reads of the sequence counter and retries until
+* both reads agree and are even.
+*/
+template<class Key, class Value>
+bool SharedAVLTree<Key, Value>::find(const Key& key, Value& value) const
+{
+    while (true) {
+        uint64_t seq = header_->seq.load(std::memory_order_acquire);
+        if (seq & 1) {
+            sched_yield();
+            continue;
+        }
+
+        uint64_t capacity = header_->capacity;
+        uint64_t temp = header_->root;
+        bool found = false;
+        bool torn = false;
+        Value copy;
+        for (int depth = 0; temp != Nil; ++depth) {
+            if (temp >= capacity || depth == MaxDepth) {
+                torn = true;
+                break;
+            }
+            const Record& r = records_[temp];
+            if (key < r.first) temp = r.left;
+            else if (r.first < key) temp = r.right;
+            else {
+                std::memcpy(&copy, &r.second, sizeof(Value));
+                found = true;
+                break;
+            }
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (torn || header_->seq.load(std::memory_order_relaxed) != seq) continue;
+        if (found) value = copy;
+        return found;
+    }
+}
+
+template<class Key, class Value>
+bool SharedAVLTree<Key, Value>::contains(const Key& key) const
+{
+    Value ignored;
+    return find(key, ignored);
+}
+
+/**
+* Copies the whole tree out under the sequence counter, then calls f on the
+* copy, so a slow callback never holds up or is disturbed by writers.
+*/
+template<class Key, class Value>
+template<class F>
+void SharedAVLTree<Key, Value>::forEach(F f) const
+{
+    std::vector<std::pair<Key, Value> > items;
+    while (true) {
+        uint64_t seq = header_->seq.load(std::memory_order_acquire);
+        if (seq & 1) {
+            sched_yield();
+            continue;
+        }
+
+        items.clear();
+        uint64_t capacity = header_->capacity;
+        uint64_t stack[MaxDepth];
+        int depth = 0;
+        bool torn = false;
+        uint64_t temp = header_->root;
+        while ((temp != Nil || depth > 0) && !torn) {
+            if (temp != Nil) {
+                if (temp >= capacity || depth == MaxDepth || items.size() > capacity) {
+                    torn = true;
+                    break;
+                }
+                stack[depth++] = temp;
+                temp = records_[temp].left;
+            }
+            else {
+                const Record& r = records_[stack[--depth]];
+                items.push_back(std::make_pair(r.first, r.second));
+                temp = r.right;
+            }
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (!torn && header_->seq.load(std::memory_order_relaxed) == seq) break;
+    }
+    for (size_t i = 0; i < items.size(); ++i) f(items[i].first, items[i].second);
+}
+
+template<class Key, class Value>
+size_t SharedAVLTree<Key, Value>::size() const
+{
+    return header_ == NULL ? 0 : header_->count;
+}
+
+template<class Key, class Value>
+size_t SharedAVLTree<Key, Value>::capacity() const
+{
+    return header_ == NULL ? 0 : header_->capacity;
+}
+
+template<class Key, class Value>
+bool SharedAVLTree<Key, Value>::isBalanced() const
+{
+    lock();
+    bool ok = checkHelper(header_->root, NULL, NULL) >= 0;
+    unlock();
+    return ok;
+}
+
+/**
+* Returns the height of the subtree at n, or -1 if its stored heights, AVL
+* balance or key order (all keys strictly between lo and hi) are wrong.
+*/
+template<class Key, class Value>
+int SharedAVLTree<Key, Value>::checkHelper(uint64_t n, const Key* lo, const Key* hi) const
+{
+    if (n == Nil) return 0;
+    const Record& r = records_[n];
+    if ((lo != NULL && !(*lo < r.first)) || (hi != NULL && !(r.first < *hi))) return -1;
+    int left = checkHelper(r.left, lo, &r.first);
+    int right = checkHelper(r.right, &r.first, hi);
+    if (left < 0 || right < 0 || std::abs(left - right) > 1) return -1;
+    int h = std::max(left, right) + 1;
+    return h == r.height ? h : -1;
+}
+
+/*
+  -----------------------------------------------
+  End implementations for the SharedAVLTree class.
+  -----------------------------------------------
+*/
+
+#endif
@@ -0,0 +1,74 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdint>
+#include "avlbst.h"
+#include "bplustree.h"
+#include "frozen-index.h"
+#include "simd-search.h"
+
+using namespace std;
+
+template<class F>
+double nsPerCall(size_t calls, F f)
+{
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    f();
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / calls;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    size_t q = argc > 2 ? strtoul(argv[2], NULL, 10) : 2000000;
+    const char* names[] = { "scalar", "sse4.2", "avx2" };
+    simd::Level best = simd::detectLevel();
+
+    mt19937_64 rng(11);
+    vector<int64_t> keys(n);
+    for (size_t i = 0; i < n; ++i) keys[i] = (int64_t)(rng() >> 2);
+    vector<int64_t> probes(q);
+    for (size_t i = 0; i < q; ++i) probes[i] = keys[rng() % n];
+
+    AVLTree<int64_t,int64_t> avl;
+    BPlusTree<int64_t,int64_t> bp;
+    for (size_t i = 0; i < n; ++i) {
+        avl.insert(make_pair(keys[i], (int64_t)i));
+        bp.insert(make_pair(keys[i], (int64_t)i));
+    }
+    FrozenIndex<int64_t,int64_t> frozen(avl);
+
+    // in-node kernel: 32 sorted keys, one count per probe
+    vector<int64_t> node(keys.begin(), keys.begin() + 32);
+    sort(node.begin(), node.end());
+
+    int64_t sink = 0;
+    cout << n << " int64 keys, " << q << " probes, ns per lookup" << endl;
+    double avlNs = nsPerCall(q, [&]() {
+        for (size_t i = 0; i < q; ++i) sink += avl.find(probes[i])->second;
+    });
+    cout << setw(28) << "AVLTree internalFind" << setw(10) << fixed << setprecision(1) << avlNs << endl;
+
+    for (int level = simd::Scalar; level <= best; ++level) {
+        simd::setLevel((simd::Level)level);
+        double nodeNs = nsPerCall(q, [&]() {
+            for (size_t i = 0; i < q; ++i) sink += simd::countLess(&node[0], node.size(), probes[i]);
+        });
+        double frozenNs = nsPerCall(q, [&]() {
+            for (size_t i = 0; i < q; ++i) sink += *frozen.find(probes[i]);
+        });
+        double bpNs = nsPerCall(q, [&]() {
+            for (size_t i = 0; i < q; ++i) sink += bp.find(probes[i])->second;
+        });
+        cout << "[" << names[level] << "]" << endl;
+        cout << setw(28) << "32-key node count" << setw(10) << nodeNs << endl;
+        cout << setw(28) << "FrozenIndex find" << setw(10) << frozenNs << endl;
+        cout << setw(28) << "BPlusTree find" << setw(10) << bpNs << endl;
+    }
+    if (sink == 42) cout << "";
+    return 0;
+}
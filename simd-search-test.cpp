@@ -0,0 +1,64 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdint>
+#include "avlbst.h"
+#include "frozen-index.h"
+#include "simd-search.h"
+#include "test-util.h"
+
+using namespace std;
+
+// Compares simd::lowerBound/upperBound with std:: on sorted arrays of every
+// length up to 100, probing present, absent and out-of-range values.
+template<class T>
+bool agreesWithStd(T lo, T step)
+{
+    for (size_t n = 0; n <= 100; ++n) {
+        vector<T> keys;
+        for (size_t i = 0; i < n; ++i) keys.push_back((T)(lo + (T)(i / 2) * step));
+        const T* data = keys.empty() ? NULL : &keys[0];
+        for (long i = -2; i < (long)n + 2; ++i) {
+            T probe = (T)(lo + (T)(i / 2) * step);
+            size_t expectLo = lower_bound(keys.begin(), keys.end(), probe) - keys.begin();
+            size_t expectHi = upper_bound(keys.begin(), keys.end(), probe) - keys.begin();
+            if (simd::lowerBound(data, n, probe) != expectLo) return false;
+            if (simd::upperBound(data, n, probe) != expectHi) return false;
+        }
+    }
+    return true;
+}
+
+int main()
+{
+    const char* names[] = { "scalar", "sse4.2", "avx2" };
+    simd::Level best = simd::detectLevel();
+    cout << "cpu supports: " << names[best] << endl;
+
+    for (int level = simd::Scalar; level <= best; ++level) {
+        simd::setLevel((simd::Level)level);
+        string tag = string(names[level]) + ": ";
+        check(agreesWithStd<int32_t>(-40, 3), tag + "int32 bounds");
+        check(agreesWithStd<uint32_t>(0x7ffffff0u, 1), tag + "uint32 bounds across the sign bit");
+        check(agreesWithStd<int64_t>(-5000000000ll, 100000000ll), tag + "int64 bounds");
+        check(agreesWithStd<uint64_t>(0x7ffffffffffffff0ull, 1), tag + "uint64 bounds across the sign bit");
+        check(agreesWithStd<float>(-10.5f, 0.25f), tag + "float bounds");
+        check(agreesWithStd<double>(-1e9, 12.5), tag + "double bounds");
+        check(agreesWithStd<short>(-20, 1), tag + "short falls back to binary search");
+    }
+    simd::setLevel(best);
+
+    AVLTree<int,int> tree;
+    for (int i = 0; i < 1000; ++i) tree.insert(make_pair(i * 3, i));
+    FrozenIndex<int,int> frozen(tree);
+    bool found = frozen.size() == 1000;
+    for (int i = 0; i < 3000 && found; ++i) {
+        const int* v = frozen.find(i);
+        found = (i % 3 == 0) ? (v != NULL && *v == i / 3) : (v == NULL);
+    }
+    check(found, "FrozenIndex finds exactly the tree's keys");
+    check(frozen.lowerBound(4) == 2 && frozen.lowerBound(100000) == 1000, "FrozenIndex lowerBound");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,405 @@
+#ifndef SIMD_SEARCH_H
+#define SIMD_SEARCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_SEARCH_X86 1
+#include <immintrin.h>
+#endif
+
+/**
+* Vectorized search over sorted key arrays, for the multi-key and flat layouts
+* (BPlusTree nodes, FrozenIndex). For a sorted array, the number of keys less
+* than a probe is exactly its lower bound, and counting is something vector
+* units do 4 to 16 keys per instruction with no data-dependent branches.
+*
+* Kernels exist for 32- and 64-bit integers and for float and double. The
+* instruction set (AVX2, SSE4.2 or plain scalar code) is picked at runtime from
+* what the CPU reports; other key types use an ordinary binary search.
+*/
+namespace simd {
+
+enum Level { Scalar = 0, SSE42 = 1, AVX2 = 2 };
+
+// Lane type a key is searched as, or None for keys without a kernel.
+enum Lanes { None, I32, U32, I64, U64, F32, F64 };
+
+template <typename T>
+struct KeyLanes {
+    static const Lanes value =
+        std::is_same<T, float>::value ? F32 :
+        std::is_same<T, double>::value ? F64 :
+        !std::is_integral<T>::value || std::is_same<T, bool>::value ? None :
+        sizeof(T) == 4 ? (std::is_signed<T>::value ? I32 : U32) :
+        sizeof(T) == 8 ? (std::is_signed<T>::value ? I64 : U64) : None;
+};
+
+// Keys whose arrays are searched with the kernels below.
+template <typename T>
+struct HasKernel {
+    static const bool value = KeyLanes<T>::value != None;
+};
+
+// Arrays at most this long are counted outright; longer ones are narrowed
+// to a window of this size by binary search first.
+static const size_t SearchWindow = 32;
+
+inline Level detectLevel()
+{
+#ifdef SIMD_SEARCH_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return AVX2;
+    if (__builtin_cpu_supports("sse4.2")) return SSE42;
+#endif
+    return Scalar;
+}
+
+inline Level& levelSlot()
+{
+    static Level level = detectLevel();
+    return level;
+}
+
+// The kernel set in use.
+inline Level activeLevel()
+{
+    return levelSlot();
+}
+
+// Selects a kernel set, capped at what the CPU supports. Meant for
+// benchmarks and tests that compare kernels.
+inline void setLevel(Level level)
+{
+    Level best = detectLevel();
+    levelSlot() = level < best ? level : best;
+}
+
+/*
+  -------------------------------
+  Scalar kernels (the fallback).
+  -------------------------------
+*/
+
+template <typename T>
+inline size_t countLessScalar(const T* keys, size_t n, T probe)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i) count += (keys[i] < probe);
+    return count;
+}
+
+template <typename T>
+inline size_t countLessEqualScalar(const T* keys, size_t n, T probe)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i) count += !(probe < keys[i]);
+    return count;
+}
+
+#ifdef SIMD_SEARCH_X86
+
+/*
+  ---------------------------------------------------------------
+  AVX2 kernels: 16 x 32-bit or 8 x 64-bit keys per loop iteration.
+  The "greater" flag picks between counting keys < probe (false)
+  and keys > probe (true).
+  ---------------------------------------------------------------
+*/
+
+__attribute__((target("avx2")))
+inline size_t countAVX2(const int32_t* keys, size_t n, int32_t probe, bool greater, uint32_t bias)
+{
+    const __m256i p = _mm256_set1_epi32((int32_t)((uint32_t)probe ^ bias));
+    const __m256i b = _mm256_set1_epi32((int32_t)bias);
+    size_t count = 0, i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i k0 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(keys + i)), b);
+        __m256i k1 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(keys + i + 8)), b);
+        __m256i c0 = greater ? _mm256_cmpgt_epi32(k0, p) : _mm256_cmpgt_epi32(p, k0);
+        __m256i c1 = greater ? _mm256_cmpgt_epi32(k1, p) : _mm256_cmpgt_epi32(p, k1);
+        count += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(c0)));
+        count += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(c1)));
+    }
+    for (; i < n; ++i) {
+        int32_t k = (int32_t)((uint32_t)keys[i] ^ bias), q = (int32_t)((uint32_t)probe ^ bias);
+        count += greater ? (k > q) : (k < q);
+    }
+    return count;
+}
+
+__attribute__((target("avx2")))
+inline size_t countAVX2(const int64_t* keys, size_t n, int64_t probe, bool greater, uint64_t bias)
+{
+    const __m256i p = _mm256_set1_epi64x((int64_t)((uint64_t)probe ^ bias));
+    const __m256i b = _mm256_set1_epi64x((int64_t)bias);
+    size_t count = 0, i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i k0 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(keys + i)), b);
+        __m256i k1 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(keys + i + 4)), b);
+        __m256i c0 = greater ? _mm256_cmpgt_epi64(k0, p) : _mm256_cmpgt_epi64(p, k0);
+        __m256i c1 = greater ? _mm256_cmpgt_epi64(k1, p) : _mm256_cmpgt_epi64(p, k1);
+        count += __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(c0)));
+        count += __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(c1)));
+    }
+    for (; i < n; ++i) {
+        int64_t k = (int64_t)((uint64_t)keys[i] ^ bias), q = (int64_t)((uint64_t)probe ^ bias);
+        count += greater ? (k > q) : (k < q);
+    }
+    return count;
+}
+
+__attribute__((target("avx2")))
+inline size_t countAVX2(const float* keys, size_t n, float probe, bool greater)
+{
+    const __m256 p = _mm256_set1_ps(probe);
+    size_t count = 0, i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256 k0 = _mm256_loadu_ps(keys + i);
+        __m256 k1 = _mm256_loadu_ps(keys + i + 8);
+        __m256 c0 = greater ? _mm256_cmp_ps(k0, p, _CMP_GT_OQ) : _mm256_cmp_ps(k0, p, _CMP_LT_OQ);
+        __m256 c1 = greater ? _mm256_cmp_ps(k1, p, _CMP_GT_OQ) : _mm256_cmp_ps(k1, p, _CMP_LT_OQ);
+        count += __builtin_popcount(_mm256_movemask_ps(c0));
+        count += __builtin_popcount(_mm256_movemask_ps(c1));
+    }
+    for (; i < n; ++i) count += greater ? (keys[i] > probe) : (keys[i] < probe);
+    return count;
+}
+
+__attribute__((target("avx2")))
+inline size_t countAVX2(const double* keys, size_t n, double probe, bool greater)
+{
+    const __m256d p = _mm256_set1_pd(probe);
+    size_t count = 0, i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256d k0 = _mm256_loadu_pd(keys + i);
+        __m256d k1 = _mm256_loadu_pd(keys + i + 4);
+        __m256d c0 = greater ? _mm256_cmp_pd(k0, p, _CMP_GT_OQ) : _mm256_cmp_pd(k0, p, _CMP_LT_OQ);
+        __m256d c1 = greater ? _mm256_cmp_pd(k1, p, _CMP_GT_OQ) : _mm256_cmp_pd(k1, p, _CMP_LT_OQ);
+        count += __builtin_popcount(_mm256_movemask_pd(c0));
+        count += __builtin_popcount(_mm256_movemask_pd(c1));
+    }
+    for (; i < n; ++i) count += greater ? (keys[i] > probe) : (keys[i] < probe);
+    return count;
+}
+
+/*
+  -----------------------------------------------------------------
+  SSE4.2 kernels: 8 x 32-bit or 4 x 64-bit keys per loop iteration.
+  -----------------------------------------------------------------
+*/
+
+__attribute__((target("sse4.2")))
+inline size_t countSSE42(const int32_t* keys, size_t n, int32_t probe, bool greater, uint32_t bias)
+{
+    const __m128i p = _mm_set1_epi32((int32_t)((uint32_t)probe ^ bias));
+    const __m128i b = _mm_set1_epi32((int32_t)bias);
+    size_t count = 0, i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i k0 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(keys + i)), b);
+        __m128i k1 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(keys + i + 4)), b);
+        __m128i c0 = greater ? _mm_cmpgt_epi32(k0, p) : _mm_cmpgt_epi32(p, k0);
+        __m128i c1 = greater ? _mm_cmpgt_epi32(k1, p) : _mm_cmpgt_epi32(p, k1);
+        count += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(c0)));
+        count += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(c1)));
+    }
+    for (; i < n; ++i) {
+        int32_t k = (int32_t)((uint32_t)keys[i] ^ bias), q = (int32_t)((uint32_t)probe ^ bias);
+        count += greater ? (k > q) : (k < q);
+    }
+    return count;
+}
+
+__attribute__((target("sse4.2")))
+inline size_t countSSE42(const int64_t* keys, size_t n, int64_t probe, bool greater, uint64_t bias)
+{
+    const __m128i p = _mm_set1_epi64x((int64_t)((uint64_t)probe ^ bias));
+    const __m128i b = _mm_set1_epi64x((int64_t)bias);
+    size_t count = 0, i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i k0 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(keys + i)), b);
+        __m128i k1 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(keys + i + 2)), b);
+        __m128i c0 = greater ? _mm_cmpgt_epi64(k0, p) : _mm_cmpgt_epi64(p, k0);
+        __m128i c1 = greater ? _mm_cmpgt_epi64(k1, p) : _mm_cmpgt_epi64(p, k1);
+        count += __builtin_popcount(_mm_movemask_pd(_mm_castsi128_pd(c0)));
+        count += __builtin_popcount(_mm_movemask_pd(_mm_castsi128_pd(c1)));
+    }
+    for (; i < n; ++i) {
+        int64_t k = (int64_t)((uint64_t)keys[i] ^ bias), q = (int64_t)((uint64_t)probe ^ bias);
+        count += greater ? (k > q) : (k < q);
+    }
+    return count;
+}
+
+__attribute__((target("sse4.2")))
+inline size_t countSSE42(const float* keys, size_t n, float probe, bool greater)
+{
+    const __m128 p = _mm_set1_ps(probe);
+    size_t count = 0, i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128 k0 = _mm_loadu_ps(keys + i);
+        __m128 k1 = _mm_loadu_ps(keys + i + 4);
+        __m128 c0 = greater ? _mm_cmpgt_ps(k0, p) : _mm_cmplt_ps(k0, p);
+        __m128 c1 = greater ? _mm_cmpgt_ps(k1, p) : _mm_cmplt_ps(k1, p);
+        count += __builtin_popcount(_mm_movemask_ps(c0));
+        count += __builtin_popcount(_mm_movemask_ps(c1));
+    }
+    for (; i < n; ++i) count += greater ? (keys[i] > probe) : (keys[i] < probe);
+    return count;
+}
+
+__attribute__((target("sse4.2")))
+inline size_t countSSE42(const double* keys, size_t n, double probe, bool greater)
+{
+    const __m128d p = _mm_set1_pd(probe);
+    size_t count = 0, i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128d k0 = _mm_loadu_pd(keys + i);
+        __m128d k1 = _mm_loadu_pd(keys + i + 2);
+        __m128d c0 = greater ? _mm_cmpgt_pd(k0, p) : _mm_cmplt_pd(k0, p);
+        __m128d c1 = greater ? _mm_cmpgt_pd(k1, p) : _mm_cmplt_pd(k1, p);
+        count += __builtin_popcount(_mm_movemask_pd(c0));
+        count += __builtin_popcount(_mm_movemask_pd(c1));
+    }
+    for (; i < n; ++i) count += greater ? (keys[i] > probe) : (keys[i] < probe);
+    return count;
+}
+
+#endif // SIMD_SEARCH_X86
+
+/*
+  -----------------------------------------------------------------
+  Dispatch. Each lane kind forwards to the widest kernel available;
+  unsigned keys reuse the signed kernels with the sign bit flipped.
+  -----------------------------------------------------------------
+*/
+
+template <typename T, Lanes L = KeyLanes<T>::value>
+struct Counter {
+    static size_t count(const T* keys, size_t n, const T& probe, bool greater)
+    {
+        return greater ? n - countLessEqualScalar(keys, n, probe) : countLessScalar(keys, n, probe);
+    }
+};
+
+template <typename T, typename Lane, typename Bits, Bits Bias>
+struct IntegerCounter {
+    static size_t count(const T* keys, size_t n, const T& probe, bool greater)
+    {
+        const Lane* lanes = reinterpret_cast<const Lane*>(keys);
+        Lane q = (Lane)probe;
+#ifdef SIMD_SEARCH_X86
+        if (activeLevel() == AVX2) return countAVX2(lanes, n, q, greater, Bias);
+        if (activeLevel() == SSE42) return countSSE42(lanes, n, q, greater, Bias);
+#endif
+        return Counter<T, None>::count(keys, n, probe, greater);
+    }
+};
+
+template <typename T>
+struct Counter<T, I32> : IntegerCounter<T, int32_t, uint32_t, 0u> { };
+template <typename T>
+struct Counter<T, U32> : IntegerCounter<T, int32_t, uint32_t, 0x80000000u> { };
+template <typename T>
+struct Counter<T, I64> : IntegerCounter<T, int64_t, uint64_t, 0ull> { };
+template <typename T>
+struct Counter<T, U64> : IntegerCounter<T, int64_t, uint64_t, 0x8000000000000000ull> { };
+
+template <typename T>
+struct FloatCounter {
+    static size_t count(const T* keys, size_t n, const T& probe, bool greater)
+    {
+#ifdef SIMD_SEARCH_X86
+        if (activeLevel() == AVX2) return countAVX2(keys, n, probe, greater);
+        if (activeLevel() == SSE42) return countSSE42(keys, n, probe, greater);
+#endif
+        return Counter<T, None>::count(keys, n, probe, greater);
+    }
+};
+
+template <typename T>
+struct Counter<T, F32> : FloatCounter<T> { };
+template <typename T>
+struct Counter<T, F64> : FloatCounter<T> { };
+
+// Number of keys in keys[0, n) less than probe.
+template <typename T>
+inline size_t countLess(const T* keys, size_t n, const T& probe)
+{
+    return Counter<T>::count(keys, n, probe, false);
+}
+
+// Number of keys in keys[0, n) less than or equal to probe.
+template <typename T>
+inline size_t countLessEqual(const T* keys, size_t n, const T& probe)
+{
+    return n - Counter<T>::count(keys, n, probe, true);
+}
+
+template <typename T>
+inline size_t lowerBound(const T* keys, size_t n, const T& probe, std::true_type)
+{
+    size_t lo = 0, hi = n;
+    while (hi - lo > SearchWindow) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (keys[mid] < probe) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo + countLess(keys + lo, hi - lo, probe);
+}
+
+template <typename T>
+inline size_t lowerBound(const T* keys, size_t n, const T& probe, std::false_type)
+{
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (keys[mid] < probe) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+template <typename T>
+inline size_t upperBound(const T* keys, size_t n, const T& probe, std::true_type)
+{
+    size_t lo = 0, hi = n;
+    while (hi - lo > SearchWindow) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (probe < keys[mid]) hi = mid;
+        else lo = mid + 1;
+    }
+    return lo + countLessEqual(keys + lo, hi - lo, probe);
+}
+
+template <typename T>
+inline size_t upperBound(const T* keys, size_t n, const T& probe, std::false_type)
+{
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (probe < keys[mid]) hi = mid;
+        else lo = mid + 1;
+    }
+    return lo;
+}
+
+// Position of the first key in the sorted array keys[0, n) not less than probe.
+template <typename T>
+inline size_t lowerBound(const T* keys, size_t n, const T& probe)
+{
+    return lowerBound(keys, n, probe, std::integral_constant<bool, HasKernel<T>::value>());
+}
+
+// Position of the first key in the sorted array keys[0, n) greater than probe.
+template <typename T>
+inline size_t upperBound(const T* keys, size_t n, const T& probe)
+{
+    return upperBound(keys, n, probe, std::integral_constant<bool, HasKernel<T>::value>());
+}
+
+} // namespace simd
+
+#endif
@@ -0,0 +1,75 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <new>
+#include "small-map.h"
+
+using namespace std;
+
+// Every heap byte, so the two layouts can be compared by footprint.
+static size_t heapBytes = 0;
+
+void* operator new(size_t n)
+{
+    heapBytes += n;
+    void* p = malloc(n);
+    if (p == NULL) throw bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+double msSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// Many maps of a few entries each, held as AVLTrees and as SmallAVLMaps:
+// heap bytes per map after filling them (the map objects included), then
+// random lookups across all.
+template<class Map>
+void run(const char* name, size_t maps, size_t entries, size_t lookups)
+{
+    mt19937_64 rng(43);
+    size_t before = heapBytes;
+    vector<Map*> all(maps);
+    for (size_t m = 0; m < maps; ++m) {
+        all[m] = new Map;
+        for (size_t e = 0; e < entries; ++e) all[m]->insert(make_pair((long long)(rng() % 1000), (int)e));
+    }
+    double bytes = (double)(heapBytes - before) / maps;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    size_t hits = 0;
+    for (size_t i = 0; i < lookups; ++i) {
+        Map* m = all[rng() % maps];
+        hits += m->find((long long)(rng() % 1000)) != m->end();
+    }
+    double ms = msSince(start);
+    for (size_t m = 0; m < maps; ++m) delete all[m];
+
+    cout << fixed << setprecision(1);
+    cout << name << setw(7) << bytes << " bytes/map, " << setw(7) << ms << " ms for lookups (" << hits << " hits)" << endl;
+}
+
+// Fills of 1, 2, 4, 8 and 16 entries, or just the one given.
+int main(int argc, char* argv[])
+{
+    size_t maps = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    size_t only = argc > 2 ? strtoul(argv[2], NULL, 10) : 0;
+    size_t lookups = argc > 3 ? strtoul(argv[3], NULL, 10) : 2000000;
+
+    cout << maps << " maps, " << lookups << " lookups per fill" << endl;
+    for (size_t entries = only != 0 ? only : 1; entries <= (only != 0 ? only : 16); entries *= 2) {
+        cout << "up to " << entries << " entries:" << endl;
+        run<AVLTree<long long,int> >("  AVLTree:      ", maps, entries, lookups);
+        run<SmallAVLMap<long long,int> >("  SmallAVLMap:  ", maps, entries, lookups);
+    }
+    return 0;
+}
@@ -0,0 +1,109 @@
+#include <iostream>
+#include <map>
+#include <string>
+#include <cstdlib>
+#include <stdexcept>
+#include "small-map.h"
+#include "test-util.h"
+
+using namespace std;
+
+template<class Map, class Ref>
+bool sameContents(const Map& m, const Ref& ref)
+{
+    if (m.size() != ref.size()) return false;
+    typename Ref::const_iterator r = ref.begin();
+    for (typename Map::iterator it = m.begin(); it != m.end(); ++it, ++r) {
+        if (r == ref.end() || it->first != r->first || it->second != r->second) return false;
+    }
+    return r == ref.end();
+}
+
+int main()
+{
+    SmallAVLMap<int,int,8> small;
+    check(small.empty() && small.isSmall() && small.begin() == small.end(), "starts empty and small");
+    for (int i = 8; i > 0; --i) small.insert(make_pair(i * 10, i));
+    map<int,int> ref;
+    for (int i = 1; i <= 8; ++i) ref[i * 10] = i;
+    check(small.isSmall() && sameContents(small, ref), "fills the inline array in key order");
+    small.insert(make_pair(40, 400));
+    ref[40] = 400;
+    check(small.isSmall() && small[40] == 400 && small.size() == 8, "overwriting does not grow");
+
+    small.insert(make_pair(45, 45));
+    ref[45] = 45;
+    check(!small.isSmall() && sameContents(small, ref) && small.find(45)->second == 45, "promotes past the threshold");
+
+    for (int i = 1; i <= 5; ++i) {
+        small.remove(i * 10);
+        ref.erase(i * 10);
+    }
+    check(small.isSmall() && sameContents(small, ref), "demotes at half the threshold");
+
+    bool threw = false;
+    try {
+        small[12345];
+    }
+    catch (const out_of_range&) {
+        threw = true;
+    }
+    check(threw && small.find(12345) == small.end(), "missing keys");
+
+    // random operations across both representations
+    srand(43);
+    SmallAVLMap<long long,int,16> mixed;
+    map<long long,int> mixedRef;
+    bool agree = true;
+    bool sawBoth[2] = { false, false };
+    for (int step = 0; step < 30000; ++step) {
+        long long key = rand() % 40;
+        if (rand() % 2 == 0) {
+            mixed.remove(key);
+            mixedRef.erase(key);
+        }
+        else {
+            mixed.insert(make_pair(key, step));
+            mixedRef[key] = step;
+        }
+        sawBoth[mixed.isSmall()] = true;
+        long long probe = rand() % 40;
+        map<long long,int>::iterator expect = mixedRef.find(probe);
+        SmallAVLMap<long long,int,16>::iterator got = mixed.find(probe);
+        agree = agree && (expect == mixedRef.end() ? got == mixed.end() : got != mixed.end() && got->second == expect->second);
+        if (step % 100 == 0) agree = agree && sameContents(mixed, mixedRef);
+    }
+    check(agree && sawBoth[0] && sawBoth[1], "random operations match std::map");
+
+    // the default capacity is smaller than a tree with one entry, and
+    // values can be written through the iterator in either representation
+    check(sizeof(SmallAVLMap<long long,int>) < sizeof(AVLTree<long long,int>) + sizeof(AVLNode<long long,int>),
+        "the default map is smaller than a one-entry tree");
+    SmallAVLMap<long long,int> writable;
+    bool written = true;
+    for (int round = 0; round < 2; ++round) {
+        for (long long k = 0; k < (round == 0 ? 3 : 12); ++k) writable.insert(make_pair(k, 0));
+        for (SmallAVLMap<long long,int>::iterator it = writable.begin(); it != writable.end(); ++it) {
+            it->second = (int)it->first * 2;
+        }
+        for (long long k = 0; k < (round == 0 ? 3 : 12); ++k) written = written && writable[k] == k * 2;
+        written = written && writable.isSmall() == (round == 0);
+    }
+    check(written, "writes through the iterator reach the stored values");
+
+    // keys without a simd kernel use a binary search
+    SmallAVLMap<string,int,4> names;
+    map<string,int> nameRef;
+    const char* words[] = { "pear", "apple", "fig", "kiwi", "date", "lime", "plum" };
+    for (int i = 0; i < 7; ++i) {
+        names.insert(make_pair(string(words[i]), i));
+        nameRef[words[i]] = i;
+    }
+    names.remove("fig");
+    nameRef.erase("fig");
+    check(sameContents(names, nameRef) && !names.isSmall() && names["kiwi"] == 3, "string keys");
+    names.clear();
+    check(names.empty() && names.isSmall(), "clear returns to small");
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,452 @@
+#ifndef SMALL_MAP_H
+#define SMALL_MAP_H
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <stdexcept>
+#include <type_traits>
+#include "avlbst.h"
+#include "simd-search.h"
+
+/**
+* An ordered map that stays a sorted inline array while it is small and
+* becomes an AVLTree once it outgrows the array.
+*
+* Up to InlineCapacity entries live inside the map object itself: a key
+* array, searched by counting with the simd kernels (or a binary search for
+* other key types), next to a value array. Each key is stored once, and
+* there is no heap allocation, no node and no links. The insert that would
+* overflow the arrays moves everything into an AVLTree built with bulkLoad,
+* and the tree object takes over the same inline storage, so a promoted map
+* costs one AVLTree plus its nodes and a size. Removes that bring a promoted
+* map down to half the capacity move it back, so a map that bounces around
+* the threshold does not rebuild on every operation.
+*
+* The default capacity keeps the object smaller than an AVLTree holding a
+* single entry for word-sized keys and values: for <long long, int> it is
+* 56 bytes against 96.
+*
+* Since keys and values are kept apart, the iterator yields a pair of
+* references rather than a reference to a stored pair; it->first and
+* it->second work as for the other containers. Iterators and references are
+* invalidated by any insert or remove while the map is small, and by
+* promotion or demotion.
+*/
+template <typename Key, typename Value, size_t InlineCapacity = 4>
+class SmallAVLMap
+{
+public:
+    typedef std::pair<const Key, Value> Item;
+    typedef std::pair<const Key&, Value&> ItemRef;
+    typedef AVLTree<Key, Value> Tree;
+
+    SmallAVLMap();
+    ~SmallAVLMap();
+
+    void insert(const Item& keyValuePair);
+    void remove(const Key& key);
+    void clear();
+    bool empty() const;
+    size_t size() const;
+    // true while the entries are in the inline array
+    bool isSmall() const;
+
+    /**
+    * An in-order iterator over either representation.
+    */
+    class iterator
+    {
+    public:
+        // Holds the ItemRef that operator-> points into.
+        struct Arrow {
+            ItemRef ref;
+            ItemRef* operator->() { return &ref; }
+        };
+
+        iterator();
+
+        ItemRef operator*() const;
+        Arrow operator->() const;
+
+        bool operator==(const iterator& rhs) const;
+        bool operator!=(const iterator& rhs) const;
+
+        iterator& operator++();
+
+    protected:
+        friend class SmallAVLMap<Key, Value, InlineCapacity>;
+        iterator(const SmallAVLMap* map, size_t index, typename Tree::iterator treeIt);
+
+        const SmallAVLMap* map_;
+        size_t index_;                       // position in the inline array
+        typename Tree::iterator treeIt_;     // position once promoted
+    };
+
+    iterator begin() const;
+    iterator end() const;
+    iterator find(const Key& key) const;
+    Value& operator[](const Key& key);
+    Value const & operator[](const Key& key) const;
+
+protected:
+    struct Inline {
+        typename std::aligned_storage<sizeof(Key), alignof(Key)>::type keys[InlineCapacity];
+        typename std::aligned_storage<sizeof(Value), alignof(Value)>::type values[InlineCapacity];
+    };
+
+    // the inline arrays while small, the tree once promoted
+    typedef typename std::aligned_storage<(sizeof(Inline) > sizeof(Tree) ? sizeof(Inline) : sizeof(Tree)),
+        (alignof(Inline) > alignof(Tree) ? alignof(Inline) : alignof(Tree))>::type Storage;
+
+    // Up to InlineCapacity + 1 entries in key order, held on the stack while
+    // the storage switches representation.
+    struct Spill {
+        typedef std::pair<Key, Value> Entry;
+        typename std::aligned_storage<sizeof(Entry), alignof(Entry)>::type items[InlineCapacity + 1];
+        size_t count;
+
+        Spill() : count(0) { }
+        ~Spill() { for (size_t i = 0; i < count; ++i) at(i).~Entry(); }
+        Entry& at(size_t i) { return *reinterpret_cast<Entry*>(&items[i]); }
+        void push(const Key& key, const Value& value) { new (&items[count]) Entry(key, value); ++count; }
+        Entry* begin() { return &at(0); }
+        Entry* end() { return &at(0) + count; }
+    };
+
+    Inline* arrays() const;
+    Key* keys() const;
+    Value* value(size_t i) const;
+    Tree* tree() const;
+    size_t lowerBound(const Key& key) const;
+    void insertAt(size_t pos, const Key& key, const Value& value);
+    void eraseAt(size_t pos);
+    void destroyInline();
+    void promote(size_t pos, const Key& key, const Value& value);
+    void demote();
+
+    Storage storage_;
+    size_t count_ : sizeof(size_t) * 8 - 1;
+    size_t promoted_ : 1;
+
+private:
+    SmallAVLMap(const SmallAVLMap&);
+    SmallAVLMap& operator=(const SmallAVLMap&);
+};
+
+/*
+  ----------------------------------------------------------
+  Begin implementations for the SmallAVLMap::iterator class.
+  ----------------------------------------------------------
+*/
+
+template<class Key, class Value, size_t InlineCapacity>
+SmallAVLMap<Key, Value, InlineCapacity>::iterator::iterator() :
+    map_(NULL), index_(0), treeIt_()
+{
+
+}
+
+template<class Key, class Value, size_t InlineCapacity>
+SmallAVLMap<Key, Value, InlineCapacity>::iterator::iterator(const SmallAVLMap* map, size_t index,
+    typename Tree::iterator treeIt) :
+    map_(map), index_(index), treeIt_(treeIt)
+{
+
+}
+
+template<class Key, class Value, size_t InlineCapacity>
+typename SmallAVLMap<Key, Value, InlineCapacity>::ItemRef SmallAVLMap<Key, Value, InlineCapacity>::iterator::operator*() const
+{
+    if (map_->promoted_) return ItemRef(treeIt_->first, treeIt_->second);
+    return ItemRef(map_->keys()[index_], *map_->value(index_));
+}
+
+template<class Key, class Value, size_t InlineCapacity>
+typename SmallAVLMap<Key, Value, InlineCapacity>::iterator::Arrow SmallAVLMap<Key, Value, InlineCapacity>::iterator::operator->() const
+{
+    Arrow arrow = { this->operator*() };
+    return arrow;
+}
+
+template<class Key, class Value, size_t InlineCapacity>
+bool SmallAVLMap<Key, Value, InlineCapacity>::iterator::operator==(const iterator& rhs) const
+{
+    return map_ == rhs.map_ && index_ == rhs.index_ && treeIt_ == rhs.treeIt_;
+}
+
+template<class Key, class Value, size_t InlineCapacity>
+bool SmallAVLMap<Key, Value, InlineCapacity>::iterator::operator!=(const iterator& rhs) const
+{
+    return !(*this == rhs);
+}
+
+template<class Key, class Value, size_t InlineCapacity>
+typename SmallAVLMap<Key, Value, InlineCapacity>::iterator& SmallAVLMap<Key, Value, InlineCapacity>::iterator::operator++()
+{
+    if (map_->promoted_) ++treeIt_;
+    else ++index_;
+    return *this;
+}
+
+/*
+  --------------------------------------------------------
+  End implementations for the SmallAVLMap::iterator class.
+  --------------------------------------------------------
+*/
+
+/*
+  -------------------------------------------------
+  Begin implementations for the SmallAVLMap class.
+  -------------------------------------------------
+*/
+
+template<class Key, class Value, size_t InlineCapacity>
+SmallAVLMap<Key, Value, InlineCapacity>::SmallAVLMap() :
+    count_(0), promoted_(0)
+{
+
+}
+
+template<class Key, class Value, size_t InlineCapacity>
+SmallAVLMap<Key, Value, InlineCapacity>::~SmallAVLMap()
+{
+    clear();
+}
+
+template<class Key, class Value, size_t InlineCapacity>
+typename SmallAVLMap<Key, Value, InlineCapacity>::Inline* SmallAVLMap<Key, Value, InlineCapacity>::arrays() const
+{
+    return reinterpret_cast<Inline*>(const_cast<Storage*>(&storage_));
+}
+
+template<class Key, class Value, size_t InlineCapacity>
+Key* SmallAVLMap<Key, Value, InlineCapacity>::keys() const
+{
+    return reinterpret_cast<Key*>(arrays()->keys);
+}
+
+template<class Key, class Value, size_t InlineCapacity>
+Value* SmallAVLMap<Key, Value, InlineCapacity>::value(size_t i) const
+{
+    return reinterpret_cast<Value*>(&arrays()->values[i]);
+}
+
+template<class Key, class Value, size_t InlineCapacity>
+typename SmallAVLMap<Key, Value, InlineCapacity>::Tree* SmallAVLMap<Key, Value, InlineCapacity>::tree() const
+{
+    return reinterpret_cast<Tree*>(const_cast<Storage*>(&storage_));
+}
+
+/**
+* The inline array is at most InlineCapacity keys, which the simd kernels
+* count outright rather than bisect.
+*/
+template<class Key, class Value, size_t InlineCapacity>
+size_t SmallAVLMap<Key, Value, InlineCapacity>::lowerBound(const Key& key) const
+{
+    return simd::lowerBound(keys(), count_, key);
+}
+
+/**
+* Shifts entries right by one from pos and constructs the new one there.
+*/
+template<class Key, class Value, size_t InlineCapacity>
+void SmallAVLMap<Key, Value, InlineCapacity>::insertAt(size_t pos, const Key& key, const Value& val)
+{
+    Key* k = keys();
+    for (size_t i = count_; i > pos; --i) {
+        new (&k[i]) Key(k[i - 1]);
+        k[i - 1].~Key();
+        new (value(i)) Value(*value(i - 1));
+        value(i - 1)->~Value();
+    }
+    new (&k[pos]) Key(key);
+    new (value(pos)) Value(val);
+    ++count_;
+}
+
+/**
+* Destroys the entry at pos and shifts the rest left by one.
+*/
+template<class Key, class Value, size_t InlineCapacity>
+void SmallAVLMap<Key, Value, InlineCapacity>::eraseAt(size_t pos)
+{
+    Key* k = keys();
+    k[pos].~Key();
+    value(pos)->~Value();
+    for (size_t i = pos + 1; i < count_; ++i) {
+        new (&k[i - 1]) Key(k[i]);
+        k[i].~Key();
+        new (value(i - 1)) Value(*value(i));
+        value(i)->~Value();
+    }
+    --count_;
+}
+
+template<class Key, class Value, size_t InlineCapacity>
+void SmallAVLMap<Key, Value, InlineCapacity>::destroyInline()
+{
+    Key* k = keys();
+    for (size_t i = 0; i < count_; ++i) {
+        k[i].~Key();
+        value(i)->~Value();
+    }
+}
+
+/**
+* Builds the tree from the full array plus the new entry at pos, already in
+* key order, so bulkLoad can do it in O(n) without rotations. The tree
+* takes the arrays' storage, so the entries are copied out to the stack
+* first; if the build fails they go back.
+*/
+template<class Key, class Value, size_t InlineCapacity>
+void SmallAVLMap<Key, Value, InlineCapacity>::promote(size_t pos, const Key& key, const Value& val)
+{
+    Spill sorted;
+    for (size_t i = 0; i < count_; ++i) {
+        if (i == pos) sorted.push(key, val);
+        sorted.push(keys()[i], *value(i));
+    }
+    if (pos == count_) sorted.push(key, val);
+
+    size_t count = count_;
+    destroyInline();
+    Tree* t = new (&storage_) Tree;
+    try {
+        t->bulkLoad(sorted.begin(), sorted.end());
+    }
+    catch (...) {
+        t->~Tree();
+        count_ = 0;
+        for (size_t i = 0; i <= count; ++i) {
+            if (i != pos) insertAt(count_, sorted.at(i).first, sorted.at(i).second);
+        }
+        throw;
+    }
+    promoted_ = 1;
+    count_ = count + 1;
+}
+
+template<class Key, class Value, size_t InlineCapacity>
+void SmallAVLMap<Key, Value, InlineCapacity>::demote()
+{
+    Spill sorted;
+    for (typename Tree::iterator it = tree()->begin(); it != tree()->end(); ++it) {
+        sorted.push(it->first, it->second);
+    }
+    tree()->~Tree();
+    promoted_ = 0;
+    count_ = 0;
+    for (size_t i = 0; i < sorted.count; ++i) insertAt(i, sorted.at(i).first, sorted.at(i).second);
+}
+
+template<class Key, class Value, size_t InlineCapacity>
+void SmallAVLMap<Key, Value, InlineCapacity>::insert(const Item& keyValuePair)
+{
+    if (promoted_) {
+        std::pair<typename Tree::iterator, bool> result = tree()->tryInsert(keyValuePair);
+        if (result.second) ++count_;
+        else result.first->second = keyValuePair.second;
+        return;
+    }
+    size_t pos = lowerBound(keyValuePair.first);
+    if (pos < count_ && !(keyValuePair.first < keys()[pos])) {
+        *value(pos) = keyValuePair.second;
+        return;
+    }
+    if (count_ < InlineCapacity) insertAt(pos, keyValuePair.first, keyValuePair.second);
+    else promote(pos, keyValuePair.first, keyValuePair.second);
+}
+
+template<class Key, class Value, size_t InlineCapacity>
+void SmallAVLMap<Key, Value, InlineCapacity>::remove(const Key& key)
+{
+    if (promoted_) {
+        //an empty handle means key was absent; a full one frees its node here
+        if (tree()->extract(key).empty()) return;
+        --count_;
+        if (count_ <= InlineCapacity / 2) demote();
+        return;
+    }
+    size_t pos = lowerBound(key);
+    if (pos < count_ && !(key < keys()[pos])) eraseAt(pos);
+}
+
+template<class Key, class Value, size_t InlineCapacity>
+void SmallAVLMap<Key, Value, InlineCapacity>::clear()
+{
+    if (promoted_) {
+        tree()->~Tree();
+        promoted_ = 0;
+    }
+    else {
+        destroyInline();
+    }
+    count_ = 0;
+}
+
+template<class Key, class Value, size_t InlineCapacity>
+bool SmallAVLMap<Key, Value, InlineCapacity>::empty() const
+{
+    return count_ == 0;
+}
+
+template<class Key, class Value, size_t InlineCapacity>
+size_t SmallAVLMap<Key, Value, InlineCapacity>::size() const
+{
+    return count_;
+}
+
+template<class Key, class Value, size_t InlineCapacity>
+bool SmallAVLMap<Key, Value, InlineCapacity>::isSmall() const
+{
+    return !promoted_;
+}
+
+template<class Key, class Value, size_t InlineCapacity>
+typename SmallAVLMap<Key, Value, InlineCapacity>::iterator SmallAVLMap<Key, Value, InlineCapacity>::begin() const
+{
+    if (promoted_) return iterator(this, 0, tree()->begin());
+    return iterator(this, 0, typename Tree::iterator());
+}
+
+template<class Key, class Value, size_t InlineCapacity>
+typename SmallAVLMap<Key, Value, InlineCapacity>::iterator SmallAVLMap<Key, Value, InlineCapacity>::end() const
+{
+    if (promoted_) return iterator(this, 0, tree()->end());
+    return iterator(this, count_, typename Tree::iterator());
+}
+
+template<class Key, class Value, size_t InlineCapacity>
+typename SmallAVLMap<Key, Value, InlineCapacity>::iterator SmallAVLMap<Key, Value, InlineCapacity>::find(const Key& key) const
+{
+    if (promoted_) return iterator(this, 0, tree()->find(key));
+    size_t pos = lowerBound(key);
+    if (pos < count_ && !(key < keys()[pos])) return iterator(this, pos, typename Tree::iterator());
+    return end();
+}
+
+template<class Key, class Value, size_t InlineCapacity>
+Value& SmallAVLMap<Key, Value, InlineCapacity>::operator[](const Key& key)
+{
+    iterator it = find(key);
+    if (it == end()) throw std::out_of_range("Invalid key");
+    return it->second;
+}
+
+template<class Key, class Value, size_t InlineCapacity>
+Value const & SmallAVLMap<Key, Value, InlineCapacity>::operator[](const Key& key) const
+{
+    iterator it = find(key);
+    if (it == end()) throw std::out_of_range("Invalid key");
+    return it->second;
+}
+
+/*
+  -----------------------------------------------
+  End implementations for the SmallAVLMap class.
+  -----------------------------------------------
+*/
+
+#endif
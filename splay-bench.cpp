@@ -0,0 +1,75 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+#include "avlbst.h"
+#include "splaybst.h"
+
+using namespace std;
+
+// Builds n distinct keys in random order and a query stream in which the
+// rank-r key is drawn with probability proportional to 1/r^skew (skew 0 is
+// uniform).
+vector<int> makeQueries(const vector<int>& keys, size_t count, double skew, mt19937& rng)
+{
+    vector<double> cdf(keys.size());
+    double total = 0;
+    for (size_t r = 0; r < keys.size(); ++r) {
+        total += 1.0 / pow((double)(r + 1), skew);
+        cdf[r] = total;
+    }
+    uniform_real_distribution<double> dist(0, total);
+    vector<int> queries(count);
+    for (size_t i = 0; i < count; ++i) {
+        size_t r = lower_bound(cdf.begin(), cdf.end(), dist(rng)) - cdf.begin();
+        queries[i] = keys[min(r, keys.size() - 1)];
+    }
+    return queries;
+}
+
+template<class Tree>
+double lookupRate(Tree& tree, const vector<int>& queries)
+{
+    long long sink = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t i = 0; i < queries.size(); ++i) {
+        sink += tree.find(queries[i])->second;
+    }
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (sink == 42) cout << "";
+    return queries.size() / secs;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    size_t q = argc > 2 ? strtoul(argv[2], NULL, 10) : 2000000;
+    mt19937 rng(7);
+
+    vector<int> keys(n);
+    for (size_t i = 0; i < n; ++i) keys[i] = (int)(i * 2654435761u % 0x7fffffff);
+    shuffle(keys.begin(), keys.end(), rng);
+
+    AVLTree<int,int> avl;
+    SplayTree<int,int> splay;
+    for (size_t i = 0; i < n; ++i) {
+        avl.insert(make_pair(keys[i], (int)i));
+        splay.insert(make_pair(keys[i], (int)i));
+    }
+
+    double skews[] = { 0.0, 0.8, 1.0, 1.2 };
+    cout << n << " keys, " << q << " lookups per workload" << endl;
+    cout << setw(14) << "workload" << setw(16) << "AVL finds/sec" << setw(18) << "splay finds/sec" << endl;
+    for (size_t s = 0; s < sizeof(skews) / sizeof(skews[0]); ++s) {
+        vector<int> queries = makeQueries(keys, q, skews[s], rng);
+        double a = lookupRate(avl, queries);
+        double b = lookupRate(splay, queries);
+        cout << setw(14) << (skews[s] == 0.0 ? string("uniform") : "zipf " + to_string(skews[s]).substr(0, 3))
+             << setw(16) << (long long)a << setw(18) << (long long)b << endl;
+    }
+    return 0;
+}
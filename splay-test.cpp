@@ -0,0 +1,64 @@
+#include <iostream>
+#include <map>
+#include <cstdlib>
+#include "splaybst.h"
+#include "test-util.h"
+
+using namespace std;
+
+bool sameContents(SplayTree<int,int>& st, const map<int,int>& ref)
+{
+    map<int,int>::const_iterator r = ref.begin();
+    for (SplayTree<int,int>::iterator it = st.begin(); it != st.end(); ++it, ++r) {
+        if (r == ref.end() || it->first != r->first || it->second != r->second) return false;
+    }
+    return r == ref.end();
+}
+
+int main()
+{
+    SplayTree<char,int> small;
+    small.insert(make_pair('a', 1));
+    small.insert(make_pair('b', 2));
+    small.insert(make_pair('c', 3));
+    small.insert(make_pair('c', 7));
+    cout << "Splay Tree contents:" << endl;
+    for (SplayTree<char,int>::iterator it = small.begin(); it != small.end(); ++it) {
+        cout << it->first << " " << it->second << endl;
+    }
+    check(small.find('a') != small.end(), "find a");
+    small.print();
+    check(small['a'] == 1, "operator[] returns value");
+    small.remove('b');
+    check(small.find('b') == small.end(), "b removed");
+
+    SplayTree<int,int> st;
+    map<int,int> ref;
+    srand(42);
+    bool ok = true;
+    for (int i = 0; i < 20000; ++i) {
+        int key = rand() % 2000;
+        int op = rand() % 3;
+        if (op == 0) {
+            st.insert(make_pair(key, i));
+            ref[key] = i;
+        }
+        else if (op == 1) {
+            st.remove(key);
+            ref.erase(key);
+        }
+        else {
+            bool found = st.find(key) != st.end();
+            if (found != (ref.count(key) == 1)) ok = false;
+        }
+    }
+    check(ok, "random find agrees with std::map");
+    check(sameContents(st, ref), "random insert/remove agrees with std::map");
+
+    const SplayTree<int,int>& cst = st;
+    check(cst.find(ref.begin()->first) != cst.end(), "const find works without splaying");
+
+    st.clear();
+    check(st.empty(), "clear empties the tree");
+    return failures == 0 ? 0 : 1;
+}
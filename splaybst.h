@@ -0,0 +1,223 @@
+#ifndef SPLAYBST_H
+#define SPLAYBST_H
+
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+#include <cstdlib>
+#include "bst.h"
+
+/**
+* A self-adjusting binary search tree. Every access (insert, find, operator[]
+* and remove) rotates the touched node to the root, so recently and frequently
+* used keys sit near the top. Operations are O(log n) amortized and much faster
+* than that on skewed or temporally local access patterns.
+*
+* The tree uses the plain Node class since it keeps no balance information.
+* Note that find() and operator[] restructure the tree and are therefore not
+* const; looking keys up through a const reference falls back to the plain
+* BinarySearchTree search without splaying.
+*/
+template <class Key, class Value>
+class SplayTree : public BinarySearchTree<Key, Value>
+{
+public:
+    virtual void insert(const std::pair<const Key, Value>& keyValuePair);
+    virtual void remove(const Key& key);
+
+    typename BinarySearchTree<Key, Value>::iterator find(const Key& key);
+    Value& operator[](const Key& key);
+
+    using BinarySearchTree<Key, Value>::find;
+    using BinarySearchTree<Key, Value>::operator[];
+
+protected:
+    // Moves node up one level, making its parent its child.
+    void rotateUp(Node<Key, Value>* node);
+    // Moves node to the root with zig, zig-zig and zig-zag steps.
+    void splay(Node<Key, Value>* node);
+    // Descends towards key and splays the last node visited, which is the
+    // node holding key if it exists. Returns that node or NULL if not found.
+    Node<Key, Value>* splayFind(const Key& key);
+};
+
+/*
+  ---------------------------------------------
+  Begin implementations for the SplayTree class.
+  ---------------------------------------------
+*/
+
+template<class Key, class Value>
+void SplayTree<Key, Value>::rotateUp(Node<Key, Value>* node)
+{
+    Node<Key, Value>* parent = node->getParent();
+    Node<Key, Value>* grand = parent->getParent();
+
+    if (parent->getLeft() == node) {
+        //node's right subtree becomes parent's left subtree
+        parent->setLeft(node->getRight());
+        if (node->getRight() != NULL) node->getRight()->setParent(parent);
+        node->setRight(parent);
+    }
+    else {
+        parent->setRight(node->getLeft());
+        if (node->getLeft() != NULL) node->getLeft()->setParent(parent);
+        node->setLeft(parent);
+    }
+    parent->setParent(node);
+    node->setParent(grand);
+
+    if (grand == NULL) {
+        this->root_ = node;
+    }
+    else if (grand->getLeft() == parent) {
+        grand->setLeft(node);
+    }
+    else {
+        grand->setRight(node);
+    }
+}
+
+template<class Key, class Value>
+void SplayTree<Key, Value>::splay(Node<Key, Value>* node)
+{
+    while (node->getParent() != NULL) {
+        Node<Key, Value>* parent = node->getParent();
+        Node<Key, Value>* grand = parent->getParent();
+
+        //zig: parent is the root
+        if (grand == NULL) {
+            rotateUp(node);
+        }
+        //zig-zig: node and parent are both left or both right children
+        else if ((grand->getLeft() == parent) == (parent->getLeft() == node)) {
+            rotateUp(parent);
+            rotateUp(node);
+        }
+        //zig-zag
+        else {
+            rotateUp(node);
+            rotateUp(node);
+        }
+    }
+}
+
+template<class Key, class Value>
+Node<Key, Value>* SplayTree<Key, Value>::splayFind(const Key& key)
+{
+    Node<Key, Value>* temp = this->root_;
+    Node<Key, Value>* last = NULL;
+
+    while (temp != NULL) {
+        last = temp;
+        if (key < temp->getKey()) temp = temp->getLeft();
+        else if (temp->getKey() < key) temp = temp->getRight();
+        else break;
+    }
+
+    //splay even on a miss so the search path is shortened for next time
+    if (last != NULL) splay(last);
+    return temp;
+}
+
+/**
+* Inserts the pair, or overwrites the value if the key exists, and splays the
+* affected node to the root.
+*/
+template<class Key, class Value>
+void SplayTree<Key, Value>::insert(const std::pair<const Key, Value>& keyValuePair)
+{
+    Node<Key, Value>* temp = this->root_;
+    Node<Key, Value>* parent = NULL;
+
+    while (temp != NULL) {
+        if (keyValuePair.first < temp->getKey()) {
+            parent = temp;
+            temp = temp->getLeft();
+        }
+        else if (temp->getKey() < keyValuePair.first) {
+            parent = temp;
+            temp = temp->getRight();
+        }
+        else {
+            temp->setValue(keyValuePair.second);
+            splay(temp);
+            return;
+        }
+    }
+
+    Node<Key, Value>* nodeToAdd = new Node<Key, Value>(keyValuePair.first, keyValuePair.second, parent);
+    this->noteInserted(nodeToAdd);
+    if (parent == NULL) {
+        this->root_ = nodeToAdd;
+        return;
+    }
+    if (keyValuePair.first < parent->getKey()) parent->setLeft(nodeToAdd);
+    else parent->setRight(nodeToAdd);
+    splay(nodeToAdd);
+}
+
+/**
+* Splays the node to the root, then joins its two subtrees by splaying the
+* largest node of the left subtree to the top of that subtree and hanging the
+* right subtree off it.
+*/
+template<class Key, class Value>
+void SplayTree<Key, Value>::remove(const Key& key)
+{
+    Node<Key, Value>* toRemove = splayFind(key);
+    if (toRemove == NULL) return;
+    this->noteRemoving(toRemove);
+
+    Node<Key, Value>* left = toRemove->getLeft();
+    Node<Key, Value>* right = toRemove->getRight();
+    delete toRemove;
+
+    if (left == NULL) {
+        this->root_ = right;
+        if (right != NULL) right->setParent(NULL);
+        return;
+    }
+
+    //treat the left subtree as its own tree while splaying its maximum
+    left->setParent(NULL);
+    this->root_ = left;
+    Node<Key, Value>* largest = left;
+    while (largest->getRight() != NULL) largest = largest->getRight();
+    splay(largest);
+
+    largest->setRight(right);
+    if (right != NULL) right->setParent(largest);
+}
+
+/**
+* Returns an iterator to the item with the given key, or end() if absent.
+* The found node (or the last node on the search path) is splayed.
+*/
+template<class Key, class Value>
+typename BinarySearchTree<Key, Value>::iterator SplayTree<Key, Value>::find(const Key& key)
+{
+    Node<Key, Value>* found = splayFind(key);
+    if (found == NULL) return this->end();
+    return BinarySearchTree<Key, Value>::find(key);
+}
+
+/**
+ * @precondition The key exists in the map
+ * Returns the value associated with the key and splays its node.
+ */
+template<class Key, class Value>
+Value& SplayTree<Key, Value>::operator[](const Key& key)
+{
+    Node<Key, Value>* found = splayFind(key);
+    if (found == NULL) throw std::out_of_range("Invalid key");
+    return found->getValue();
+}
+
+/*
+  -------------------------------------------
+  End implementations for the SplayTree class.
+  -------------------------------------------
+*/
+
+#endif
@@ -0,0 +1,75 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include "avlbst.h"
+#include "split-tree.h"
+
+using namespace std;
+
+double msSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// 256 bytes of value per key.
+struct Payload {
+    long long words[32];
+};
+
+// The tree's print needs one.
+ostream& operator<<(ostream& out, const Payload& p)
+{
+    return out << p.words[0];
+}
+
+// Lookups that only test membership, and lookups that read one word of the value.
+template<class Tree>
+void lookups(const char* name, const Tree& tree, const vector<long long>& keys, size_t count)
+{
+    mt19937_64 rng(45);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    size_t hits = 0;
+    for (size_t i = 0; i < count; ++i) hits += tree.find(keys[rng() % keys.size()]) != tree.end();
+    double findMs = msSince(start);
+
+    start = chrono::steady_clock::now();
+    long long sum = 0;
+    for (size_t i = 0; i < count; ++i) sum += tree[keys[rng() % keys.size()]].words[7];
+    double readMs = msSince(start);
+
+    cout << fixed << setprecision(1);
+    cout << name << "find " << findMs << " ms (" << hits << " hits), find and read "
+         << readMs << " ms (sum " << sum << ")" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 200000;
+    size_t count = argc > 2 ? strtoul(argv[2], NULL, 10) : 2000000;
+
+    mt19937_64 rng(4545);
+    vector<long long> keys(n);
+    for (size_t i = 0; i < n; ++i) keys[i] = (long long)(rng() >> 1);
+    Payload p;
+    for (size_t w = 0; w < 32; ++w) p.words[w] = (long long)w;
+
+    cout << n << " keys with " << sizeof(Payload) << "-byte values, " << count << " lookups" << endl;
+    {
+        AVLTree<long long, Payload> inlined;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for (size_t i = 0; i < n; ++i) inlined.insert(make_pair(keys[i], p));
+        cout << "AVLTree insert:      " << fixed << setprecision(1) << msSince(start) << " ms" << endl;
+        lookups("AVLTree:             ", inlined, keys, count);
+    }
+    {
+        SplitAVLTree<long long, Payload> split;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for (size_t i = 0; i < n; ++i) split.insert(make_pair(keys[i], p));
+        cout << "SplitAVLTree insert: " << fixed << setprecision(1) << msSince(start) << " ms" << endl;
+        lookups("SplitAVLTree:        ", split, keys, count);
+    }
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include <iostream>
+#include <map>
+#include <string>
+#include <cstdlib>
+#include <stdexcept>
+#include "split-tree.h"
+#include "test-util.h"
+
+using namespace std;
+
+// A value that counts how many of itself are alive.
+static int liveValues = 0;
+
+struct Counted {
+    string text;
+    Counted(const string& t) : text(t) { ++liveValues; }
+    Counted(const Counted& other) : text(other.text) { ++liveValues; }
+    Counted& operator=(const Counted& other) { text = other.text; return *this; }
+    ~Counted() { --liveValues; }
+};
+
+bool sameContents(const SplitAVLTree<int, Counted>& tree, const map<int, string>& ref)
+{
+    if (tree.size() != ref.size()) return false;
+    map<int, string>::const_iterator r = ref.begin();
+    for (SplitAVLTree<int, Counted>::iterator it = tree.begin(); it != tree.end(); ++it, ++r) {
+        if (r == ref.end() || it.key() != r->first || it.value().text != r->second) return false;
+    }
+    return r == ref.end();
+}
+
+int main()
+{
+    {
+        SplitAVLTree<int, Counted> tree(16);
+        check(tree.empty() && tree.begin() == tree.end() && tree.find(1) == tree.end(), "empty tree");
+        bool threw = false;
+        try {
+            tree[1];
+        }
+        catch (const out_of_range&) {
+            threw = true;
+        }
+        check(threw, "operator[] throws for a missing key");
+
+        srand(45);
+        map<int, string> ref;
+        bool agree = true;
+        for (int step = 0; step < 20000; ++step) {
+            int key = rand() % 1000;
+            if (rand() % 3 == 0) {
+                tree.remove(key);
+                ref.erase(key);
+            }
+            else {
+                string text = to_string(step);
+                tree.insert(make_pair(key, Counted(text)));
+                ref[key] = text;
+            }
+            if (step % 500 == 0) agree = agree && sameContents(tree, ref) && tree.isBalanced();
+        }
+        check(agree && sameContents(tree, ref) && tree.isBalanced(), "random inserts and removes match std::map");
+        check(liveValues == (int)ref.size(), "every removed value is destroyed");
+
+        // values keep their slots while other keys come and go
+        int key = ref.begin()->first;
+        Counted* where = &tree[key];
+        for (int i = 1000; i < 3000; ++i) tree.insert(make_pair(i, Counted("x")));
+        for (int i = 1000; i < 3000; i += 2) tree.remove(i);
+        tree.insert(make_pair(key, Counted("overwritten")));
+        check(&tree[key] == where && where->text == "overwritten", "values stay put and are overwritten in place");
+        check(tree.contains(key) && !tree.contains(1000) && tree.contains(1001), "contains");
+
+        tree.clear();
+        check(tree.empty() && liveValues == 0, "clear destroys every value");
+        tree.insert(make_pair(7, Counted("again")));
+        check(tree.size() == 1 && tree[7].text == "again", "reusable after clear");
+    }
+    check(liveValues == 0, "destructor destroys every value");
+
+    return failures == 0 ? 0 : 1;
+}
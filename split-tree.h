@@ -0,0 +1,357 @@
+#ifndef SPLIT_TREE_H
+#define SPLIT_TREE_H
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+#include <stdexcept>
+#include <type_traits>
+#include "avlbst.h"
+#include "sharded-map.h"
+
+/**
+* A free-list pool of Values, carved out of fixed-size slabs like
+* AVLNodePool. A slot keeps its address until it is released.
+*/
+template <typename Value>
+class ValueArena
+{
+public:
+    explicit ValueArena(size_t slabValues = 256);
+    ~ValueArena();
+
+    // Constructs a copy of value in a free slot.
+    Value* create(const Value& value);
+    void destroy(Value* value);
+
+private:
+    ValueArena(const ValueArena&);
+    ValueArena& operator=(const ValueArena&);
+
+    union Slot {
+        Slot* next;
+        typename std::aligned_storage<sizeof(Value), alignof(Value)>::type storage;
+    };
+
+    std::vector<Slot*> slabs_;
+    Slot* free_;
+    size_t slabValues_;
+};
+
+/**
+* An AVL map laid out for lookups over large values. The tree's nodes hold
+* the key, the links and a pointer to the value; the values themselves live
+* in a ValueArena of their own. A descent reads one small node per level
+* instead of dragging each level's value bytes through the cache with it,
+* and the nodes come from a pool, so they sit packed together too.
+*
+* Values stay where they are for as long as their key is in the map, so
+* references from value() and operator[] survive other inserts and removes.
+* Lookups of small values gain nothing from the extra indirection; use
+* AVLTree for those.
+*/
+template <typename Key, typename Value>
+class SplitAVLTree
+{
+public:
+    explicit SplitAVLTree(size_t slabValues = 256);
+    ~SplitAVLTree();
+
+    // Overwrites the value in place if key is already present.
+    void insert(const std::pair<const Key, Value>& keyValuePair);
+    void remove(const Key& key);
+    void clear();
+    bool empty() const;
+    size_t size() const;
+    bool isBalanced() const;
+    bool contains(const Key& key) const;
+
+    /**
+    * An in-order iterator. There is no pair to point at, so the key and
+    * value are reached through key() and value().
+    */
+    class iterator
+    {
+    public:
+        iterator();
+
+        const Key& key() const;
+        Value& value() const;
+
+        bool operator==(const iterator& rhs) const;
+        bool operator!=(const iterator& rhs) const;
+
+        iterator& operator++();
+
+    protected:
+        friend class SplitAVLTree<Key, Value>;
+        explicit iterator(const typename AVLTree<Key, Value*>::iterator& it);
+        typename AVLTree<Key, Value*>::iterator it_;
+    };
+
+    iterator begin() const;
+    iterator end() const;
+    iterator find(const Key& key) const;
+    Value& operator[](const Key& key);
+    Value const & operator[](const Key& key) const;
+
+protected:
+    PooledAVLTree<Key, Value*> tree_;
+    ValueArena<Value> values_;
+    size_t size_;
+
+private:
+    SplitAVLTree(const SplitAVLTree&);
+    SplitAVLTree& operator=(const SplitAVLTree&);
+};
+
+/*
+  ---------------------------------------------
+  Begin implementations for the ValueArena class.
+  ---------------------------------------------
+*/
+
+template<class Value>
+ValueArena<Value>::ValueArena(size_t slabValues) :
+    free_(NULL),
+    slabValues_(slabValues == 0 ? 1 : slabValues)
+{
+
+}
+
+/**
+* Only releases the slabs; the owner destroys the values still live.
+*/
+template<class Value>
+ValueArena<Value>::~ValueArena()
+{
+    for (size_t i = 0; i < slabs_.size(); ++i) {
+        delete [] slabs_[i];
+    }
+}
+
+template<class Value>
+Value* ValueArena<Value>::create(const Value& value)
+{
+    if (free_ == NULL) {
+        Slot* slab = new Slot[slabValues_];
+        slabs_.push_back(slab);
+        for (size_t i = slabValues_; i > 0; --i) {
+            slab[i - 1].next = free_;
+            free_ = &slab[i - 1];
+        }
+    }
+    Slot* slot = free_;
+    Slot* next = slot->next;
+    //constructing the value overwrites the link, so the slot is unlinked only once that succeeded
+    Value* v = new (&slot->storage) Value(value);
+    free_ = next;
+    return v;
+}
+
+template<class Value>
+void ValueArena<Value>::destroy(Value* value)
+{
+    value->~Value();
+    Slot* s = reinterpret_cast<Slot*>(value);
+    s->next = free_;
+    free_ = s;
+}
+
+/*
+  -------------------------------------------
+  End implementations for the ValueArena class.
+  -------------------------------------------
+*/
+
+/*
+  -----------------------------------------------------------
+  Begin implementations for the SplitAVLTree::iterator class.
+  -----------------------------------------------------------
+*/
+
+template<class Key, class Value>
+SplitAVLTree<Key, Value>::iterator::iterator() :
+    it_()
+{
+
+}
+
+template<class Key, class Value>
+SplitAVLTree<Key, Value>::iterator::iterator(const typename AVLTree<Key, Value*>::iterator& it) :
+    it_(it)
+{
+
+}
+
+template<class Key, class Value>
+const Key& SplitAVLTree<Key, Value>::iterator::key() const
+{
+    return it_->first;
+}
+
+template<class Key, class Value>
+Value& SplitAVLTree<Key, Value>::iterator::value() const
+{
+    return *it_->second;
+}
+
+template<class Key, class Value>
+bool SplitAVLTree<Key, Value>::iterator::operator==(const iterator& rhs) const
+{
+    return it_ == rhs.it_;
+}
+
+template<class Key, class Value>
+bool SplitAVLTree<Key, Value>::iterator::operator!=(const iterator& rhs) const
+{
+    return it_ != rhs.it_;
+}
+
+template<class Key, class Value>
+typename SplitAVLTree<Key, Value>::iterator& SplitAVLTree<Key, Value>::iterator::operator++()
+{
+    ++it_;
+    return *this;
+}
+
+/*
+  ---------------------------------------------------------
+  End implementations for the SplitAVLTree::iterator class.
+  ---------------------------------------------------------
+*/
+
+/*
+  -------------------------------------------------
+  Begin implementations for the SplitAVLTree class.
+  -------------------------------------------------
+*/
+
+template<class Key, class Value>
+SplitAVLTree<Key, Value>::SplitAVLTree(size_t slabValues) :
+    values_(slabValues), size_(0)
+{
+
+}
+
+template<class Key, class Value>
+SplitAVLTree<Key, Value>::~SplitAVLTree()
+{
+    clear();
+}
+
+/**
+* A new key is linked with no value first, so the tree is searched once
+* whether the key is new or not.
+*/
+template<class Key, class Value>
+void SplitAVLTree<Key, Value>::insert(const std::pair<const Key, Value>& keyValuePair)
+{
+    std::pair<typename AVLTree<Key, Value*>::iterator, bool> result =
+        tree_.tryInsert(std::make_pair(keyValuePair.first, (Value*)NULL));
+    if (!result.second) {
+        *result.first->second = keyValuePair.second;
+        return;
+    }
+    try {
+        result.first->second = values_.create(keyValuePair.second);
+    }
+    catch (...) {
+        tree_.extract(result.first);
+        throw;
+    }
+    ++size_;
+}
+
+/**
+* extract takes the node found by the lookup, so the tree is searched once.
+*/
+template<class Key, class Value>
+void SplitAVLTree<Key, Value>::remove(const Key& key)
+{
+    typename AVLTree<Key, Value*>::iterator it = tree_.find(key);
+    if (it == tree_.end()) return;
+    values_.destroy(it->second);
+    tree_.extract(it);
+    --size_;
+}
+
+template<class Key, class Value>
+void SplitAVLTree<Key, Value>::clear()
+{
+    for (typename AVLTree<Key, Value*>::iterator it = tree_.begin(); it != tree_.end(); ++it) {
+        values_.destroy(it->second);
+    }
+    tree_.clear();
+    size_ = 0;
+}
+
+template<class Key, class Value>
+bool SplitAVLTree<Key, Value>::empty() const
+{
+    return size_ == 0;
+}
+
+template<class Key, class Value>
+size_t SplitAVLTree<Key, Value>::size() const
+{
+    return size_;
+}
+
+template<class Key, class Value>
+bool SplitAVLTree<Key, Value>::isBalanced() const
+{
+    return tree_.isBalanced();
+}
+
+/**
+* Never touches a value.
+*/
+template<class Key, class Value>
+bool SplitAVLTree<Key, Value>::contains(const Key& key) const
+{
+    return tree_.find(key) != tree_.end();
+}
+
+template<class Key, class Value>
+typename SplitAVLTree<Key, Value>::iterator SplitAVLTree<Key, Value>::begin() const
+{
+    return iterator(tree_.begin());
+}
+
+template<class Key, class Value>
+typename SplitAVLTree<Key, Value>::iterator SplitAVLTree<Key, Value>::end() const
+{
+    return iterator(tree_.end());
+}
+
+template<class Key, class Value>
+typename SplitAVLTree<Key, Value>::iterator SplitAVLTree<Key, Value>::find(const Key& key) const
+{
+    return iterator(tree_.find(key));
+}
+
+template<class Key, class Value>
+Value& SplitAVLTree<Key, Value>::operator[](const Key& key)
+{
+    typename AVLTree<Key, Value*>::iterator it = tree_.find(key);
+    if (it == tree_.end()) throw std::out_of_range("Invalid key");
+    return *it->second;
+}
+
+template<class Key, class Value>
+Value const & SplitAVLTree<Key, Value>::operator[](const Key& key) const
+{
+    typename AVLTree<Key, Value*>::iterator it = tree_.find(key);
+    if (it == tree_.end()) throw std::out_of_range("Invalid key");
+    return *it->second;
+}
+
+/*
+  -----------------------------------------------
+  End implementations for the SplitAVLTree class.
+  -----------------------------------------------
+*/
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+#include <iostream>
+#include <string>
+
+/**
+* The check harness shared by the *-test programs. Each test is a single
+* translation unit, so the counter lives here; main returns nonzero if any
+* check failed.
+*/
+static int failures = 0;
+
+// Prints PASS or FAIL with msg, counting failures.
+static void check(bool cond, const std::string& msg)
+{
+    std::cout << (cond ? "PASS: " : "FAIL: ") << msg << std::endl;
+    if (!cond) ++failures;
+}
+
+#endif
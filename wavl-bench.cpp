@@ -0,0 +1,93 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include "avlbst.h"
+#include "wavlbst.h"
+
+using namespace std;
+
+// Subclasses that count every rotation the balancing code performs.
+template<class Key, class Value>
+class CountingAVLTree : public AVLTree<Key, Value>
+{
+public:
+    CountingAVLTree() : rotations(0) { }
+    long long rotations;
+protected:
+    virtual void rotateRight(AVLNode<Key,Value>* node) { ++rotations; AVLTree<Key, Value>::rotateRight(node); }
+    virtual void rotateLeft(AVLNode<Key,Value>* node) { ++rotations; AVLTree<Key, Value>::rotateLeft(node); }
+};
+
+template<class Key, class Value>
+class CountingWAVLTree : public WAVLTree<Key, Value>
+{
+public:
+    CountingWAVLTree() : rotations(0) { }
+    long long rotations;
+protected:
+    virtual void rotateRight(WAVLNode<Key,Value>* node) { ++rotations; WAVLTree<Key, Value>::rotateRight(node); }
+    virtual void rotateLeft(WAVLNode<Key,Value>* node) { ++rotations; WAVLTree<Key, Value>::rotateLeft(node); }
+};
+
+struct Result {
+    double insertRot, removeRot, nsPerOp;
+};
+
+// Queue-style churn: the tree holds about n keys; each step enqueues a new
+// (mostly increasing) key and dequeues either the oldest or a random live key.
+template<class Tree>
+Result churn(size_t n, size_t steps, unsigned seed)
+{
+    Tree tree;
+    mt19937 rng(seed);
+    vector<int> live;
+    int next = 0;
+    for (size_t i = 0; i < n; ++i) {
+        tree.insert(make_pair(next, next));
+        live.push_back(next++);
+    }
+    tree.rotations = 0;
+
+    long long insertRot = 0, removeRot = 0;
+    size_t head = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t i = 0; i < steps; ++i) {
+        long long before = tree.rotations;
+        int key = next++ + (int)(rng() % 64);
+        tree.insert(make_pair(key, key));
+        live.push_back(key);
+        insertRot += tree.rotations - before;
+
+        before = tree.rotations;
+        size_t victim = (rng() % 4 == 0) ? head + rng() % (live.size() - head) : head;
+        swap(live[victim], live[head]);
+        tree.remove(live[head++]);
+        removeRot += tree.rotations - before;
+    }
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    Result r;
+    r.insertRot = (double)insertRot / steps;
+    r.removeRot = (double)removeRot / steps;
+    r.nsPerOp = secs * 1e9 / (2 * steps);
+    return r;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 200000;
+    size_t steps = argc > 2 ? strtoul(argv[2], NULL, 10) : 1000000;
+
+    Result avl = churn<CountingAVLTree<int,int> >(n, steps, 3);
+    Result wavl = churn<CountingWAVLTree<int,int> >(n, steps, 3);
+
+    cout << n << " live keys, " << steps << " insert+delete steps" << endl;
+    cout << setw(8) << "tree" << setw(18) << "rot/insert" << setw(18) << "rot/delete" << setw(12) << "ns/op" << endl;
+    cout << fixed << setprecision(3);
+    cout << setw(8) << "AVL" << setw(18) << avl.insertRot << setw(18) << avl.removeRot << setw(12) << avl.nsPerOp << endl;
+    cout << setw(8) << "WAVL" << setw(18) << wavl.insertRot << setw(18) << wavl.removeRot << setw(12) << wavl.nsPerOp << endl;
+    return 0;
+}
@@ -0,0 +1,58 @@
+#include <iostream>
+#include <map>
+#include <cstdlib>
+#include "wavlbst.h"
+#include "test-util.h"
+
+using namespace std;
+
+bool sameContents(const WAVLTree<int,int>& wt, const map<int,int>& ref)
+{
+    map<int,int>::const_iterator r = ref.begin();
+    for (WAVLTree<int,int>::iterator it = wt.begin(); it != wt.end(); ++it, ++r) {
+        if (r == ref.end() || it->first != r->first || it->second != r->second) return false;
+    }
+    return r == ref.end();
+}
+
+int main()
+{
+    WAVLTree<char,int> small;
+    small.insert(make_pair('a', 1));
+    small.insert(make_pair('b', 2));
+    small.insert(make_pair('c', 3));
+    small.insert(make_pair('c', 7));
+    small.print();
+    check(small.isBalanced() && small.isRankBalanced(), "ascending inserts rotate like AVL");
+    check(small['c'] == 7, "insert overwrites value");
+    small.remove('b');
+    check(small.find('b') == small.end() && small.isRankBalanced(), "remove root");
+
+    WAVLTree<int,int> wt;
+    map<int,int> ref;
+    srand(17);
+    bool ranks = true;
+    for (int i = 0; i < 50000; ++i) {
+        int key = rand() % 3000;
+        if (rand() % 5 < 2) {
+            wt.insert(make_pair(key, i));
+            ref[key] = i;
+        }
+        else {
+            wt.remove(key);
+            ref.erase(key);
+        }
+        if (i % 97 == 0 && !wt.isRankBalanced()) ranks = false;
+    }
+    check(ranks, "rank rule holds through delete-heavy churn");
+    check(sameContents(wt, ref), "random insert/remove agrees with std::map");
+
+    for (int i = 0; i < 3000; ++i) wt.insert(make_pair(i, i));
+    check(wt.isBalanced(), "insert-only phase keeps AVL height balance");
+    for (int i = 0; i < 3000; i += 2) wt.remove(i);
+    check(wt.isRankBalanced(), "rank rule holds after bulk removals");
+
+    wt.clear();
+    check(wt.empty(), "clear empties the tree");
+    return failures == 0 ? 0 : 1;
+}
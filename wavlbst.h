@@ -0,0 +1,396 @@
+#ifndef WAVLBST_H
+#define WAVLBST_H
+
+#include <iostream>
+#include <exception>
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+#include "bst.h"
+
+/**
+* A node for a weak AVL (WAVL) tree, which stores a rank instead of a balance.
+* A missing child has rank -1. The rank difference of a child is its parent's
+* rank minus its own; in a valid tree every rank difference is 1 or 2 and every
+* leaf has rank 0.
+*/
+template <typename Key, typename Value>
+class WAVLNode : public Node<Key, Value>
+{
+public:
+    WAVLNode(const Key& key, const Value& value, WAVLNode<Key, Value>* parent);
+    virtual ~WAVLNode();
+
+    int8_t getRank() const;
+    void setRank(int8_t rank);
+    void promote();
+    void demote();
+
+    virtual WAVLNode<Key, Value>* getParent() const override;
+    virtual WAVLNode<Key, Value>* getLeft() const override;
+    virtual WAVLNode<Key, Value>* getRight() const override;
+
+protected:
+    int8_t rank_;
+};
+
+/*
+  -------------------------------------------------
+  Begin implementations for the WAVLNode class.
+  -------------------------------------------------
+*/
+
+/**
+* New nodes are leaves, so they start with rank 0.
+*/
+template<class Key, class Value>
+WAVLNode<Key, Value>::WAVLNode(const Key& key, const Value& value, WAVLNode<Key, Value>* parent) :
+    Node<Key, Value>(key, value, parent), rank_(0)
+{
+
+}
+
+template<class Key, class Value>
+WAVLNode<Key, Value>::~WAVLNode()
+{
+
+}
+
+template<class Key, class Value>
+int8_t WAVLNode<Key, Value>::getRank() const
+{
+    return rank_;
+}
+
+template<class Key, class Value>
+void WAVLNode<Key, Value>::setRank(int8_t rank)
+{
+    rank_ = rank;
+}
+
+template<class Key, class Value>
+void WAVLNode<Key, Value>::promote()
+{
+    ++rank_;
+}
+
+template<class Key, class Value>
+void WAVLNode<Key, Value>::demote()
+{
+    --rank_;
+}
+
+template<class Key, class Value>
+WAVLNode<Key, Value> *WAVLNode<Key, Value>::getParent() const
+{
+    return static_cast<WAVLNode<Key, Value>*>(this->parent_);
+}
+
+template<class Key, class Value>
+WAVLNode<Key, Value> *WAVLNode<Key, Value>::getLeft() const
+{
+    return static_cast<WAVLNode<Key, Value>*>(this->left_);
+}
+
+template<class Key, class Value>
+WAVLNode<Key, Value> *WAVLNode<Key, Value>::getRight() const
+{
+    return static_cast<WAVLNode<Key, Value>*>(this->right_);
+}
+
+/*
+  -----------------------------------------------
+  End implementations for the WAVLNode class.
+  -----------------------------------------------
+*/
+
+/**
+* A weak AVL tree (Haeupler, Sen and Tarjan). Insertions rebalance exactly like
+* an AVL tree, but deletions never need more than two rotations: instead of
+* restoring AVL height balance all the way up, a deletion may leave 2,2 nodes
+* behind. Without deletions the tree is an AVL tree; with them its height is
+* still at most 2 log n.
+*/
+template <class Key, class Value>
+class WAVLTree : public BinarySearchTree<Key, Value>
+{
+public:
+    virtual void insert(const std::pair<const Key, Value> &new_item);
+    virtual void remove(const Key& key);
+
+    // Returns true iff every rank difference is 1 or 2 and every leaf has rank 0.
+    bool isRankBalanced() const;
+
+protected:
+    virtual void nodeSwap(WAVLNode<Key,Value>* n1, WAVLNode<Key,Value>* n2);
+
+    virtual void insertFix(WAVLNode<Key,Value>* n);
+    virtual void removeFix(WAVLNode<Key,Value>* p, WAVLNode<Key,Value>* n);
+    virtual void rotateRight(WAVLNode<Key,Value>* node);
+    virtual void rotateLeft(WAVLNode<Key,Value>* node);
+
+    static int rank(const WAVLNode<Key,Value>* node);
+    // A node's rank is at least its height minus one and at most twice that.
+    virtual int heightEstimate(Node<Key,Value>* n) const;
+    bool isRankBalancedHelper(WAVLNode<Key,Value>* node) const;
+};
+
+/*
+  -------------------------------------------------
+  Begin implementations for the WAVLTree class.
+  -------------------------------------------------
+*/
+
+template<class Key, class Value>
+int WAVLTree<Key, Value>::rank(const WAVLNode<Key,Value>* node)
+{
+    return node == NULL ? -1 : node->getRank();
+}
+
+/*
+ * If key is already in the tree, the current value is overwritten.
+ */
+template<class Key, class Value>
+void WAVLTree<Key, Value>::insert(const std::pair<const Key, Value> &new_item)
+{
+    WAVLNode<Key, Value>* temp = static_cast<WAVLNode<Key, Value>*>(this->root_);
+    WAVLNode<Key, Value>* p = NULL;
+    while (temp != NULL) {
+        p = temp;
+        if (new_item.first < temp->getKey()) temp = temp->getLeft();
+        else if (temp->getKey() < new_item.first) temp = temp->getRight();
+        else {
+            temp->setValue(new_item.second);
+            return;
+        }
+    }
+
+    WAVLNode<Key, Value>* nodeToAdd = new WAVLNode<Key, Value>(new_item.first, new_item.second, p);
+    this->noteInserted(nodeToAdd);
+    if (p == NULL) {
+        this->root_ = nodeToAdd;
+        return;
+    }
+    if (new_item.first < p->getKey()) p->setLeft(nodeToAdd);
+    else p->setRight(nodeToAdd);
+
+    //only a parent that was a leaf now has a 0-child
+    if (p->getRank() == 0) insertFix(nodeToAdd);
+}
+
+/*
+ * Nodes with two children are swapped with their predecessor first, as in
+ * the other trees, so the node unlinked always has at most one child.
+ */
+template<class Key, class Value>
+void WAVLTree<Key, Value>::remove(const Key& key)
+{
+    WAVLNode<Key, Value>* toRemove = static_cast<WAVLNode<Key, Value>*>(this->internalFind(key));
+    if (toRemove == NULL) return;
+    this->noteRemoving(toRemove);
+
+    if (toRemove->getLeft() != NULL && toRemove->getRight() != NULL) {
+        WAVLNode<Key, Value>* pred = static_cast<WAVLNode<Key, Value>*>(this->predecessor(toRemove));
+        nodeSwap(toRemove, pred);
+    }
+
+    WAVLNode<Key, Value>* p = toRemove->getParent();
+    WAVLNode<Key, Value>* child = toRemove->getLeft() != NULL ? toRemove->getLeft() : toRemove->getRight();
+    if (child != NULL) child->setParent(p);
+    if (p == NULL) this->root_ = child;
+    else if (p->getLeft() == toRemove) p->setLeft(child);
+    else p->setRight(child);
+    delete toRemove;
+
+    removeFix(p, child);
+}
+
+template<class Key, class Value>
+void WAVLTree<Key, Value>::nodeSwap(WAVLNode<Key,Value>* n1, WAVLNode<Key,Value>* n2)
+{
+    BinarySearchTree<Key, Value>::nodeSwap(n1, n2);
+    int8_t tempR = n1->getRank();
+    n1->setRank(n2->getRank());
+    n2->setRank(tempR);
+}
+
+/**
+* Restores the rank rule after n became a 0-child of its parent. Promotes up
+* the tree while the sibling is a 1-child, then finishes with at most one
+* single or double rotation.
+*/
+template<class Key, class Value>
+void WAVLTree<Key, Value>::insertFix(WAVLNode<Key,Value>* n)
+{
+    WAVLNode<Key, Value>* p = n->getParent();
+    while (p != NULL && rank(p) == rank(n)) {
+        bool nIsLeft = (p->getLeft() == n);
+        WAVLNode<Key, Value>* s = nIsLeft ? p->getRight() : p->getLeft();
+
+        //p is 0,1: promote and move up
+        if (rank(p) - rank(s) == 1) {
+            p->promote();
+            n = p;
+            p = n->getParent();
+            continue;
+        }
+
+        //p is 0,2: rotate. y is n's inner child
+        WAVLNode<Key, Value>* y = nIsLeft ? n->getRight() : n->getLeft();
+        if (y == NULL || rank(n) - rank(y) == 2) {
+            if (nIsLeft) rotateRight(p);
+            else rotateLeft(p);
+            p->demote();
+        }
+        else {
+            if (nIsLeft) {
+                rotateLeft(n);
+                rotateRight(p);
+            }
+            else {
+                rotateRight(n);
+                rotateLeft(p);
+            }
+            y->promote();
+            n->demote();
+            p->demote();
+        }
+        return;
+    }
+}
+
+/**
+* Restores the rank rule after a node was unlinked below p, leaving n (which
+* may be NULL) in its place. Demotes up the tree while that suffices, then
+* finishes with at most one single or double rotation.
+*/
+template<class Key, class Value>
+void WAVLTree<Key, Value>::removeFix(WAVLNode<Key,Value>* p, WAVLNode<Key,Value>* n)
+{
+    if (p == NULL) return;
+
+    //a 2,2 leaf must drop to rank 0, which can make it a 3-child
+    if (p->getLeft() == NULL && p->getRight() == NULL && p->getRank() == 1) {
+        p->demote();
+        n = p;
+        p = n->getParent();
+    }
+
+    while (p != NULL && rank(p) - rank(n) == 3) {
+        bool nIsLeft = (p->getLeft() == n);
+        WAVLNode<Key, Value>* y = nIsLeft ? p->getRight() : p->getLeft();
+
+        //sibling is a 2-child: demote p and move up
+        if (rank(p) - rank(y) == 2) {
+            p->demote();
+            n = p;
+            p = n->getParent();
+            continue;
+        }
+
+        //sibling is a 1-child and 2,2: demote both and move up
+        if (rank(y) - rank(y->getLeft()) == 2 && rank(y) - rank(y->getRight()) == 2) {
+            p->demote();
+            y->demote();
+            n = p;
+            p = n->getParent();
+            continue;
+        }
+
+        //rotate. v is y's outer child and w its inner child
+        WAVLNode<Key, Value>* v = nIsLeft ? y->getRight() : y->getLeft();
+        WAVLNode<Key, Value>* w = nIsLeft ? y->getLeft() : y->getRight();
+        if (rank(y) - rank(v) == 1) {
+            if (nIsLeft) rotateLeft(p);
+            else rotateRight(p);
+            y->promote();
+            p->demote();
+            if (p->getLeft() == NULL && p->getRight() == NULL) p->demote();
+        }
+        else {
+            if (nIsLeft) {
+                rotateRight(y);
+                rotateLeft(p);
+            }
+            else {
+                rotateLeft(y);
+                rotateRight(p);
+            }
+            w->promote();
+            w->promote();
+            y->demote();
+            p->demote();
+            p->demote();
+        }
+        return;
+    }
+}
+
+//helper to rotate right: node's left child takes its place
+template<class Key, class Value>
+void WAVLTree<Key, Value>::rotateRight(WAVLNode<Key,Value>* node)
+{
+    WAVLNode<Key, Value>* parent = node->getParent();
+    WAVLNode<Key, Value>* left = node->getLeft();
+
+    node->setLeft(left->getRight());
+    if (left->getRight() != NULL) left->getRight()->setParent(node);
+
+    left->setParent(parent);
+    if (parent == NULL) this->root_ = left;
+    else if (parent->getLeft() == node) parent->setLeft(left);
+    else parent->setRight(left);
+
+    left->setRight(node);
+    node->setParent(left);
+}
+
+//helper to rotate left: node's right child takes its place
+template<class Key, class Value>
+void WAVLTree<Key, Value>::rotateLeft(WAVLNode<Key,Value>* node)
+{
+    WAVLNode<Key, Value>* parent = node->getParent();
+    WAVLNode<Key, Value>* right = node->getRight();
+
+    node->setRight(right->getLeft());
+    if (right->getLeft() != NULL) right->getLeft()->setParent(node);
+
+    right->setParent(parent);
+    if (parent == NULL) this->root_ = right;
+    else if (parent->getLeft() == node) parent->setLeft(right);
+    else parent->setRight(right);
+
+    right->setLeft(node);
+    node->setParent(right);
+}
+
+template<class Key, class Value>
+int WAVLTree<Key, Value>::heightEstimate(Node<Key, Value>* n) const
+{
+    return rank(static_cast<WAVLNode<Key, Value>*>(n)) + 1;
+}
+
+template<class Key, class Value>
+bool WAVLTree<Key, Value>::isRankBalanced() const
+{
+    return isRankBalancedHelper(static_cast<WAVLNode<Key, Value>*>(this->root_));
+}
+
+template<class Key, class Value>
+bool WAVLTree<Key, Value>::isRankBalancedHelper(WAVLNode<Key,Value>* node) const
+{
+    if (node == NULL) return true;
+    int left = rank(node) - rank(node->getLeft());
+    int right = rank(node) - rank(node->getRight());
+    if (left < 1 || left > 2 || right < 1 || right > 2) return false;
+    if (node->getLeft() == NULL && node->getRight() == NULL && rank(node) != 0) return false;
+    return isRankBalancedHelper(node->getLeft()) && isRankBalancedHelper(node->getRight());
+}
+
+/*
+  -----------------------------------------------
+  End implementations for the WAVLTree class.
+  -----------------------------------------------
+*/
+
+#endif